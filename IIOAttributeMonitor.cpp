@@ -0,0 +1,294 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Poco/Error.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "IIOSupport.hpp"
+#include "IIOConfig.hpp"
+#include "IIODeviceCache.hpp"
+
+#include <json.hpp>
+using json = nlohmann::json;
+
+/***********************************************************************
+ * |PothosDoc IIO Attribute Monitor
+ *
+ * The IIO attribute monitor periodically reads a set of device and channel
+ * attributes and emits them as messages, e.g. for temperature or RSSI
+ * telemetry. The attributes are read on a dedicated polling thread, so that
+ * slow sysfs reads never stall the work() of streaming blocks or of this
+ * block's own actor.
+ *
+ * Each message on the "values" port is a dictionary with the keys
+ * "timeNs" (the host time of the read in nanoseconds since the epoch),
+ * "deviceId" and "values" (a dictionary of attribute name to value string).
+ * Attributes that fail to read are reported with an empty value.
+ *
+ * |category /IIO
+ * |category /Sources
+ * |keywords iio industrial io telemetry temperature rssi probe poll
+ *
+ * |param deviceId[Device ID] The ID of an IIO device on the system.
+ * |default ""
+ *
+ * |param attributes[Attributes] The attributes to poll. Device attributes
+ * are specified by name, and channel attributes as "channelId/name", where
+ * the channel ID may be prefixed with "in:" or "out:" to pick the input or
+ * output channel of a device where both have the same ID.
+ * |default []
+ *
+ * |param period[Period] The polling period in seconds.
+ * |units seconds
+ * |default 1.0
+ * |preview enable
+ *
+ * |factory /iio/attribute_monitor(deviceId, attributes)
+ * |setter setPeriod(period)
+ **********************************************************************/
+class IIOAttributeMonitor : public Pothos::Block
+{
+private:
+    static const size_t maxQueuedSamples = 1024;
+
+    struct Sample
+    {
+        long long timeNs;
+        std::vector<std::string> values;
+    };
+
+    std::string deviceId;
+    std::vector<std::string> names;
+    std::vector<std::function<std::string(void)>> readers;
+    std::atomic<long long> periodNs;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<Sample> samples;
+    bool running;
+
+public:
+    IIOAttributeMonitor(const std::string &deviceId, const std::vector<std::string> &attributes)
+        : deviceId(deviceId), periodNs(1000000000), running(false)
+    {
+        //expose overlay hook
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOAttributeMonitor, overlay));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOAttributeMonitor, setPeriod));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOAttributeMonitor, getPeriod));
+        this->setupOutput("values");
+
+        //if deviceId is blank, create a partial object that exposes the
+        //overlay hook for the gui but cannot be activated
+        if (deviceId == "") {
+            return;
+        }
+
+        //find iio device
+        IIOContext& ctx = IIOContext::get();
+        std::unique_ptr<IIODevice> dev;
+        for (auto d : ctx.devices())
+        {
+            if (d.id() == deviceId)
+            {
+                dev = std::unique_ptr<IIODevice>(new IIODevice(d));
+                break;
+            }
+        }
+        if (!dev)
+        {
+            throw Pothos::SystemException("IIOAttributeMonitor::IIOAttributeMonitor()", "device not found");
+        }
+
+        //resolve every attribute once, so the polling loop only reads
+        const auto channels = dev->channels();
+        for (const auto &spec : attributes)
+        {
+            const auto w = iioResolveAttribute(*dev, channels, spec);
+            if (!w.read)
+            {
+                throw Pothos::NotFoundException("IIOAttributeMonitor::IIOAttributeMonitor()", "attribute not found: " + spec);
+            }
+            this->readers.push_back(w.read);
+            this->names.push_back(spec);
+        }
+    }
+
+    ~IIOAttributeMonitor(void)
+    {
+        this->stopThread();
+    }
+
+    std::string overlay(void) const
+    {
+        json topObj;
+        auto &params = topObj["params"];
+
+        //configure deviceId dropdown options
+        json deviceIdParam;
+        deviceIdParam["key"] = "deviceId";
+        auto &deviceIdOpts = deviceIdParam["options"];
+        deviceIdParam["widgetKwargs"]["editable"] = false;
+        deviceIdParam["widgetType"] = "DropDown";
+
+        //add empty device option associated
+        json emptyOption;
+        emptyOption["name"] = "";
+        emptyOption["value"] = "\"\"";
+        deviceIdOpts.push_back(emptyOption);
+
+        //enumerate iio devices
+        for (const auto &d : IIODeviceCache::get().devices())
+        {
+            json option;
+            option["name"] = d.second + " (" + d.first + ")";
+            option["value"] = "\"" + d.first + "\"";
+            deviceIdOpts.push_back(option);
+        }
+        params.push_back(deviceIdParam);
+
+        return topObj.dump();
+    }
+
+    static Block *make(const std::string &deviceId, const std::vector<std::string> &attributes)
+    {
+        return new IIOAttributeMonitor(deviceId, attributes);
+    }
+
+    void setPeriod(const double period)
+    {
+        if (period <= 0.0)
+        {
+            throw Pothos::InvalidArgumentException("IIOAttributeMonitor::setPeriod()", "period must be positive");
+        }
+        //under the lock, so that the poll thread cannot miss the wakeup
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->periodNs = static_cast<long long>(period*1e9);
+        }
+        this->cond.notify_all();
+    }
+
+    double getPeriod(void) const
+    {
+        return this->periodNs/1e9;
+    }
+
+    void activate(void)
+    {
+        if (this->deviceId == "")
+        {
+            throw Pothos::SystemException("IIOAttributeMonitor::activate()", "no device specified");
+        }
+
+        this->running = true;
+        this->thread = std::thread(&IIOAttributeMonitor::pollLoop, this);
+    }
+
+    void deactivate(void)
+    {
+        this->stopThread();
+    }
+
+    void work(void)
+    {
+        std::deque<Sample> ready;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            if (this->samples.empty())
+            {
+                this->cond.wait_for(lock, std::chrono::nanoseconds(this->workInfo().maxTimeoutNs));
+            }
+            ready.swap(this->samples);
+        }
+        if (ready.empty()) return this->yield();
+
+        auto outputPort = this->output("values");
+        for (const auto &sample : ready)
+        {
+            Pothos::ObjectKwargs values;
+            for (size_t i = 0; i < this->names.size(); i++)
+            {
+                values[this->names[i]] = Pothos::Object(sample.values[i]);
+            }
+            Pothos::ObjectKwargs msg;
+            msg["timeNs"] = Pothos::Object(sample.timeNs);
+            msg["deviceId"] = Pothos::Object(this->deviceId);
+            msg["values"] = Pothos::Object(values);
+            outputPort->postMessage(msg);
+        }
+    }
+
+private:
+    void stopThread(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->running = false;
+        }
+        this->cond.notify_all();
+        if (this->thread.joinable()) this->thread.join();
+        this->samples.clear();
+    }
+
+    void pollLoop(void)
+    {
+        auto next = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (this->running)
+        {
+            lock.unlock();
+
+            //read every attribute, one read each, outside of the lock
+            Sample sample;
+            sample.timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            sample.values.reserve(this->readers.size());
+            for (auto &read : this->readers)
+            {
+                try
+                {
+                    sample.values.push_back(read());
+                }
+                catch (const Pothos::Exception &)
+                {
+                    sample.values.push_back("");
+                }
+            }
+
+            lock.lock();
+            //drop the oldest reads if the consumer has stalled
+            if (this->samples.size() >= maxQueuedSamples) this->samples.pop_front();
+            this->samples.push_back(std::move(sample));
+            this->cond.notify_all();
+
+            //keep a fixed rate rather than a fixed gap between reads
+            const auto last = next;
+            auto period = this->periodNs.load();
+            next = last + std::chrono::nanoseconds(period);
+            const auto now = std::chrono::steady_clock::now();
+            if (next < now) next = now;
+            while (this->running && std::chrono::steady_clock::now() < next)
+            {
+                this->cond.wait_until(lock, next);
+
+                //a new period moves the deadline of this wait
+                if (this->periodNs.load() == period) continue;
+                period = this->periodNs.load();
+                next = std::max(last + std::chrono::nanoseconds(period), now);
+            }
+        }
+    }
+};
+
+static Pothos::BlockRegistry registerIIOAttributeMonitor(
+    "/iio/attribute_monitor", &IIOAttributeMonitor::make);
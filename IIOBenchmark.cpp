@@ -0,0 +1,410 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+/***********************************************************************
+ * Benchmark for the IIO source and sink blocks.
+ *
+ * The /iio/source and /iio/sink blocks of the installed module are run in
+ * a topology for each channel count and buffer size, so the numbers are
+ * those of the blocks' work(). The source's outputs are discarded and the
+ * sink's inputs are fed by a block that produces without touching the
+ * data, so that the IIO blocks are the bottleneck.
+ *
+ * Without --uri, a loopback context (see IIOLoopback) is generated with an
+ * unpaced input and output device for each sample format and channel
+ * count. With --uri and --device, the blocks stream that device's input
+ * and output scan elements, for every channel count from 1 to the number
+ * of scan elements, or for the counts given with --channels.
+ *
+ * Throughput is measured from the blocks' own statistics (streamStats)
+ * between two snapshots taken after a warm-up. The time work() spends in
+ * transfers and conversions is turned into TSC cycles per byte, with the
+ * TSC rate measured over the same window (null where there is no TSC).
+ * Allocations are counted for the whole process, which includes the
+ * framework and the blocks on the other side. Each result is printed to
+ * stdout as one JSON object per line.
+ **********************************************************************/
+
+#include "IIOConvert.hpp"
+#include <Pothos/Init.hpp>
+#include <Pothos/Framework.hpp>
+#include <Pothos/Plugin.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Poco/Environment.h>
+#include <Poco/TemporaryFile.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <json.hpp>
+using json = nlohmann::json;
+
+/***********************************************************************
+ * Allocation counting
+ **********************************************************************/
+static std::atomic<unsigned long long> allocationCount(0);
+
+void *operator new(size_t size)
+{
+    allocationCount++;
+    void *p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+/***********************************************************************
+ * Timing helpers
+ **********************************************************************/
+static inline unsigned long long readCycles(void)
+{
+    #if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+    #else
+    return 0;
+    #endif
+}
+
+static const bool haveCycles = (readCycles() != 0);
+
+/***********************************************************************
+ * Blocks on the other side of the IIO blocks
+ **********************************************************************/
+class BenchmarkDiscard : public Pothos::Block
+{
+public:
+    BenchmarkDiscard(const size_t numInputs)
+    {
+        for (size_t i = 0; i < numInputs; i++) this->setupInput(i);
+    }
+
+    void work(void)
+    {
+        for (auto port : this->inputs()) port->consume(port->elements());
+    }
+};
+
+class BenchmarkFeeder : public Pothos::Block
+{
+public:
+    BenchmarkFeeder(const size_t numOutputs)
+    {
+        for (size_t i = 0; i < numOutputs; i++) this->setupOutput(i, "uint8");
+    }
+
+    void work(void)
+    {
+        //whole 8 byte words, so that no port gets a partial sample
+        for (auto port : this->outputs()) port->produce(port->elements() & ~size_t(7));
+    }
+};
+
+/***********************************************************************
+ * Devices
+ **********************************************************************/
+struct BenchmarkChannel
+{
+    std::string id;
+    std::string format;
+    size_t bytes;
+};
+
+struct BenchmarkDevice
+{
+    std::string source;
+    std::string id;
+    bool output;
+    std::vector<BenchmarkChannel> channels;
+};
+
+static json loopbackDevice(const std::string &id, const std::string &name, const bool output, const std::vector<std::string> &formats)
+{
+    json dev;
+    dev["id"] = id;
+    dev["name"] = name;
+    dev["rate"] = 0;
+    dev["attributes"] = json::object();
+    auto &channels = dev["channels"];
+    for (size_t i = 0; i < formats.size(); i++)
+    {
+        json chan;
+        chan["id"] = "voltage" + std::to_string(i);
+        chan["output"] = output;
+        chan["scanElement"] = true;
+        chan["index"] = i;
+        chan["format"] = formats[i];
+        chan["attributes"] = json::object();
+        channels.push_back(chan);
+    }
+    return dev;
+}
+
+//write a loopback context with an input and an output device per layout
+static std::vector<BenchmarkDevice> makeSyntheticContext(const std::string &path, const std::vector<size_t> &channelCounts)
+{
+    const std::string host = iioHostIsBigEndian() ? "be" : "le";
+    const std::string swapped = iioHostIsBigEndian() ? "le" : "be";
+    std::vector<std::vector<std::string>> layouts;
+    for (const auto &format : {host+":u8/8>>0", host+":s16/16>>0", host+":s12/16>>4", swapped+":s16/16>>0", host+":s32/32>>0", host+":s24/32>>8"})
+    {
+        for (const auto n : channelCounts) layouts.emplace_back(n, format);
+    }
+    //a mixed layout, as devices with a timestamp channel have
+    for (const auto n : channelCounts)
+    {
+        std::vector<std::string> mixed(n, host+":s16/16>>0");
+        mixed.push_back(host+":s64/64>>0");
+        layouts.push_back(mixed);
+    }
+
+    json top;
+    top["name"] = "benchmark";
+    std::vector<BenchmarkDevice> devices;
+    for (const auto &layout : layouts)
+    {
+        for (const bool output : {false, true})
+        {
+            BenchmarkDevice dev;
+            dev.source = "synthetic";
+            dev.id = "iio:device" + std::to_string(devices.size());
+            dev.output = output;
+            for (size_t i = 0; i < layout.size(); i++)
+            {
+                struct iio_data_format fmt;
+                iioFormatFromString(layout[i], fmt);
+                dev.channels.push_back({"voltage" + std::to_string(i), layout[i], iioFormatBytes(fmt)});
+            }
+            top["devices"].push_back(loopbackDevice(dev.id, output ? "bench_dac" : "bench_adc", output, layout));
+            devices.push_back(dev);
+        }
+    }
+    std::ofstream(path) << top.dump();
+    return devices;
+}
+
+//the scan elements of a device, from the module's device info
+static std::vector<BenchmarkDevice> findDevice(const std::string &uri, const std::string &deviceId)
+{
+    const auto callable = Pothos::PluginRegistry::get("/devices/iio/info").getObject().extract<Pothos::Callable>();
+    const auto info = json::parse(callable.call<std::string>());
+
+    BenchmarkDevice inputs, outputs;
+    inputs.source = outputs.source = uri + "/" + deviceId;
+    inputs.id = outputs.id = deviceId;
+    inputs.output = false;
+    outputs.output = true;
+    bool found = false;
+    for (const auto &dev : info["IIO Devices"])
+    {
+        if (dev["Device ID"] != deviceId) continue;
+        found = true;
+        for (const auto &chan : dev["Channels"])
+        {
+            if (chan["Is Scan Element"] != "true") continue;
+            const auto &info = chan["Data Format"];
+            struct iio_data_format fmt;
+            std::memset(&fmt, 0, sizeof(fmt));
+            fmt.bits = info["Bits"];
+            fmt.length = info["Storage Bits"];
+            fmt.shift = info["Shift"];
+            fmt.repeat = info["Repeat"];
+            fmt.is_signed = (info["Signed"] == "true");
+            fmt.is_be = (info["Endianness"] == "Big");
+            fmt.is_fully_defined = (fmt.bits == fmt.length);
+            auto &dir = (chan["Direction"] == "Output") ? outputs : inputs;
+            dir.channels.push_back({chan["ID"].get<std::string>(), iioFormatToString(fmt), iioFormatBytes(fmt)});
+        }
+    }
+    if (!found) throw Pothos::NotFoundException("findDevice()", "device not found: " + deviceId);
+
+    std::vector<BenchmarkDevice> devices;
+    if (!inputs.channels.empty()) devices.push_back(inputs);
+    if (!outputs.channels.empty()) devices.push_back(outputs);
+    return devices;
+}
+
+/***********************************************************************
+ * Measurement
+ **********************************************************************/
+struct Snapshot
+{
+    double samples;
+    double bytes;
+    double transfers;
+    double convertUs;
+    double transferUs;
+    unsigned long long allocations;
+    unsigned long long cycles;
+    std::chrono::steady_clock::time_point time;
+};
+
+static Snapshot snapshot(Pothos::Proxy block)
+{
+    const auto stats = json::parse(block.call<std::string>("streamStats"));
+    Snapshot s;
+    s.samples = stats["samples"];
+    s.bytes = stats["bytes"];
+    s.transfers = stats["transfers"];
+    s.convertUs = stats["convertTime"]["meanUs"].get<double>()*stats["convertTime"]["count"].get<double>();
+    s.transferUs = stats["transferLatency"]["meanUs"].get<double>()*stats["transferLatency"]["count"].get<double>();
+    s.allocations = allocationCount.load();
+    s.cycles = readCycles();
+    s.time = std::chrono::steady_clock::now();
+    return s;
+}
+
+static void benchDevice(Pothos::Proxy registry, const BenchmarkDevice &dev, const size_t numChannels, const size_t bufferSize, const double minSeconds)
+{
+    std::vector<std::string> channelIds;
+    json formats = json::array();
+    for (size_t i = 0; i < numChannels; i++)
+    {
+        channelIds.push_back(dev.channels[i].id);
+        formats.push_back(dev.channels[i].format);
+    }
+
+    Pothos::Proxy block = registry.call(dev.output ? "/iio/sink" : "/iio/source", dev.id, channelIds, true, bufferSize);
+    Pothos::Topology topology;
+    if (dev.output)
+    {
+        auto feeder = std::shared_ptr<Pothos::Block>(new BenchmarkFeeder(numChannels));
+        for (size_t i = 0; i < numChannels; i++) topology.connect(feeder, i, block, channelIds[i]);
+    }
+    else
+    {
+        auto discard = std::shared_ptr<Pothos::Block>(new BenchmarkDiscard(numChannels));
+        for (size_t i = 0; i < numChannels; i++) topology.connect(block, channelIds[i], discard, i);
+    }
+    topology.commit();
+
+    //let the buffers and the framework settle before measuring
+    std::this_thread::sleep_for(std::chrono::duration<double>(std::min(0.1, minSeconds)));
+    const auto s0 = snapshot(block);
+    std::this_thread::sleep_for(std::chrono::duration<double>(minSeconds));
+    const auto s1 = snapshot(block);
+    topology.disconnectAll();
+    topology.commit();
+
+    const double seconds = std::chrono::duration<double>(s1.time - s0.time).count();
+    const double samples = (s1.samples - s0.samples)*numChannels;
+    const double transfers = s1.transfers - s0.transfers;
+    const double bytes = s1.bytes - s0.bytes;
+    const double workUs = (s1.convertUs - s0.convertUs) + (s1.transferUs - s0.transferUs);
+    const double cyclesPerUs = (s1.cycles - s0.cycles)/(seconds*1e6);
+    json result;
+    result["source"] = dev.source;
+    result["path"] = dev.output ? "sink" : "source";
+    result["formats"] = formats;
+    result["channels"] = numChannels;
+    result["bufferSize"] = bufferSize;
+    result["transfers"] = transfers;
+    result["samplesPerSec"] = samples/seconds;
+    result["bytesPerSec"] = bytes/seconds;
+    result["convertNsPerSample"] = samples ? (s1.convertUs - s0.convertUs)*1e3/samples : 0.0;
+    result["transferNsPerSample"] = samples ? (s1.transferUs - s0.transferUs)*1e3/samples : 0.0;
+    if (haveCycles && bytes) result["cyclesPerByte"] = workUs*cyclesPerUs/bytes;
+    else result["cyclesPerByte"] = nullptr;
+    result["processAllocationsPerTransfer"] = transfers ? (s1.allocations - s0.allocations)/transfers : 0.0;
+    std::cout << result.dump() << std::endl;
+}
+
+/***********************************************************************
+ * Entry point
+ **********************************************************************/
+static std::vector<size_t> parseCounts(const std::string &list)
+{
+    std::vector<size_t> counts;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) counts.push_back(size_t(std::atol(item.c_str())));
+    return counts;
+}
+
+int main(int argc, char **argv)
+{
+    std::string uri, deviceId;
+    double minSeconds = 0.5;
+    std::vector<size_t> channelCounts;
+    std::vector<size_t> bufferSizes = {256, 2048, 16384};
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg(argv[i]);
+        const bool haveValue = (i+1 < argc);
+        if (arg == "--uri" && haveValue) uri = argv[++i];
+        else if (arg == "--device" && haveValue) deviceId = argv[++i];
+        else if (arg == "--seconds" && haveValue) minSeconds = std::atof(argv[++i]);
+        else if (arg == "--buffer-size" && haveValue) bufferSizes = parseCounts(argv[++i]);
+        else if (arg == "--channels" && haveValue) channelCounts = parseCounts(argv[++i]);
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--uri URI --device ID] [--seconds S] [--buffer-size N,...] [--channels N,...]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    try
+    {
+        //the blocks use the global context, which follows POTHOS_IIO_URI
+        std::vector<BenchmarkDevice> devices;
+        Poco::TemporaryFile contextFile;
+        if (uri.empty())
+        {
+            if (channelCounts.empty()) channelCounts = {1, 2, 3, 4, 8};
+            devices = makeSyntheticContext(contextFile.path(), channelCounts);
+            Poco::Environment::set("POTHOS_IIO_URI", "loopback:" + contextFile.path());
+        }
+        else Poco::Environment::set("POTHOS_IIO_URI", uri);
+
+        Pothos::ScopedInit init;
+        auto env = Pothos::ProxyEnvironment::make("managed");
+        auto registry = env->findProxy("Pothos/BlockRegistry");
+        if (!uri.empty()) devices = findDevice(uri, deviceId);
+
+        for (const auto &dev : devices)
+        {
+            //synthetic devices have one layout each; for a real device, every count
+            std::vector<size_t> counts = {dev.channels.size()};
+            if (!uri.empty())
+            {
+                counts.clear();
+                for (size_t n = 1; n <= dev.channels.size(); n++) counts.push_back(n);
+                if (!channelCounts.empty()) counts = channelCounts;
+            }
+            for (const auto n : counts)
+            {
+                if (n == 0 || n > dev.channels.size()) continue;
+                for (const auto bufferSize : bufferSizes) benchDevice(registry, dev, n, bufferSize, minSeconds);
+            }
+        }
+    }
+    catch (const Pothos::Exception &ex)
+    {
+        std::cerr << ex.displayText() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,387 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include "IIOBufferBroker.hpp"
+#include "IIOStats.hpp"
+#include <Poco/Error.h>
+#ifndef _MSC_VER
+#include <poll.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <set>
+
+//brokers by device ID, which live as long as they have subscribers
+static std::mutex brokersMutex;
+static std::map<std::string, std::weak_ptr<IIOBufferBroker>> brokers;
+
+//chunks a subscriber may fall behind before it loses the oldest one
+static const size_t maxQueuedChunks = 16;
+
+//how long the refill thread waits before checking for changes
+static const int pollTimeoutMs = 100;
+
+/***********************************************************************
+ * Subscription
+ **********************************************************************/
+IIOBufferBroker::Subscription::Subscription(std::shared_ptr<IIOBufferBroker> broker,
+    const std::vector<std::string> &channelIds, const size_t bufferSize, const IIOPlacement &placement):
+    broker(broker), channelIds(channelIds), bufferSize(bufferSize), placement(placement), droppedChunks(0)
+{
+}
+
+IIOBufferBroker::Subscription::~Subscription(void)
+{
+    std::lock_guard<std::mutex> lock(this->broker->mutex);
+    auto &subscribers = this->broker->subscribers;
+    subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), this), subscribers.end());
+    this->broker->requested++;
+    this->broker->changed.notify_all();
+}
+
+IIOBufferBroker::ChunkPtr IIOBufferBroker::Subscription::pop(const std::chrono::nanoseconds &timeout)
+{
+    std::unique_lock<std::mutex> lock(this->broker->mutex);
+    this->broker->published.wait_for(lock, timeout, [this](void)
+    {
+        return !this->queue.empty() || this->broker->error;
+    });
+    if (!this->queue.empty())
+    {
+        auto chunk = this->queue.front();
+        this->queue.pop_front();
+        return chunk;
+    }
+    if (this->broker->error) std::rethrow_exception(this->broker->error);
+    return nullptr;
+}
+
+unsigned long long IIOBufferBroker::Subscription::dropped(void) const
+{
+    std::lock_guard<std::mutex> lock(this->broker->mutex);
+    return this->droppedChunks;
+}
+
+/***********************************************************************
+ * Broker
+ **********************************************************************/
+std::unique_ptr<IIOBufferBroker::Subscription> IIOBufferBroker::subscribe(const std::string &deviceId,
+    const std::vector<std::string> &channelIds, const size_t bufferSize, const IIOPlacement &placement)
+{
+    //check the channels up front, so that a bad subscriber
+    //cannot break the shared buffer for the others
+    bool found = false;
+    for (auto d : IIOContext::get().devices())
+    {
+        if (d.id() != deviceId) continue;
+        found = true;
+        for (const auto &id : channelIds)
+        {
+            bool valid = false;
+            for (auto c : d.channels())
+            {
+                valid = valid || (c.id() == id && !c.isOutput() && c.isScanElement());
+            }
+            if (!valid)
+            {
+                throw Pothos::NotFoundException("IIOBufferBroker::subscribe()", "not an input scan element: " + id);
+            }
+        }
+    }
+    if (!found)
+    {
+        throw Pothos::NotFoundException("IIOBufferBroker::subscribe()", "device not found: " + deviceId);
+    }
+
+    //find the device's broker, replacing one whose buffer failed; the
+    //failed one is released after the lock, as its destructor takes it
+    std::shared_ptr<IIOBufferBroker> broker, failed;
+    {
+        std::lock_guard<std::mutex> lock(brokersMutex);
+        broker = brokers[deviceId].lock();
+        if (broker)
+        {
+            std::lock_guard<std::mutex> brokerLock(broker->mutex);
+            if (broker->error) failed.swap(broker);
+        }
+        if (!broker)
+        {
+            broker.reset(new IIOBufferBroker(deviceId));
+            brokers[deviceId] = broker;
+        }
+    }
+
+    //wait for the refill thread to re-create the buffer with our channels
+    std::unique_ptr<Subscription> subscription(new Subscription(broker, channelIds, bufferSize, placement));
+    std::unique_lock<std::mutex> lock(broker->mutex);
+    broker->subscribers.push_back(subscription.get());
+    const auto ticket = ++broker->requested;
+    broker->changed.notify_all();
+    broker->published.wait(lock, [&](void)
+    {
+        return broker->rebuilt >= ticket || broker->error;
+    });
+    if (broker->error)
+    {
+        const auto error = broker->error;
+        lock.unlock();
+        std::rethrow_exception(error);
+    }
+    return subscription;
+}
+
+IIOBufferBroker::IIOBufferBroker(const std::string &deviceId):
+    deviceId(deviceId),
+    requested(0),
+    rebuilt(0),
+    stop(false),
+    sequence(0),
+    pool(std::make_shared<Pool>())
+{
+    this->thread = std::thread(&IIOBufferBroker::run, this);
+}
+
+IIOBufferBroker::~IIOBufferBroker(void)
+{
+    //our registry entry has expired already; hold the registry until the
+    //device buffer is released, so that a new broker for the device,
+    //which waits for the lock, does not find the buffer busy
+    std::lock_guard<std::mutex> brokersLock(brokersMutex);
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stop = true;
+        this->changed.notify_all();
+    }
+    this->thread.join();
+    this->buf.reset();
+    this->dev.reset();
+
+    auto it = brokers.find(this->deviceId);
+    if (it != brokers.end() && it->second.expired()) brokers.erase(it);
+}
+
+void IIOBufferBroker::run(void)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (!this->stop)
+    {
+        //re-create the buffer for the current subscribers
+        if (this->rebuilt != this->requested)
+        {
+            const auto ticket = this->requested;
+            try
+            {
+                this->rebuild();
+            }
+            catch (...)
+            {
+                this->buf.reset();
+                this->error = std::current_exception();
+            }
+            this->rebuilt = ticket;
+            this->published.notify_all();
+            if (this->error) return;
+            continue;
+        }
+
+        if (!this->buf)
+        {
+            this->changed.wait(lock);
+            continue;
+        }
+
+        //refill without the lock, so that subscribers can keep up
+        lock.unlock();
+        ChunkPtr chunk;
+        std::exception_ptr error;
+        try
+        {
+            chunk = this->refill();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        lock.lock();
+
+        if (error)
+        {
+            this->buf.reset();
+            this->error = error;
+            this->published.notify_all();
+            return;
+        }
+        if (chunk) this->publish(chunk);
+    }
+}
+
+void IIOBufferBroker::rebuild(void)
+{
+    this->buf.reset();
+    this->layout.reset();
+
+    //samples are lost while the buffer is re-created,
+    //so leave a gap in the sequence for the subscribers
+    this->sequence++;
+    if (this->subscribers.empty()) return;
+    this->place();
+
+    //the union of the subscribed channels, and the largest buffer size
+    std::set<std::string> channelIds;
+    size_t bufferSize = 0;
+    for (const auto sub : this->subscribers)
+    {
+        channelIds.insert(sub->channelIds.begin(), sub->channelIds.end());
+        bufferSize = std::max(bufferSize, sub->bufferSize);
+    }
+
+    //look the device up again, as the context may have been re-scanned
+    this->dev.reset();
+    for (auto d : IIOContext::get().devices())
+    {
+        if (d.id() == this->deviceId) this->dev.reset(new IIODevice(d));
+    }
+    if (!this->dev)
+    {
+        throw Pothos::NotFoundException("IIOBufferBroker::rebuild()", "device not found: " + this->deviceId);
+    }
+
+    //enable exactly the union, so that the scan only carries what is used
+    std::vector<IIOChannel> channels;
+    for (auto c : this->dev->channels())
+    {
+        if (c.isOutput() || !c.isScanElement()) continue;
+        if (channelIds.count(c.id()) != 0)
+        {
+            c.enable();
+            channels.push_back(c);
+        }
+        else if (c.isEnabled()) c.disable();
+    }
+    if (channels.empty()) return;
+
+    this->buf.reset(new IIOBuffer(this->dev->createBuffer(bufferSize, false)));
+    this->buf->setBlockingMode(false);
+    this->placement.bindMemory(this->buf->start(), static_cast<char *>(this->buf->end()) - static_cast<char *>(this->buf->start()));
+
+    std::shared_ptr<Layout> layout(new Layout());
+    layout->step = this->buf->step();
+    const auto start = static_cast<const char *>(this->buf->start());
+    for (auto &c : channels)
+    {
+        layout->offsets[c.id()] = static_cast<const char *>(this->buf->first(c)) - start;
+    }
+    this->layout = layout;
+    this->lastTime = Clock::now();
+}
+
+void IIOBufferBroker::place(void)
+{
+    //follow the first subscriber that asks for a placement
+    IIOPlacement placement;
+    for (const auto sub : this->subscribers)
+    {
+        if (!sub->placement.isDefault())
+        {
+            placement = sub->placement;
+            break;
+        }
+    }
+    if (placement == this->placement) return;
+
+    //the refill thread belongs to the broker; a placement the system
+    //refuses fails the rebuild, which reports it to the subscribers
+    placement.applyToThisThread();
+    this->placement = placement;
+
+    //pooled chunks were allocated under the old memory policy
+    std::lock_guard<std::mutex> lock(this->pool->mutex);
+    this->pool->free.clear();
+}
+
+IIOBufferBroker::ChunkPtr IIOBufferBroker::refill(void)
+{
+    #ifndef _MSC_VER
+    struct pollfd pfd = {this->buf->fd(), POLLIN, 0};
+    const int ret = poll(&pfd, 1, pollTimeoutMs);
+    if (ret < 0 && errno != EINTR)
+    {
+        throw Pothos::SystemException("IIOBufferBroker::refill()", "poll failed: " + Poco::Error::getMessage(errno));
+    }
+    //an unregistered local device reports no events, only timeouts
+    if (ret == 0 && !this->dev->isPresent())
+    {
+        throw Pothos::SystemException("IIOBufferBroker::refill()", this->deviceId + " is no longer present", ENODEV);
+    }
+    if (ret <= 0) return nullptr;
+    #endif
+
+    const auto t0 = Clock::now();
+    size_t bytes = 0;
+    try
+    {
+        bytes = this->buf->refill();
+    }
+    catch (const Pothos::Exception &ex)
+    {
+        if (ex.code() == EAGAIN) return nullptr;
+        throw;
+    }
+    const auto t1 = Clock::now();
+
+    //take storage from the pool; it goes back there when
+    //the last subscriber releases the chunk
+    std::vector<char> data;
+    {
+        std::lock_guard<std::mutex> lock(this->pool->mutex);
+        if (!this->pool->free.empty())
+        {
+            data = std::move(this->pool->free.back());
+            this->pool->free.pop_back();
+        }
+    }
+    data.resize(bytes);
+    std::memcpy(data.data(), this->buf->start(), bytes);
+
+    auto pool = this->pool;
+    std::shared_ptr<Chunk> chunk(new Chunk(), [pool](Chunk *c)
+    {
+        {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+            if (pool->free.size() < maxQueuedChunks) pool->free.push_back(std::move(c->data));
+        }
+        delete c;
+    });
+    chunk->layout = this->layout;
+    chunk->data = std::move(data);
+    chunk->samples = bytes/this->layout->step;
+    chunk->sequence = this->sequence++;
+    chunk->refillNs = IIOStreamStats::elapsedNs(t0, t1);
+    chunk->time = t1;
+    chunk->previousTime = this->lastTime;
+    this->lastTime = t1;
+    return chunk;
+}
+
+void IIOBufferBroker::publish(const ChunkPtr &chunk)
+{
+    for (auto sub : this->subscribers)
+    {
+        //skip subscribers that joined after this buffer was created
+        bool covered = true;
+        for (const auto &id : sub->channelIds)
+        {
+            covered = covered && chunk->layout->offsets.count(id) != 0;
+        }
+        if (!covered) continue;
+
+        if (sub->queue.size() >= maxQueuedChunks)
+        {
+            sub->queue.pop_front();
+            sub->droppedChunks++;
+        }
+        sub->queue.push_back(chunk);
+    }
+    this->published.notify_all();
+}
@@ -0,0 +1,154 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include "IIOSupport.hpp"
+#include "IIOPlacement.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*!
+ * IIOBufferBroker shares the input buffer of a device between several
+ * subscribers, so that blocks which want different channels of the same
+ * device can stream at the same time.
+ *
+ * There is one broker per device. It owns a single IIOBuffer with the union
+ * of the subscribed channels, which it re-creates whenever subscribers come
+ * and go, and refills it from its own thread. Because libiio reuses the
+ * buffer memory on the next refill, each refill is copied once into a
+ * pooled, reference counted chunk that is handed to every subscriber.
+ * Subscribers convert their channels straight out of the shared chunk, and
+ * the chunk returns to the pool when the last of them releases it. A
+ * subscriber that falls too many chunks behind loses the oldest ones, which
+ * shows up as a gap in the chunk sequence numbers.
+ *
+ * The refill thread takes the placement of the first subscriber that asks
+ * for one, so that it and the chunks it allocates run on the subscriber's
+ * CPUs and NUMA node. If the system refuses the placement, the subscribers
+ * get the error like any other failure to create the buffer.
+ */
+class IIOBufferBroker
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    /*!
+     * The byte offset of each channel within a scan, and the scan size.
+     */
+    struct Layout
+    {
+        ptrdiff_t step;
+        std::map<std::string, ptrdiff_t> offsets;
+    };
+
+    /*!
+     * The scans of one refill.
+     */
+    struct Chunk
+    {
+        std::shared_ptr<const Layout> layout;
+        std::vector<char> data;
+        size_t samples;
+        unsigned long long sequence;
+        unsigned long long refillNs;
+        Clock::time_point time; //when this refill completed
+        Clock::time_point previousTime; //when the previous refill completed
+
+        /*!
+         * Get the address of the first sample of a channel in this chunk.
+         */
+        const void *first(const std::string &channelId) const
+        {
+            return this->data.data() + this->layout->offsets.at(channelId);
+        }
+    };
+    typedef std::shared_ptr<const Chunk> ChunkPtr;
+
+    /*!
+     * A subscriber's handle; destroying it unsubscribes.
+     */
+    class Subscription
+    {
+    public:
+        ~Subscription(void);
+
+        /*!
+         * Wait up to timeout for the next chunk. Returns null on timeout,
+         * and throws the broker's error if the buffer failed.
+         */
+        ChunkPtr pop(const std::chrono::nanoseconds &timeout);
+
+        /*!
+         * Get the number of chunks this subscriber lost by falling behind.
+         */
+        unsigned long long dropped(void) const;
+
+    private:
+        friend class IIOBufferBroker;
+        Subscription(std::shared_ptr<IIOBufferBroker> broker, const std::vector<std::string> &channelIds,
+            const size_t bufferSize, const IIOPlacement &placement);
+
+        std::shared_ptr<IIOBufferBroker> broker;
+        std::vector<std::string> channelIds;
+        size_t bufferSize;
+        IIOPlacement placement;
+        std::deque<ChunkPtr> queue;
+        unsigned long long droppedChunks;
+    };
+
+    /*!
+     * Subscribe to input scan channels of a device. The buffer size of the
+     * shared buffer is the largest one requested by the subscribers. Returns
+     * once the buffer carries the channels, and throws if the channels are
+     * not input scan elements or the buffer cannot be created.
+     */
+    static std::unique_ptr<Subscription> subscribe(const std::string &deviceId,
+        const std::vector<std::string> &channelIds, const size_t bufferSize,
+        const IIOPlacement &placement = IIOPlacement());
+
+    ~IIOBufferBroker(void);
+
+private:
+    struct Pool
+    {
+        std::mutex mutex;
+        std::vector<std::vector<char>> free;
+    };
+
+    IIOBufferBroker(const std::string &deviceId);
+
+    void run(void);
+    void rebuild(void);
+    void place(void);
+    ChunkPtr refill(void);
+    void publish(const ChunkPtr &chunk);
+
+    const std::string deviceId;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::condition_variable published;
+    std::vector<Subscription *> subscribers;
+    unsigned long long requested;
+    unsigned long long rebuilt;
+    bool stop;
+    std::exception_ptr error;
+
+    //only used by the refill thread
+    std::unique_ptr<IIODevice> dev;
+    std::unique_ptr<IIOBuffer> buf;
+    std::shared_ptr<const Layout> layout;
+    IIOPlacement placement;
+    unsigned long long sequence;
+    Clock::time_point lastTime;
+    std::shared_ptr<Pool> pool;
+
+    std::thread thread;
+};
@@ -0,0 +1,250 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include "IIOBufferPool.hpp"
+#include <Poco/Error.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+
+//huge pages on the platforms we care about; slabs are rounded up to this
+static const size_t hugePageSize = 2*1024*1024;
+
+//start every buffer on its own cache line
+static const size_t bufferAlignment = 64;
+
+static size_t roundUp(const size_t n, const size_t multiple)
+{
+    return ((n + multiple - 1)/multiple)*multiple;
+}
+
+/***********************************************************************
+ * Slab of pre-faulted memory
+ **********************************************************************/
+struct IIOBufferPool::Slab
+{
+    Slab(const size_t bytes, const int node);
+    ~Slab(void);
+
+    void *addr;
+    size_t bytes;
+    int node;
+    bool huge;
+    Pothos::SharedBuffer fallback; //the memory where mmap is not available
+};
+
+IIOBufferPool::Slab::Slab(const size_t bytes, const int node):
+    addr(nullptr),
+    bytes(roundUp(bytes, hugePageSize)),
+    node(node),
+    huge(false)
+{
+    #ifdef __linux__
+    //reserved huge pages, if the administrator set any aside
+    this->addr = mmap(nullptr, this->bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    this->huge = (this->addr != MAP_FAILED);
+
+    //otherwise align the mapping to a huge page and ask for transparent huge pages
+    if (!this->huge)
+    {
+        void *mem = mmap(nullptr, this->bytes + hugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED)
+        {
+            throw Pothos::SystemException("IIOBufferPool::Slab()", "mmap: " + Poco::Error::getMessage(errno));
+        }
+        const uintptr_t start = roundUp(uintptr_t(mem), hugePageSize);
+        const size_t head = start - uintptr_t(mem);
+        if (head != 0) munmap(mem, head);
+        munmap(reinterpret_cast<void *>(start + this->bytes), hugePageSize - head);
+        this->addr = reinterpret_cast<void *>(start);
+        this->huge = madvise(this->addr, this->bytes, MADV_HUGEPAGE) == 0;
+    }
+
+    //place the pages before they exist, then fault them all in now
+    //rather than on the first pass of the stream
+    IIOPlacement placement;
+    placement.node = node;
+    placement.bindMemory(this->addr, this->bytes);
+    std::memset(this->addr, 0, this->bytes);
+    #else
+    this->fallback = Pothos::SharedBuffer::make(this->bytes, node);
+    this->addr = reinterpret_cast<void *>(this->fallback.getAddress());
+    std::memset(this->addr, 0, this->bytes);
+    #endif
+}
+
+IIOBufferPool::Slab::~Slab(void)
+{
+    #ifdef __linux__
+    munmap(this->addr, this->bytes);
+    #endif
+}
+
+/***********************************************************************
+ * Buffer manager for one port
+ **********************************************************************/
+class IIOPooledBufferManager : public Pothos::BufferManager
+{
+public:
+    IIOPooledBufferManager(const std::vector<Pothos::SharedBuffer> &buffers):
+        buffers(buffers),
+        ready(buffers.size()),
+        head(0),
+        count(0),
+        bytesPopped(0)
+    {
+    }
+
+    void init(const Pothos::BufferManagerArgs &args)
+    {
+        Pothos::BufferManager::init(args);
+        for (size_t i = 0; i < this->buffers.size(); i++)
+        {
+            Pothos::ManagedBuffer buffer;
+            buffer.reset(this->shared_from_this(), this->buffers[i], i);
+            this->push(buffer);
+        }
+    }
+
+    bool empty(void) const
+    {
+        return this->count == 0;
+    }
+
+    void pop(const size_t numBytes)
+    {
+        //like the generic manager, keep producing into the rest of the
+        //front buffer while less than half of it has been used
+        this->bytesPopped += numBytes;
+        if (this->bytesPopped*2 < this->ready[this->head].getBuffer().getLength())
+        {
+            auto chunk = this->front();
+            chunk.address += numBytes;
+            chunk.length -= numBytes;
+            this->setFrontBuffer(chunk);
+            return;
+        }
+
+        //the buffer goes downstream, and comes back through push()
+        //once every chunk produced from it has been released
+        this->bytesPopped = 0;
+        this->ready[this->head].reset();
+        this->head = (this->head + 1) % this->ready.size();
+        this->count--;
+        this->setFrontBuffer(this->empty() ? Pothos::BufferChunk() : Pothos::BufferChunk(this->ready[this->head]));
+    }
+
+    void push(const Pothos::ManagedBuffer &buffer)
+    {
+        this->ready[(this->head + this->count) % this->ready.size()] = buffer;
+        if (this->count++ == 0) this->setFrontBuffer(Pothos::BufferChunk(buffer));
+    }
+
+private:
+    const std::vector<Pothos::SharedBuffer> buffers;
+
+    //ring of ready buffers, so that steady state never allocates
+    std::vector<Pothos::ManagedBuffer> ready;
+    size_t head;
+    size_t count;
+    size_t bytesPopped; //of the front buffer
+};
+
+/***********************************************************************
+ * Pool
+ **********************************************************************/
+std::shared_ptr<IIOBufferPool> IIOBufferPool::make(void)
+{
+    return std::shared_ptr<IIOBufferPool>(new IIOBufferPool());
+}
+
+IIOBufferPool::IIOBufferPool(void)
+{
+}
+
+IIOBufferPool::~IIOBufferPool(void)
+{
+}
+
+std::shared_ptr<Pothos::BufferManager> IIOBufferPool::manager(const size_t index,
+    const std::vector<size_t> &bufferBytes, const IIOPlacement &placement)
+{
+    std::vector<size_t> portBytes(bufferBytes.size());
+    for (size_t i = 0; i < bufferBytes.size(); i++)
+    {
+        portBytes[i] = IIOBufferPool::numBuffers*roundUp(bufferBytes[i], bufferAlignment);
+    }
+
+    //the previous slab may go back to the pool, which takes the lock,
+    //so only release it once the lock is dropped
+    std::shared_ptr<Slab> previous;
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    //a port asking again, or different ports, means a new commit;
+    //the slab can be cut up again once the previous commit released it
+    if (!this->current || this->currentBytes != bufferBytes ||
+        this->current->node != placement.node || this->handedOut.at(index))
+    {
+        const size_t bytes = std::accumulate(portBytes.begin(), portBytes.end(), size_t(0));
+        if (!this->current || this->current.use_count() != 1 ||
+            this->current->bytes < bytes || this->current->node != placement.node)
+        {
+            previous = std::move(this->current);
+            this->current = this->acquire(bytes, placement.node);
+        }
+        this->currentBytes = bufferBytes;
+        this->handedOut.assign(bufferBytes.size(), false);
+    }
+    this->handedOut.at(index) = true;
+
+    //cut the port's buffers out of the slab; they keep the slab alive
+    const size_t offset = std::accumulate(portBytes.begin(), portBytes.begin() + index, size_t(0));
+    const size_t address = reinterpret_cast<size_t>(this->current->addr) + offset;
+    std::vector<Pothos::SharedBuffer> buffers;
+    for (size_t i = 0; i < IIOBufferPool::numBuffers; i++)
+    {
+        buffers.emplace_back(address + i*portBytes[index]/IIOBufferPool::numBuffers, bufferBytes[index], this->current);
+    }
+
+    Pothos::BufferManagerArgs args;
+    args.numBuffers = IIOBufferPool::numBuffers;
+    args.bufferSize = bufferBytes[index];
+    args.nodeAffinity = placement.node;
+    std::shared_ptr<Pothos::BufferManager> manager(new IIOPooledBufferManager(buffers));
+    manager->init(args);
+    return manager;
+}
+
+std::shared_ptr<IIOBufferPool::Slab> IIOBufferPool::acquire(const size_t bytes, const int node)
+{
+    //reuse the spare slab if it fits, otherwise replace it
+    std::unique_ptr<Slab> slab(std::move(this->spare));
+    if (!slab || slab->bytes < bytes || slab->node != node) slab.reset(new Slab(bytes, node));
+
+    //park the slab again once its last buffer has been released
+    std::weak_ptr<IIOBufferPool> weakPool(this->shared_from_this());
+    return std::shared_ptr<Slab>(slab.release(), [weakPool](Slab *s)
+    {
+        std::unique_ptr<Slab> released(s);
+        auto pool = weakPool.lock();
+        if (!pool) return;
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (!pool->spare || pool->spare->bytes < released->bytes) pool->spare = std::move(released);
+    });
+}
+
+size_t IIOBufferPool::slabBytes(void) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->current ? this->current->bytes : 0;
+}
+
+bool IIOBufferPool::hugePages(void) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->current && this->current->huge;
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include "IIOPlacement.hpp"
+#include <Pothos/Framework.hpp>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/*!
+ * IIOBufferPool provides the buffer managers for the stream ports of an IIO
+ * block, in place of the default Pothos buffer managers.
+ *
+ * All ports of a block share one slab of memory, which is backed by 2 MB
+ * huge pages where the system allows it (reserved hugetlb pages, otherwise
+ * transparent huge pages), placed on the NUMA node of the block and
+ * pre-faulted when it is allocated. Each port gets a few buffers of the
+ * block's buffer size out of the slab, so a whole block usually fits in a
+ * single huge page and a single TLB entry. As with the default managers,
+ * a buffer takes several small productions until half of it is used.
+ *
+ * A slab goes back to the pool once the ports and the blocks downstream have
+ * released its last buffer, and is handed out again when the topology is
+ * committed the next time, so re-activating a block neither allocates nor
+ * faults in memory.
+ */
+class IIOBufferPool : public std::enable_shared_from_this<IIOBufferPool>
+{
+public:
+    //the number of buffers each port cycles through
+    static const size_t numBuffers = 4;
+
+    static std::shared_ptr<IIOBufferPool> make(void);
+
+    ~IIOBufferPool(void);
+
+    /*!
+     * Get the buffer manager of port index, given the size in bytes of one
+     * buffer of every port. The managers of one commit are cut from the same
+     * slab; asking for a port again starts a new slab.
+     */
+    std::shared_ptr<Pothos::BufferManager> manager(const size_t index,
+        const std::vector<size_t> &bufferBytes, const IIOPlacement &placement);
+
+    /*!
+     * Get the size of the slab that was handed out last, and whether it is
+     * backed by huge pages.
+     */
+    size_t slabBytes(void) const;
+    bool hugePages(void) const;
+
+private:
+    struct Slab;
+    IIOBufferPool(void);
+    std::shared_ptr<Slab> acquire(const size_t bytes, const int node);
+
+    mutable std::mutex mutex;
+    std::unique_ptr<Slab> spare; //a released slab, kept for the next commit
+    std::shared_ptr<Slab> current; //the slab of the current commit
+    std::vector<size_t> currentBytes;
+    std::vector<bool> handedOut;
+};
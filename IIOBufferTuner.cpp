@@ -0,0 +1,151 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include "IIOBufferTuner.hpp"
+#include <Pothos/Framework.hpp>
+#include <algorithm>
+#include <cmath>
+
+#include <json.hpp>
+using json = nlohmann::json;
+
+//weight of a new transfer in the cost estimates
+static const double costWeight = 1.0/16;
+
+//the load at which the latency mode stops shrinking the buffer
+static const double maxLatencyLoad = 0.5;
+
+//the scheduling delay that input streams queue kernel buffers for
+static const double kernelSlackNs = 20e6;
+
+//the kernel buffers of an output stream, as libiio allocates by default
+static const size_t outputKernelBuffers = 4;
+static const size_t maxKernelBuffers = 64;
+
+const size_t IIOBufferTuner::minBufferSize;
+const size_t IIOBufferTuner::maxBufferSize;
+
+IIOBufferTuner::IIOBufferTuner(void):
+    mode("fixed"),
+    targetLatencyUs(1000.0),
+    cpuBudget(0.1),
+    output(false),
+    callNs(0.0),
+    sampleNs(0.0),
+    haveCosts(false),
+    transfers(0),
+    samples(0)
+{
+}
+
+void IIOBufferTuner::configure(const std::string &mode, const double targetLatencyUs, const double cpuBudget, const bool output)
+{
+    if (mode != "fixed" && mode != "latency" && mode != "cpu")
+    {
+        throw Pothos::InvalidArgumentException("IIOBufferTuner::configure()", "unknown buffer mode: " + mode);
+    }
+    if (!(targetLatencyUs > 0.0))
+    {
+        throw Pothos::RangeException("IIOBufferTuner::configure()", "target latency must be positive");
+    }
+    if (!(cpuBudget > 0.0 && cpuBudget <= 1.0))
+    {
+        throw Pothos::RangeException("IIOBufferTuner::configure()", "CPU budget must be in (0, 1]");
+    }
+    this->mode = mode;
+    this->targetLatencyUs = targetLatencyUs;
+    this->cpuBudget = cpuBudget;
+    this->output = output;
+}
+
+bool IIOBufferTuner::enabled(void) const
+{
+    return this->mode != "fixed";
+}
+
+void IIOBufferTuner::restart(void)
+{
+    this->transfers = 0;
+    this->samples = 0;
+}
+
+void IIOBufferTuner::record(const size_t samples, const unsigned long long transferNs, const unsigned long long convertNs)
+{
+    const auto now = Clock::now();
+    if (samples != 0)
+    {
+        const double perSample = double(convertNs)/samples;
+        this->callNs = this->haveCosts ? this->callNs + costWeight*(transferNs - this->callNs) : transferNs;
+        this->sampleNs = this->haveCosts ? this->sampleNs + costWeight*(perSample - this->sampleNs) : perSample;
+        this->haveCosts = true;
+    }
+
+    //the rate counts the samples that arrived after the first transfer
+    if (this->transfers++ == 0) this->firstTime = now;
+    else this->samples += samples;
+    this->lastTime = now;
+}
+
+bool IIOBufferTuner::settled(void) const
+{
+    return this->transfers >= 8 || (this->transfers >= 3 && this->lastTime - this->firstTime >= std::chrono::seconds(1));
+}
+
+double IIOBufferTuner::measuredRate(void) const
+{
+    const double elapsed = std::chrono::duration<double>(this->lastTime - this->firstTime).count();
+    return (this->transfers >= 2 && elapsed > 0.0) ? this->samples/elapsed : 0.0;
+}
+
+size_t IIOBufferTuner::bufferSize(const double rate, const size_t current) const
+{
+    if (!this->enabled() || !this->haveCosts || !(rate > 0.0)) return current;
+
+    //the smallest size whose load fits a budget; the conversion load does
+    //not depend on the size, so it has to fit on its own
+    const double conversionLoad = this->sampleNs*rate/1e9;
+    const auto smallestFor = [&](const double budget)
+    {
+        if (budget <= conversionLoad) return double(maxBufferSize);
+        return this->callNs*rate/1e9/(budget - conversionLoad);
+    };
+
+    double size = 0.0;
+    if (this->mode == "cpu") size = smallestFor(this->cpuBudget);
+    else
+    {
+        //the samples of an output wait in every kernel buffer
+        size = rate*this->targetLatencyUs/1e6/(this->output ? outputKernelBuffers : 1);
+        size = std::max(size, smallestFor(maxLatencyLoad));
+    }
+    size = std::min(std::max(size, double(minBufferSize)), double(maxBufferSize));
+
+    size_t rounded = minBufferSize;
+    while (rounded < size) rounded *= 2;
+
+    //grow at once, but only shrink when clearly too large
+    if (rounded < current && size > 0.4*current) return current;
+    return rounded;
+}
+
+size_t IIOBufferTuner::kernelBuffers(const size_t bufferSize, const double rate) const
+{
+    if (this->output || !(rate > 0.0)) return outputKernelBuffers;
+    const double fillNs = bufferSize/rate*1e9;
+    return std::min(std::max(size_t(std::ceil(kernelSlackNs/fillNs)), outputKernelBuffers), maxKernelBuffers);
+}
+
+std::string IIOBufferTuner::toJSON(const double rate, const size_t bufferSize, const size_t kernelBuffers) const
+{
+    json obj;
+    obj["mode"] = this->mode;
+    obj["targetLatencyUs"] = this->targetLatencyUs;
+    obj["cpuBudget"] = this->cpuBudget;
+    obj["sampleRate"] = rate;
+    obj["bufferSize"] = bufferSize;
+    obj["kernelBuffers"] = kernelBuffers;
+    obj["callUs"] = this->callNs/1e3;
+    obj["sampleNs"] = this->sampleNs;
+    obj["cpuLoad"] = (bufferSize != 0) ? (this->callNs + this->sampleNs*bufferSize)*rate/bufferSize/1e9 : 0.0;
+    return obj.dump();
+}
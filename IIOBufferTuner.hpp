@@ -0,0 +1,104 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+/*!
+ * IIOBufferTuner picks the buffer size of a stream from measurements of the
+ * stream itself, instead of a hand-tuned constant.
+ *
+ * Each transfer costs a fixed overhead per refill() or push() call plus a
+ * conversion cost per sample, both of which the tuner estimates as the
+ * stream runs. At a sample rate r, a buffer of N samples then keeps the
+ * work thread busy for a fraction (callNs + sampleNs*N)*r/N of the time.
+ * In the "latency" mode the buffer holds the samples of the target latency,
+ * but never less than keeps that fraction at or below one half, so the
+ * stream cannot overflow. In the "cpu" mode it is the smallest buffer whose
+ * fraction fits the CPU budget. Sizes are powers of two, and the tuner only
+ * shrinks a buffer well below half its size, so that measurement noise does
+ * not re-create the buffer back and forth.
+ *
+ * The kernel buffer count follows the size: input streams queue enough
+ * buffers to ride out 20 ms of scheduling delay, which costs no latency,
+ * while output streams keep four, and count them towards the latency.
+ */
+class IIOBufferTuner
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static const size_t minBufferSize = 64;
+    static const size_t maxBufferSize = 65536;
+
+    IIOBufferTuner(void);
+
+    /*!
+     * Set the mode ("fixed", "latency" or "cpu"), the target latency in
+     * microseconds and the CPU budget as a fraction of one core. Whether the
+     * stream is an output changes how the latency is counted.
+     */
+    void configure(const std::string &mode, const double targetLatencyUs, const double cpuBudget, const bool output);
+
+    /*!
+     * Is the tuner choosing the buffer size, rather than the fixed mode?
+     */
+    bool enabled(void) const;
+
+    /*!
+     * Forget the rate measurement, after the buffer was re-created or the
+     * sample rate changed. The cost estimates carry over.
+     */
+    void restart(void);
+
+    /*!
+     * Record one transfer of samples, with the time spent in the refill() or
+     * push() call and in the conversion.
+     */
+    void record(const size_t samples, const unsigned long long transferNs, const unsigned long long convertNs);
+
+    /*!
+     * Have enough transfers been measured since the last restart?
+     */
+    bool settled(void) const;
+
+    /*!
+     * Get the sample rate measured since the last restart, or 0.
+     */
+    double measuredRate(void) const;
+
+    /*!
+     * Get the buffer size to use at a sample rate, given the current one.
+     * Returns the current size if there is no reason to change it.
+     */
+    size_t bufferSize(const double rate, const size_t current) const;
+
+    /*!
+     * Get the number of kernel buffers to go with a buffer size.
+     */
+    size_t kernelBuffers(const size_t bufferSize, const double rate) const;
+
+    /*!
+     * Get the estimates and settings as a JSON object.
+     */
+    std::string toJSON(const double rate, const size_t bufferSize, const size_t kernelBuffers) const;
+
+private:
+    std::string mode;
+    double targetLatencyUs;
+    double cpuBudget;
+    bool output;
+
+    //cost estimates, as moving averages over the transfers
+    double callNs;
+    double sampleNs;
+    bool haveCosts;
+
+    //rate measurement since the last restart
+    size_t transfers;
+    unsigned long long samples;
+    Clock::time_point firstTime;
+    Clock::time_point lastTime;
+};
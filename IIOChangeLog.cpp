@@ -0,0 +1,143 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include "IIOChangeLog.hpp"
+#include <time.h>
+#include <algorithm>
+#include <cmath>
+
+#include <json.hpp>
+using json = nlohmann::json;
+
+//a change that none of the refills seem to reflect, because the timestamps
+//use another clock or the rate is wrong, is placed after this long
+static const auto maxPlacementDelay = std::chrono::seconds(1);
+
+static const int noClock = -1;
+
+static long long clockNs(const int clock)
+{
+    #ifdef __linux__
+    struct timespec ts;
+    if (clock != noClock && clock_gettime(clockid_t(clock), &ts) == 0)
+    {
+        return ts.tv_sec*1000000000ll + ts.tv_nsec;
+    }
+    #else
+    (void)clock;
+    #endif
+    return -1;
+}
+
+const size_t IIOChangeLog::logLength;
+
+IIOChangeLog::IIOChangeLog(void):
+    timestampClock(noClock),
+    pending(0)
+{
+}
+
+void IIOChangeLog::setTimestampClock(const std::string &name)
+{
+    this->timestampClock = noClock;
+    #ifdef __linux__
+    //the clocks that the IIO core timestamps scans with
+    if (name == "realtime") this->timestampClock = CLOCK_REALTIME;
+    if (name == "monotonic") this->timestampClock = CLOCK_MONOTONIC;
+    if (name == "monotonic_raw") this->timestampClock = CLOCK_MONOTONIC_RAW;
+    if (name == "realtime_coarse") this->timestampClock = CLOCK_REALTIME_COARSE;
+    if (name == "monotonic_coarse") this->timestampClock = CLOCK_MONOTONIC_COARSE;
+    if (name == "boottime") this->timestampClock = CLOCK_BOOTTIME;
+    if (name == "tai") this->timestampClock = CLOCK_TAI;
+    #else
+    (void)name;
+    #endif
+}
+
+void IIOChangeLog::record(const Pothos::ObjectKwargs &update, const double rate, const bool label)
+{
+    Change change;
+    change.update = update;
+    change.wallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    change.timestampNs = clockNs(this->timestampClock);
+    change.time = Clock::now();
+    change.rate = rate;
+    change.sample = -1;
+    this->log.push_back(change);
+    if (label) this->pending++;
+    else this->clearPending();
+
+    while (this->log.size() > logLength) this->log.pop_front();
+    this->pending = std::min(this->pending, this->log.size());
+}
+
+bool IIOChangeLog::hasPending(void) const
+{
+    return this->pending != 0;
+}
+
+void IIOChangeLog::clearPending(void)
+{
+    this->pending = 0;
+}
+
+std::vector<std::pair<size_t, Pothos::Object>> IIOChangeLog::place(const size_t count,
+    const unsigned long long firstSample, const long long *timestamps, const Clock::time_point lastTime)
+{
+    std::vector<std::pair<size_t, Pothos::Object>> placed;
+    if (count == 0) return placed;
+    const auto now = Clock::now();
+
+    //changes are in time order, so stop at the first one still ahead of the refill
+    while (this->pending != 0)
+    {
+        auto &change = this->log[this->log.size() - this->pending];
+        size_t offset = 0;
+        bool ahead = false;
+        if (timestamps != nullptr && change.timestampNs >= 0)
+        {
+            offset = std::lower_bound(timestamps, timestamps + count, change.timestampNs) - timestamps;
+            ahead = (offset == count);
+        }
+        else if (lastTime != Clock::time_point() && change.rate > 0.0)
+        {
+            const double behindLast = std::chrono::duration<double>(lastTime - change.time).count();
+            const double first = (count - 1) - behindLast*change.rate;
+            ahead = (behindLast < 0.0);
+            offset = (first > 0.0) ? size_t(std::ceil(first)) : 0;
+        }
+        if (ahead)
+        {
+            if (now - change.time < maxPlacementDelay) break;
+            offset = 0;
+        }
+
+        offset = std::min(offset, count - 1);
+        change.sample = firstSample + offset;
+        this->pending--;
+
+        Pothos::ObjectKwargs data;
+        data["update"] = Pothos::Object(change.update);
+        data["timeNs"] = Pothos::Object(change.wallNs);
+        placed.emplace_back(offset, Pothos::Object(data));
+    }
+    return placed;
+}
+
+std::string IIOChangeLog::toJSON(void) const
+{
+    json changes = json::array();
+    for (const auto &change : this->log)
+    {
+        json obj;
+        obj["timeNs"] = change.wallNs;
+        if (change.timestampNs >= 0) obj["timestampNs"] = change.timestampNs;
+        json update(json::object());
+        for (const auto &entry : change.update) update[entry.first] = entry.second.toString();
+        obj["update"] = update;
+        obj["sample"] = (change.sample >= 0) ? json(change.sample) : json(nullptr);
+        changes.push_back(obj);
+    }
+    return changes.dump();
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Framework.hpp>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*!
+ * IIOChangeLog records the attribute writes of a streaming block, and finds
+ * the first sample of the stream that was taken after each of them.
+ *
+ * Every write is stamped with the wall clock, the steady clock and, if the
+ * device has one, the clock of its timestamp channel. When a refill is
+ * converted, a change lands on the first sample whose timestamp is not
+ * before the write. Without a timestamp channel, sample times are estimated
+ * from the sample rate: the last sample of a refill that had to be waited
+ * for was taken when the refill completed, and the samples of refills that
+ * were already queued are extrapolated from there. Without a sample rate,
+ * a change lands on the first sample of the next refill.
+ */
+class IIOChangeLog
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    //the number of changes that the log keeps
+    static const size_t logLength = 256;
+
+    IIOChangeLog(void);
+
+    /*!
+     * Use the clock of the device's timestamp channel, by the name in its
+     * current_timestamp_clock attribute. An empty or unknown name disables
+     * the timestamp clock.
+     */
+    void setTimestampClock(const std::string &name);
+
+    /*!
+     * Record a write of the attributes in update, at the sample rate in
+     * effect before it (0 if unknown). Changes that are not labeled are
+     * only logged.
+     */
+    void record(const Pothos::ObjectKwargs &update, const double rate, const bool label);
+
+    /*!
+     * Are there changes that were not placed yet?
+     */
+    bool hasPending(void) const;
+
+    /*!
+     * Drop the changes that were not placed yet.
+     */
+    void clearPending(void);
+
+    /*!
+     * Place the pending changes on a refill of count samples, whose first
+     * sample is the firstSample-th of the stream. The refill's sample times
+     * come from timestamps (count entries) if not null, otherwise from
+     * lastTime, the estimated time of its last sample, if that is set.
+     * Returns the offset of each change in the refill and its label data.
+     */
+    std::vector<std::pair<size_t, Pothos::Object>> place(const size_t count,
+        const unsigned long long firstSample, const long long *timestamps, const Clock::time_point lastTime);
+
+    /*!
+     * Get the logged changes as a JSON array.
+     */
+    std::string toJSON(void) const;
+
+private:
+    struct Change
+    {
+        Pothos::ObjectKwargs update;
+        long long wallNs;
+        long long timestampNs;
+        Clock::time_point time;
+        double rate;
+        long long sample;
+    };
+
+    int timestampClock;
+    std::deque<Change> log;
+    size_t pending; //the changes at the end of the log that were not placed
+};
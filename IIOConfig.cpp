@@ -0,0 +1,402 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include "IIOConfig.hpp"
+#include <Pothos/Framework.hpp>
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#include <json.hpp>
+using json = nlohmann::json;
+
+static std::string serializeValue(const json &value)
+{
+    if (value.is_string()) return value.get<std::string>();
+    if (value.is_boolean()) return value.get<bool>() ? "1" : "0";
+    if (value.is_number_integer()) return std::to_string(value.get<long long>());
+    if (value.is_number_float())
+    {
+        //sysfs integer attributes reject "1e+09" and "1000000000.0"
+        const double d = value.get<double>();
+        if (d == static_cast<double>(static_cast<long long>(d)))
+            return std::to_string(static_cast<long long>(d));
+    }
+    return value.dump();
+}
+
+template <class T>
+static bool resolveAttr(T parent, IIOConfigWrite &w)
+{
+    for (auto a : parent.attributes())
+    {
+        if (a.name() != w.attribute) continue;
+        w.write = [a](const std::string &value) mutable { a = value; };
+        w.read = [a](void) mutable { return a.value(); };
+        return true;
+    }
+    return false;
+}
+
+//channel keys may be prefixed with a direction, as in "out:voltage0",
+//to tell apart an input and an output channel that share an ID
+static bool channelMatches(IIOChannel c, const std::string &key)
+{
+    if (key.compare(0, 3, "in:") == 0) return !c.isOutput() && c.id() == key.substr(3);
+    if (key.compare(0, 4, "out:") == 0) return c.isOutput() && c.id() == key.substr(4);
+    return c.id() == key;
+}
+
+static std::string channelKey(IIOChannel c, const std::string &attribute)
+{
+    return (c.isOutput() ? "out:" : "in:") + c.id() + "/" + attribute;
+}
+
+IIOConfig::IIOConfig(IIODevice device, const std::vector<IIOChannel> &channels, const std::string &config)
+{
+    json top;
+    try
+    {
+        top = json::parse(config);
+    }
+    catch (const json::exception &ex)
+    {
+        throw Pothos::DataFormatException("IIOConfig::IIOConfig()", ex.what());
+    }
+    if (!top.is_object())
+    {
+        throw Pothos::DataFormatException("IIOConfig::IIOConfig()", "configuration must be a JSON object");
+    }
+
+    for (const auto &section : {"device", "channels"})
+    {
+        if (top.count(section) && !top[section].is_object())
+        {
+            throw Pothos::DataFormatException("IIOConfig::IIOConfig()", std::string(section) + " must be a JSON object");
+        }
+    }
+
+    //device attributes
+    if (top.count("device"))
+    {
+        for (auto it = top["device"].begin(); it != top["device"].end(); ++it)
+        {
+            IIOConfigWrite w;
+            w.attribute = it.key();
+            w.key = w.attribute;
+            w.value = serializeValue(it.value());
+            w.rank = IIOConfig::rank(w.attribute);
+            if (!resolveAttr(device, w)) w.error = "attribute not found";
+            this->writes.push_back(w);
+        }
+    }
+
+    //channel attributes, preferring the block's own channels
+    std::vector<IIOChannel> searchOrder(channels);
+    for (auto c : device.channels())
+    {
+        if (std::find(searchOrder.begin(), searchOrder.end(), c) == searchOrder.end())
+            searchOrder.push_back(c);
+    }
+    if (top.count("channels"))
+    {
+        for (auto chIt = top["channels"].begin(); chIt != top["channels"].end(); ++chIt)
+        {
+            if (!chIt.value().is_object())
+            {
+                throw Pothos::DataFormatException("IIOConfig::IIOConfig()", "channels/" + chIt.key() + " must be a JSON object");
+            }
+            for (auto it = chIt.value().begin(); it != chIt.value().end(); ++it)
+            {
+                IIOConfigWrite w;
+                w.channelId = chIt.key();
+                w.attribute = it.key();
+                w.value = serializeValue(it.value());
+                w.rank = IIOConfig::rank(w.attribute);
+                w.error = "channel not found";
+                for (auto c : searchOrder)
+                {
+                    if (!channelMatches(c, w.channelId)) continue;
+                    if (resolveAttr(c, w))
+                    {
+                        w.key = channelKey(c, w.attribute);
+                        w.error.clear();
+                        break;
+                    }
+                    w.error = "attribute not found";
+                }
+                this->writes.push_back(w);
+            }
+        }
+    }
+
+    //device attributes stay ahead of channel attributes within a rank
+    std::stable_sort(this->writes.begin(), this->writes.end(),
+        [](const IIOConfigWrite &a, const IIOConfigWrite &b)
+        {
+            if (a.rank != b.rank) return a.rank < b.rank;
+            return a.channelId.empty() && !b.channelId.empty();
+        });
+}
+
+const std::vector<IIOConfigWrite> &IIOConfig::entries(void) const
+{
+    return this->writes;
+}
+
+Pothos::ObjectKwargs IIOConfig::update(void) const
+{
+    Pothos::ObjectKwargs update;
+    for (const auto &w : this->writes)
+    {
+        if (!w.write) continue;
+        update[w.channelId.empty() ? w.attribute : w.channelId + "/" + w.attribute] = Pothos::Object(w.value);
+    }
+    return update;
+}
+
+std::string IIOConfig::apply(void) const
+{
+    json report;
+    auto &results = report["results"];
+    results = json::array();
+    size_t errors = 0;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (const auto &w : this->writes)
+    {
+        json result;
+        result["channel"] = w.channelId;
+        result["attribute"] = w.attribute;
+        result["value"] = w.value;
+
+        const auto tw = std::chrono::steady_clock::now();
+        if (!w.write)
+        {
+            result["error"] = w.error;
+        }
+        else
+        {
+            try
+            {
+                w.write(w.value);
+            }
+            catch (const Pothos::Exception &ex)
+            {
+                result["error"] = ex.displayText();
+            }
+        }
+        result["timeUs"] = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - tw).count();
+        result["ok"] = (result.count("error") == 0);
+        if (result.count("error")) errors++;
+        results.push_back(result);
+    }
+
+    report["errors"] = errors;
+    report["elapsedUs"] = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+    return report.dump();
+}
+
+int IIOConfig::rank(const std::string &attribute)
+{
+    auto has = [&attribute](const char *s){ return attribute.find(s) != std::string::npos; };
+
+    //sample rates constrain the valid bandwidth and filter settings
+    if (has("sampling_frequency") || has("samp_freq")) return 0;
+    if (has("frequency")) return 1;
+    if (has("bandwidth")) return 2;
+    //AGC must be switched to manual before a hardware gain will stick
+    if (has("gain_control_mode")) return 3;
+    if (has("gain")) return 4;
+    return 5;
+}
+
+IIOAttributeWriter::IIOAttributeWriter(IIODevice device, const std::vector<IIOChannel> &channels):
+    device(device),
+    channels(channels)
+{
+    //like IIOConfig, prefer the block's own channels
+    for (auto c : this->device.channels())
+    {
+        if (std::find(this->channels.begin(), this->channels.end(), c) == this->channels.end())
+            this->channels.push_back(c);
+    }
+}
+
+IIOConfigWrite iioResolveAttribute(IIODevice device, const std::vector<IIOChannel> &channels, const std::string &name)
+{
+    IIOConfigWrite w;
+    const auto slash = name.find('/');
+    w.attribute = (slash == std::string::npos) ? name : name.substr(slash+1);
+    w.rank = IIOConfig::rank(w.attribute);
+    if (slash == std::string::npos)
+    {
+        w.key = w.attribute;
+        resolveAttr(device, w);
+    }
+    else
+    {
+        w.channelId = name.substr(0, slash);
+        for (auto c : channels)
+        {
+            if (!channelMatches(c, w.channelId) || !resolveAttr(c, w)) continue;
+            w.key = channelKey(c, w.attribute);
+            break;
+        }
+    }
+    return w;
+}
+
+const IIOConfigWrite &IIOAttributeWriter::resolve(const std::string &name)
+{
+    auto it = this->resolved.find(name);
+    if (it != this->resolved.end()) return it->second;
+
+    const IIOConfigWrite w = iioResolveAttribute(this->device, this->channels, name);
+    if (!w.write)
+    {
+        throw Pothos::NotFoundException("IIOAttributeWriter::resolve()", "attribute not found: " + name);
+    }
+    return this->resolved.emplace(name, w).first->second;
+}
+
+void IIOAttributeWriter::apply(const Pothos::ObjectKwargs &update)
+{
+    std::vector<std::pair<const IIOConfigWrite *, std::string>> writes;
+    for (const auto &entry : update)
+    {
+        writes.emplace_back(&this->resolve(entry.first), entry.second.toString());
+    }
+    std::stable_sort(writes.begin(), writes.end(),
+        [](const std::pair<const IIOConfigWrite *, std::string> &a, const std::pair<const IIOConfigWrite *, std::string> &b)
+        {
+            return a.first->rank < b.first->rank;
+        });
+    for (const auto &w : writes) w.first->write(w.second);
+}
+
+IIOConfigProfiles::IIOConfigProfiles(void) : readBack(false), lastSwitchUs(0.0) {}
+
+void IIOConfigProfiles::load(const std::string &name, const IIOConfig &config)
+{
+    for (const auto &w : config.entries())
+    {
+        if (!w.write)
+        {
+            const std::string target = w.channelId.empty() ? "device" : w.channelId;
+            throw Pothos::InvalidArgumentException("IIOConfigProfiles::load(" + name + ")", target + "/" + w.attribute + ": " + w.error);
+        }
+    }
+
+    Profile &p = this->profiles[name];
+    p.writes = config.entries();
+    p.writeUs.assign(p.writes.size(), 0.0);
+    p.switches = 0;
+}
+
+void IIOConfigProfiles::apply(const std::string &name)
+{
+    auto it = this->profiles.find(name);
+    if (it == this->profiles.end())
+    {
+        throw Pothos::NotFoundException("IIOConfigProfiles::apply()", "no profile named " + name);
+    }
+    Profile &p = it->second;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < p.writes.size(); i++)
+    {
+        //skip a write of the same value; with read-back, only if
+        //the attribute has not been changed from elsewhere since
+        const auto &w = p.writes[i];
+        auto last = this->applied.find(w.key);
+        if (last != this->applied.end() && last->second.first == w.value)
+        {
+            if (!this->readBack) continue;
+            try
+            {
+                if (w.read() == last->second.second) continue;
+            }
+            catch (const Pothos::Exception &)
+            {
+                //write it again
+            }
+        }
+
+        const auto tw = std::chrono::steady_clock::now();
+        try
+        {
+            w.write(w.value);
+        }
+        catch (...)
+        {
+            this->invalidate();
+            throw;
+        }
+        const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - tw).count();
+
+        //remember the value, and what the device made of it if it can be read
+        auto &entry = this->applied[w.key];
+        entry.first = w.value;
+        if (this->readBack)
+        {
+            try
+            {
+                entry.second = w.read();
+            }
+            catch (const Pothos::Exception &)
+            {
+                this->applied.erase(w.key);
+            }
+        }
+
+        //exponential average of the cost of this write
+        p.writeUs[i] = (p.writeUs[i] == 0.0) ? us : (0.875*p.writeUs[i] + 0.125*us);
+    }
+    this->lastSwitchUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    p.switches++;
+}
+
+void IIOConfigProfiles::setReadBack(const bool readBack)
+{
+    this->readBack = readBack;
+}
+
+void IIOConfigProfiles::invalidate(void)
+{
+    this->applied.clear();
+}
+
+double IIOConfigProfiles::lastSwitchLatency(void) const
+{
+    return this->lastSwitchUs;
+}
+
+std::string IIOConfigProfiles::stats(void) const
+{
+    json top;
+    top["lastSwitchUs"] = this->lastSwitchUs;
+    auto &profilesObj = top["profiles"];
+    profilesObj = json::object();
+    for (const auto &entry : this->profiles)
+    {
+        const Profile &p = entry.second;
+        json profileObj;
+        profileObj["switches"] = p.switches;
+        auto &writesArray = profileObj["writes"];
+        writesArray = json::array();
+        for (size_t i = 0; i < p.writes.size(); i++)
+        {
+            json writeObj;
+            writeObj["channel"] = p.writes[i].channelId;
+            writeObj["attribute"] = p.writes[i].attribute;
+            writeObj["value"] = p.writes[i].value;
+            writeObj["avgUs"] = p.writeUs[i];
+            writesArray.push_back(writeObj);
+        }
+        profilesObj[entry.first] = profileObj;
+    }
+    return top.dump();
+}
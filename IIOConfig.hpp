@@ -0,0 +1,202 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include "IIOSupport.hpp"
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/*!
+ * IIOConfigWrite represents a single attribute write within an IIOConfig.
+ */
+struct IIOConfigWrite
+{
+    //! The channel owning the attribute, as named in the configuration
+    //! (possibly with a direction prefix), or "" for device attributes.
+    std::string channelId;
+
+    //! The name of the attribute.
+    std::string attribute;
+
+    //! The serialized value to write.
+    std::string value;
+
+    //! The position of this write in the dependency order (lower writes first).
+    int rank;
+
+    //! The resolved attribute: "attr" on the device, "in:id/attr" or "out:id/attr" on a channel.
+    std::string key;
+
+    //! Performs the write, or is empty if the attribute could not be resolved.
+    std::function<void(const std::string &)> write;
+
+    //! Reads the attribute's current value back.
+    std::function<std::string(void)> read;
+
+    //! The reason the attribute could not be resolved.
+    std::string error;
+};
+
+/*!
+ * IIOConfig is a batch of device and channel attribute writes.
+ *
+ * The batch is described as a JSON object of the form
+ * {"device": {"attr": value, ...}, "channels": {"id": {"attr": value, ...}, ...}}
+ * and is applied in dependency order: sample rates first, then LO
+ * frequencies, bandwidths, gain modes, gains and finally everything else.
+ * Any active IIO buffer is left in place while the batch is applied.
+ */
+class IIOConfig
+{
+private:
+    std::vector<IIOConfigWrite> writes;
+
+public:
+    /*!
+     * Parse a JSON configuration against the given device.
+     *
+     * Channel IDs are looked up in the given channels first and then in the
+     * rest of the device, so that a source block can also reach attributes
+     * on the device's output channels (e.g. an LO on altvoltage0). An ID
+     * prefixed with "in:" or "out:" only matches the input or the output
+     * channel, for devices where both share an ID.
+     * Unknown attributes are not fatal; they are reported by apply().
+     * Malformed JSON, or sections and channel entries that are not JSON
+     * objects, throw a Pothos::DataFormatException.
+     */
+    IIOConfig(IIODevice device, const std::vector<IIOChannel> &channels, const std::string &config);
+
+    /*!
+     * Get the writes in this configuration, in the order they will be applied.
+     */
+    const std::vector<IIOConfigWrite> &entries(void) const;
+
+    /*!
+     * Get the resolved writes as an attribute update, with the names that
+     * IIOAttributeWriter uses.
+     */
+    Pothos::ObjectKwargs update(void) const;
+
+    /*!
+     * Apply every write in this configuration.
+     *
+     * Errors are collected rather than thrown. The return value is a JSON
+     * report with a per-attribute status and timing, the number of errors and
+     * the total elapsed time in microseconds.
+     */
+    std::string apply(void) const;
+
+    /*!
+     * Get the dependency rank of an attribute name.
+     */
+    static int rank(const std::string &attribute);
+};
+
+/*!
+ * Resolve an attribute name: "attr" on the device, or "channelId/attr" on
+ * the first of the given channels with that ID that has the attribute.
+ * As in an IIOConfig, the channel ID may be prefixed with "in:" or "out:".
+ * The write and read of the result are empty if nothing matched.
+ */
+IIOConfigWrite iioResolveAttribute(IIODevice device, const std::vector<IIOChannel> &channels, const std::string &name);
+
+/*!
+ * IIOAttributeWriter applies compact attribute updates, such as those that
+ * the streaming blocks receive on their "attr" message port.
+ *
+ * An update is a dictionary of attribute names to values. Device attributes
+ * are named "attr" and channel attributes "channelId/attr", the same names
+ * the attribute monitor reports, so that measured values can be fed back.
+ * As in an IIOConfig, the channel ID may be prefixed with "in:" or "out:".
+ * Each name is resolved the first time it is seen and cached, so that a
+ * stream of updates only writes. The writes of one update are applied in
+ * dependency order, like an IIOConfig.
+ */
+class IIOAttributeWriter
+{
+private:
+    IIODevice device;
+    std::vector<IIOChannel> channels;
+    std::map<std::string, IIOConfigWrite> resolved;
+
+    const IIOConfigWrite &resolve(const std::string &name);
+
+public:
+    IIOAttributeWriter(IIODevice device, const std::vector<IIOChannel> &channels);
+
+    /*!
+     * Apply an update. Unknown attributes throw a Pothos::NotFoundException
+     * before anything is written; failed writes are rethrown.
+     */
+    void apply(const Pothos::ObjectKwargs &update);
+};
+
+/*!
+ * IIOConfigProfiles holds named, pre-resolved configurations that can be
+ * switched between with a single call.
+ *
+ * Profiles are validated when they are loaded, so switching never parses
+ * JSON or searches attribute lists. A switch skips an attribute that the
+ * last switch set to the same value. With read-back enabled, such an
+ * attribute is read first and only skipped if it still reads back what it
+ * did after that write, so that changes made from elsewhere are written
+ * over at the cost of a read per attribute.
+ */
+class IIOConfigProfiles
+{
+private:
+    struct Profile
+    {
+        std::vector<IIOConfigWrite> writes;
+        std::vector<double> writeUs;
+        unsigned long long switches;
+    };
+    std::map<std::string, Profile> profiles;
+
+    //by attribute key, the value last written and the value read back after it
+    std::map<std::string, std::pair<std::string, std::string>> applied;
+    bool readBack;
+    double lastSwitchUs;
+
+public:
+    IIOConfigProfiles(void);
+
+    /*!
+     * Store the given configuration under a name, replacing any existing
+     * profile with that name. Throws a Pothos::InvalidArgumentException if
+     * any of the configuration's attributes could not be resolved.
+     */
+    void load(const std::string &name, const IIOConfig &config);
+
+    /*!
+     * Apply the named profile. Throws a Pothos::NotFoundException for an
+     * unknown name, and rethrows the first failed write.
+     */
+    void apply(const std::string &name);
+
+    /*!
+     * Check attributes that would be skipped by reading them back (off by
+     * default).
+     */
+    void setReadBack(const bool readBack);
+
+    /*!
+     * Forget which attribute values were last written, so that the next
+     * switch writes every attribute. Call this whenever attributes are
+     * written through any other path, unless read-back is enabled.
+     */
+    void invalidate(void);
+
+    /*!
+     * Get the duration of the last switch in microseconds.
+     */
+    double lastSwitchLatency(void) const;
+
+    /*!
+     * Get a JSON summary of the loaded profiles, their write order and the
+     * measured per-attribute write times.
+     */
+    std::string stats(void) const;
+};
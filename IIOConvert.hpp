@@ -0,0 +1,671 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <iio.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/***********************************************************************
+ * Sample conversion between an IIO scan buffer and host memory.
+ *
+ * These routines follow libiio's iio_channel_convert() rules: samples are
+ * byte swapped to host order, shifted right by the format's shift and, for
+ * formats that are not fully defined, sign extended or masked to the
+ * format's bits. The loops are split by the work they have to do so that the
+ * common cases compile to straight strided copies.
+ **********************************************************************/
+
+static inline bool iioHostIsBigEndian(void)
+{
+    const uint16_t probe = 1;
+    uint8_t first;
+    std::memcpy(&first, &probe, 1);
+    return first == 0;
+}
+
+static inline uint8_t iioByteSwap(uint8_t v) { return v; }
+static inline uint16_t iioByteSwap(uint16_t v) { return uint16_t((v >> 8) | (v << 8)); }
+static inline uint32_t iioByteSwap(uint32_t v)
+{
+    return ((v & 0x000000ffu) << 24) | ((v & 0x0000ff00u) << 8) |
+        ((v & 0x00ff0000u) >> 8) | ((v & 0xff000000u) >> 24);
+}
+static inline uint64_t iioByteSwap(uint64_t v)
+{
+    return (uint64_t(iioByteSwap(uint32_t(v))) << 32) | iioByteSwap(uint32_t(v >> 32));
+}
+
+/*!
+ * Check if converting samples of this format involves more than a copy.
+ */
+static inline bool iioFormatIsPlain(const struct iio_data_format &fmt)
+{
+    return fmt.is_be == iioHostIsBigEndian() && fmt.shift == 0 &&
+        (fmt.is_fully_defined || fmt.bits == fmt.length);
+}
+
+/*!
+ * Get the number of bytes one sample of this format occupies in a scan.
+ */
+static inline size_t iioFormatBytes(const struct iio_data_format &fmt)
+{
+    return (fmt.length/8)*(fmt.repeat ? fmt.repeat : 1);
+}
+
+/*!
+ * Format a sample format as a scan element type, e.g. "le:s12/16>>4".
+ */
+static inline std::string iioFormatToString(const struct iio_data_format &fmt)
+{
+    std::string type = fmt.is_be ? "be:" : "le:";
+    type += fmt.is_signed ? (fmt.is_fully_defined ? "S" : "s") : (fmt.is_fully_defined ? "U" : "u");
+    type += std::to_string(fmt.bits) + "/" + std::to_string(fmt.length);
+    if (fmt.repeat > 1) type += "X" + std::to_string(fmt.repeat);
+    type += ">>" + std::to_string(fmt.shift);
+    return type;
+}
+
+/*!
+ * Parse a scan element type such as "le:s12/16>>4" or "be:U16/16X2>>0".
+ * Returns false if the type is malformed.
+ */
+static inline bool iioFormatFromString(const std::string &type, struct iio_data_format &fmt)
+{
+    std::memset(&fmt, 0, sizeof(fmt));
+    char endian[3] = {0}, sign = 0;
+    unsigned bits = 0, length = 0, repeat = 1, shift = 0;
+    if (std::sscanf(type.c_str(), "%2[bel]:%c%u/%uX%u>>%u", endian, &sign, &bits, &length, &repeat, &shift) != 6)
+    {
+        repeat = 1;
+        if (std::sscanf(type.c_str(), "%2[bel]:%c%u/%u>>%u", endian, &sign, &bits, &length, &shift) != 5) return false;
+    }
+    fmt.length = length;
+    fmt.bits = bits;
+    fmt.shift = shift;
+    fmt.repeat = repeat;
+    fmt.is_be = (std::string(endian) == "be");
+    fmt.is_signed = (sign == 's' || sign == 'S');
+    fmt.is_fully_defined = (sign == 'S' || sign == 'U' || bits == length);
+    return true;
+}
+
+template <typename T>
+static inline T iioConvertIn(T v, const struct iio_data_format &fmt, const bool swap)
+{
+    if (swap) v = iioByteSwap(v);
+    v = T(v >> fmt.shift);
+    if (!fmt.is_fully_defined && fmt.bits < sizeof(T)*8)
+    {
+        const T mask = T((T(1) << fmt.bits) - 1);
+        v &= mask;
+        if (fmt.is_signed && fmt.bits > 0 && ((v >> (fmt.bits - 1)) & 1)) v |= T(~mask);
+    }
+    return v;
+}
+
+template <typename T>
+static inline T iioConvertOut(T v, const struct iio_data_format &fmt, const bool swap)
+{
+    if (!fmt.is_fully_defined && fmt.bits < sizeof(T)*8)
+    {
+        v &= T((T(1) << fmt.bits) - 1);
+    }
+    v = T(v << fmt.shift);
+    if (swap) v = iioByteSwap(v);
+    return v;
+}
+
+template <typename T>
+static inline void iioDeinterleaveT(const struct iio_data_format &fmt, const uint8_t *src, const ptrdiff_t step, T *dst, const size_t count, const size_t repeat)
+{
+    if (iioFormatIsPlain(fmt))
+    {
+        for (size_t i = 0; i < count; i++, src += step)
+        {
+            for (size_t r = 0; r < repeat; r++) std::memcpy(dst++, src + r*sizeof(T), sizeof(T));
+        }
+        return;
+    }
+    const bool swap = fmt.is_be != iioHostIsBigEndian();
+    for (size_t i = 0; i < count; i++, src += step)
+    {
+        for (size_t r = 0; r < repeat; r++)
+        {
+            T v; std::memcpy(&v, src + r*sizeof(T), sizeof(T));
+            *dst++ = iioConvertIn(v, fmt, swap);
+        }
+    }
+}
+
+template <typename T>
+static inline void iioInterleaveT(const struct iio_data_format &fmt, const T *src, uint8_t *dst, const ptrdiff_t step, const size_t count, const size_t repeat)
+{
+    if (iioFormatIsPlain(fmt))
+    {
+        for (size_t i = 0; i < count; i++, dst += step)
+        {
+            for (size_t r = 0; r < repeat; r++) std::memcpy(dst + r*sizeof(T), src++, sizeof(T));
+        }
+        return;
+    }
+    const bool swap = fmt.is_be != iioHostIsBigEndian();
+    for (size_t i = 0; i < count; i++, dst += step)
+    {
+        for (size_t r = 0; r < repeat; r++)
+        {
+            const T v = iioConvertOut(*src++, fmt, swap);
+            std::memcpy(dst + r*sizeof(T), &v, sizeof(T));
+        }
+    }
+}
+
+/*!
+ * Copy count samples of one channel out of a scan buffer into dst,
+ * converting them to host format.
+ *
+ * first points at the channel's first sample and step is the size of a scan.
+ * Returns the number of bytes written to dst.
+ */
+static inline size_t iioDeinterleave(const struct iio_data_format &fmt, const void *first, const ptrdiff_t step, void *dst, const size_t count)
+{
+    const auto src = static_cast<const uint8_t *>(first);
+    const size_t repeat = fmt.repeat ? fmt.repeat : 1;
+    switch (fmt.length)
+    {
+    case 8: iioDeinterleaveT(fmt, src, step, static_cast<uint8_t *>(dst), count, repeat); break;
+    case 16: iioDeinterleaveT(fmt, src, step, static_cast<uint16_t *>(dst), count, repeat); break;
+    case 32: iioDeinterleaveT(fmt, src, step, static_cast<uint32_t *>(dst), count, repeat); break;
+    case 64: iioDeinterleaveT(fmt, src, step, static_cast<uint64_t *>(dst), count, repeat); break;
+    default:
+    {
+        //odd sized samples are copied as raw bytes
+        const size_t bytes = iioFormatBytes(fmt);
+        auto out = static_cast<uint8_t *>(dst);
+        for (size_t i = 0; i < count; i++, out += bytes) std::memcpy(out, src + i*step, bytes);
+    }
+    }
+    return count*iioFormatBytes(fmt);
+}
+
+/*!
+ * Copy count samples of one channel from src into a scan buffer,
+ * converting them from host format.
+ *
+ * first points at the channel's first sample and step is the size of a scan.
+ * Returns the number of bytes read from src.
+ */
+static inline size_t iioInterleave(const struct iio_data_format &fmt, const void *src, void *first, const ptrdiff_t step, const size_t count)
+{
+    const auto dst = static_cast<uint8_t *>(first);
+    const size_t repeat = fmt.repeat ? fmt.repeat : 1;
+    switch (fmt.length)
+    {
+    case 8: iioInterleaveT(fmt, static_cast<const uint8_t *>(src), dst, step, count, repeat); break;
+    case 16: iioInterleaveT(fmt, static_cast<const uint16_t *>(src), dst, step, count, repeat); break;
+    case 32: iioInterleaveT(fmt, static_cast<const uint32_t *>(src), dst, step, count, repeat); break;
+    case 64: iioInterleaveT(fmt, static_cast<const uint64_t *>(src), dst, step, count, repeat); break;
+    default:
+    {
+        //odd sized samples are copied as raw bytes
+        const size_t bytes = iioFormatBytes(fmt);
+        auto in = static_cast<const uint8_t *>(src);
+        for (size_t i = 0; i < count; i++, in += bytes) std::memcpy(dst + i*step, in, bytes);
+    }
+    }
+    return count*iioFormatBytes(fmt);
+}
+
+template <typename T>
+static inline size_t iioFindCrossingT(const T *samples, const size_t count, const size_t repeat, const double level, const bool rising, double &last)
+{
+    //an integer sample crosses a fractional level at its ceiling (rising)
+    //or floor (falling); levels outside the type's range are never crossed
+    const double threshold = rising ? std::ceil(level) : std::floor(level);
+    const bool inRange = rising ?
+        (threshold > double(std::numeric_limits<T>::min()) && threshold <= double(std::numeric_limits<T>::max())) :
+        (threshold >= double(std::numeric_limits<T>::min()) && threshold < double(std::numeric_limits<T>::max()));
+    if (count == 0) return 0;
+    if (!inRange)
+    {
+        last = double(samples[(count-1)*repeat]);
+        return count;
+    }
+
+    const T thresh = T(threshold);
+    size_t i = 0;
+    T prev;
+    if (std::isnan(last)) prev = samples[i++*repeat];
+    else prev = rising ? ((last < threshold) ? T(thresh - 1) : thresh) : ((last > threshold) ? T(thresh + 1) : thresh);
+    for (; i < count; i++)
+    {
+        const T cur = samples[i*repeat];
+        if (rising ? (prev < thresh && cur >= thresh) : (prev > thresh && cur <= thresh))
+        {
+            last = double(cur);
+            return i;
+        }
+        prev = cur;
+    }
+    last = double(prev);
+    return count;
+}
+
+/*!
+ * Find the first of count host format samples of one channel, as written by
+ * iioDeinterleave(), that crosses level in the rising or falling direction.
+ *
+ * last carries the previous sample between calls and is updated; pass NaN
+ * when there is no previous sample. Only the first element of repeated
+ * samples is compared. Returns count if there is no crossing, or if the
+ * format is not an 8, 16, 32 or 64 bit integer.
+ */
+static inline size_t iioFindCrossing(const struct iio_data_format &fmt, const void *samples, const size_t count, const double level, const bool rising, double &last)
+{
+    const size_t repeat = fmt.repeat ? fmt.repeat : 1;
+    switch (fmt.length)
+    {
+    case 8: return fmt.is_signed ?
+        iioFindCrossingT(static_cast<const int8_t *>(samples), count, repeat, level, rising, last) :
+        iioFindCrossingT(static_cast<const uint8_t *>(samples), count, repeat, level, rising, last);
+    case 16: return fmt.is_signed ?
+        iioFindCrossingT(static_cast<const int16_t *>(samples), count, repeat, level, rising, last) :
+        iioFindCrossingT(static_cast<const uint16_t *>(samples), count, repeat, level, rising, last);
+    case 32: return fmt.is_signed ?
+        iioFindCrossingT(static_cast<const int32_t *>(samples), count, repeat, level, rising, last) :
+        iioFindCrossingT(static_cast<const uint32_t *>(samples), count, repeat, level, rising, last);
+    case 64: return fmt.is_signed ?
+        iioFindCrossingT(static_cast<const int64_t *>(samples), count, repeat, level, rising, last) :
+        iioFindCrossingT(static_cast<const uint64_t *>(samples), count, repeat, level, rising, last);
+    default: return count;
+    }
+}
+
+/*!
+ * The state of a decimating conversion of one channel: a CIC filter of the
+ * given order, which for order 1 is a block average (integrate-and-dump).
+ *
+ * Integrators and combs run in modulo 2^64 arithmetic, so intermediate
+ * overflow cancels out as long as the output, including the gain of
+ * factor^order, fits in 63 bits. Outputs are divided by that gain and so
+ * have the same scale as the input samples.
+ */
+struct IIODecimator
+{
+    IIODecimator(const size_t factor = 1, const size_t order = 1, const size_t repeat = 1):
+        factor(factor), order(order), phase(0), gain(1),
+        integrators(order*repeat, 0), combs(order*repeat, 0)
+    {
+        for (size_t i = 0; i < order; i++) gain *= factor;
+    }
+
+    size_t factor;
+    size_t order;
+    size_t phase;
+    uint64_t gain;
+    std::vector<uint64_t> integrators;
+    std::vector<uint64_t> combs;
+};
+
+/*!
+ * Check that a decimator's output fits in 63 bits for samples of this format.
+ */
+static inline bool iioDecimatorFits(const struct iio_data_format &fmt, const size_t factor, const size_t order)
+{
+    size_t growth = 0;
+    while ((size_t(1) << growth) < factor) growth++;
+    return fmt.length <= 64 && fmt.bits + order*growth <= 63;
+}
+
+template <typename T>
+static inline uint64_t iioDecimatorInput(const uint8_t *src, const struct iio_data_format &fmt, const bool plain, const bool swap)
+{
+    typedef typename std::make_signed<T>::type S;
+    T v; std::memcpy(&v, src, sizeof(T));
+    if (!plain) v = iioConvertIn(v, fmt, swap);
+    return fmt.is_signed ? uint64_t(int64_t(S(v))) : uint64_t(v);
+}
+
+template <typename T>
+static inline size_t iioDeinterleaveDecimateT(const struct iio_data_format &fmt, const uint8_t *src, const ptrdiff_t step, IIODecimator &d, T *dst, const size_t count, const size_t repeat)
+{
+    const bool plain = iioFormatIsPlain(fmt);
+    const bool swap = fmt.is_be != iioHostIsBigEndian();
+    const size_t order = d.order;
+    uint64_t *integ = d.integrators.data();
+    uint64_t *comb = d.combs.data();
+    size_t produced = 0;
+    for (size_t i = 0; i < count;)
+    {
+        //integrate the rest of the current block at the input rate
+        const size_t n = std::min(count - i, d.factor - d.phase);
+        for (size_t r = 0; r < repeat; r++)
+        {
+            const uint8_t *p = src + r*sizeof(T);
+            uint64_t *acc = integ + r*order;
+            if (order == 1)
+            {
+                //a plain reduction, which the compiler can vectorize
+                uint64_t sum = 0;
+                for (size_t j = 0; j < n; j++) sum += iioDecimatorInput<T>(p + j*step, fmt, plain, swap);
+                acc[0] += sum;
+                continue;
+            }
+            for (size_t j = 0; j < n; j++)
+            {
+                uint64_t x = iioDecimatorInput<T>(p + j*step, fmt, plain, swap);
+                for (size_t k = 0; k < order; k++) x = (acc[k] += x);
+            }
+        }
+        i += n;
+        src += n*step;
+        d.phase += n;
+        if (d.phase != d.factor) continue;
+        d.phase = 0;
+
+        //comb and scale at the output rate
+        for (size_t r = 0; r < repeat; r++)
+        {
+            uint64_t y = integ[r*order + order-1];
+            uint64_t *delay = comb + r*order;
+            for (size_t k = 0; k < order; k++)
+            {
+                const uint64_t prev = delay[k];
+                delay[k] = y;
+                y -= prev;
+            }
+            *dst++ = fmt.is_signed ? T(int64_t(y)/int64_t(d.gain)) : T(y/d.gain);
+        }
+        produced++;
+    }
+    return produced;
+}
+
+/*!
+ * Convert count samples of one channel out of a scan buffer like
+ * iioDeinterleave(), decimating them on the way with the given state.
+ * Returns the number of output samples written to dst, which carries the
+ * remainder of a partial decimation block over to the next call.
+ */
+static inline size_t iioDeinterleaveDecimate(const struct iio_data_format &fmt, const void *first, const ptrdiff_t step, IIODecimator &d, void *dst, const size_t count)
+{
+    const auto src = static_cast<const uint8_t *>(first);
+    const size_t repeat = fmt.repeat ? fmt.repeat : 1;
+    switch (fmt.length)
+    {
+    case 8: return iioDeinterleaveDecimateT(fmt, src, step, d, static_cast<uint8_t *>(dst), count, repeat);
+    case 16: return iioDeinterleaveDecimateT(fmt, src, step, d, static_cast<uint16_t *>(dst), count, repeat);
+    case 32: return iioDeinterleaveDecimateT(fmt, src, step, d, static_cast<uint32_t *>(dst), count, repeat);
+    case 64: return iioDeinterleaveDecimateT(fmt, src, step, d, static_cast<uint64_t *>(dst), count, repeat);
+    default: return 0;
+    }
+}
+
+/*!
+ * The correction of one port's samples for the DC offset and gain of a
+ * device and, for I/Q pairs, the amplitude and phase imbalance between
+ * its I and Q paths.
+ *
+ * Samples are corrected as M*(x - offset) in both directions, where M is
+ * the matrix [[ii, 0], [qi, qq]] for I/Q pairs and ii for other samples.
+ * For a device that reads or writes E*x + offset in place of x, M = E^-1
+ * turns the samples read from it back into x, and pre-distorts the
+ * samples written to it so that it writes x.
+ */
+struct IIOCorrection
+{
+    IIOCorrection(void):
+        offsetI(0.0), offsetQ(0.0), ii(1.0), qi(0.0), qq(1.0), iq(false)
+    {
+    }
+
+    double offsetI;
+    double offsetQ;
+    double ii;
+    double qi;
+    double qq;
+    bool iq;
+};
+
+/*!
+ * Make the correction for a device whose samples are off by offsetI and
+ * offsetQ, which is to be scaled by gain and, if iq is set, whose Q path
+ * has the given amplitude relative to the I path and is phase degrees off
+ * quadrature.
+ */
+static inline IIOCorrection iioCorrection(const double gain, const double offsetI, const double offsetQ,
+    const bool iq, const double amplitude, const double phase)
+{
+    IIOCorrection c;
+    c.offsetI = offsetI;
+    c.offsetQ = iq ? offsetQ : offsetI;
+    c.ii = gain;
+    c.iq = iq;
+    if (!iq) return c;
+
+    //Q = a*(sin(t)*cos(p) + cos(t)*sin(p)) is rotated back onto sin(t)
+    const double p = phase*std::atan(1.0)/45.0;
+    c.qi = -gain*std::tan(p);
+    c.qq = gain/(amplitude*std::cos(p));
+    return c;
+}
+
+/*!
+ * Check if a correction leaves samples as they are.
+ */
+static inline bool iioCorrectionIsIdentity(const IIOCorrection &c)
+{
+    return c.offsetI == 0.0 && c.offsetQ == 0.0 && c.ii == 1.0 && c.qi == 0.0 && c.qq == 1.0;
+}
+
+/*!
+ * A correction in the arithmetic used for samples of type T, which is signed
+ * for signed formats: single precision for samples of up to 16 bits, so
+ * that the loops vectorize twice as wide, and double precision otherwise.
+ * Results are rounded and saturated to the format's bits, so they never wrap.
+ */
+template <typename T>
+struct IIOCorrectionKernel
+{
+    typedef typename std::conditional<sizeof(T) <= 2, float, double>::type F;
+
+    IIOCorrectionKernel(const IIOCorrection &c, const struct iio_data_format &fmt):
+        offsetI(F(c.offsetI)), offsetQ(F(c.offsetQ)), ii(F(c.ii)), qi(F(c.qi)), qq(F(c.qq)),
+        iq(c.iq && fmt.repeat == 2)
+    {
+        //the largest value below 2^magnitude that F represents exactly
+        const size_t bits = (fmt.bits > 0 && fmt.bits < sizeof(T)*8) ? fmt.bits : sizeof(T)*8;
+        const int magnitude = int(std::is_signed<T>::value ? bits - 1 : bits);
+        this->hi = (magnitude < std::numeric_limits<F>::digits) ? std::ldexp(F(1), magnitude) - F(1) :
+            std::nextafter(std::ldexp(F(1), magnitude), F(0));
+        this->lo = std::is_signed<T>::value ? -std::ldexp(F(1), magnitude) : F(0);
+    }
+
+    //rounds half away from zero with a truncating conversion, which vectorizes
+    T sample(F v) const
+    {
+        v = std::min(std::max(v, this->lo), this->hi);
+        return T(v + ((v < F(0)) ? F(-0.5) : F(0.5)));
+    }
+
+    F offsetI, offsetQ, ii, qi, qq, lo, hi;
+    bool iq;
+};
+
+template <typename T, bool Plain>
+static inline T iioCorrectionInput(const uint8_t *src, const struct iio_data_format &fmt, const bool swap)
+{
+    typedef typename std::make_unsigned<T>::type U;
+    U v; std::memcpy(&v, src, sizeof(U));
+    return T(Plain ? v : iioConvertIn(v, fmt, swap));
+}
+
+template <typename T, bool Plain>
+static inline void iioCorrectionOutput(uint8_t *dst, const T sample, const struct iio_data_format &fmt, const bool swap)
+{
+    typedef typename std::make_unsigned<T>::type U;
+    const U v = Plain ? U(sample) : iioConvertOut(U(sample), fmt, swap);
+    std::memcpy(dst, &v, sizeof(U));
+}
+
+template <typename T, bool Plain>
+static inline void iioDeinterleaveCorrectT(const struct iio_data_format &fmt, const uint8_t *src, const ptrdiff_t step, const IIOCorrection &c, T *dst, const size_t count, const size_t repeat)
+{
+    const IIOCorrectionKernel<T> k(c, fmt);
+    const bool swap = fmt.is_be != iioHostIsBigEndian();
+    if (k.iq)
+    {
+        for (size_t i = 0; i < count; i++, src += step, dst += 2)
+        {
+            const auto x = iioCorrectionInput<T, Plain>(src, fmt, swap) - k.offsetI;
+            const auto y = iioCorrectionInput<T, Plain>(src + sizeof(T), fmt, swap) - k.offsetQ;
+            dst[0] = k.sample(k.ii*x);
+            dst[1] = k.sample(k.qi*x + k.qq*y);
+        }
+        return;
+    }
+    //an inner loop, even of one iteration, keeps the outer loop from vectorizing
+    if (repeat == 1)
+    {
+        for (size_t i = 0; i < count; i++, src += step)
+        {
+            *dst++ = k.sample(k.ii*(iioCorrectionInput<T, Plain>(src, fmt, swap) - k.offsetI));
+        }
+        return;
+    }
+    for (size_t i = 0; i < count; i++, src += step)
+    {
+        for (size_t r = 0; r < repeat; r++)
+        {
+            *dst++ = k.sample(k.ii*(iioCorrectionInput<T, Plain>(src + r*sizeof(T), fmt, swap) - k.offsetI));
+        }
+    }
+}
+
+template <typename T>
+static inline void iioDeinterleaveCorrectT(const struct iio_data_format &fmt, const uint8_t *src, const ptrdiff_t step, const IIOCorrection &c, T *dst, const size_t count, const size_t repeat)
+{
+    if (iioFormatIsPlain(fmt)) iioDeinterleaveCorrectT<T, true>(fmt, src, step, c, dst, count, repeat);
+    else iioDeinterleaveCorrectT<T, false>(fmt, src, step, c, dst, count, repeat);
+}
+
+template <typename T, bool Plain>
+static inline void iioInterleaveCorrectT(const struct iio_data_format &fmt, const T *src, const IIOCorrection &c, uint8_t *dst, const ptrdiff_t step, const size_t count, const size_t repeat)
+{
+    const IIOCorrectionKernel<T> k(c, fmt);
+    const bool swap = fmt.is_be != iioHostIsBigEndian();
+    if (k.iq)
+    {
+        for (size_t i = 0; i < count; i++, dst += step, src += 2)
+        {
+            const auto x = typename IIOCorrectionKernel<T>::F(src[0]) - k.offsetI;
+            const auto y = typename IIOCorrectionKernel<T>::F(src[1]) - k.offsetQ;
+            iioCorrectionOutput<T, Plain>(dst, k.sample(k.ii*x), fmt, swap);
+            iioCorrectionOutput<T, Plain>(dst + sizeof(T), k.sample(k.qi*x + k.qq*y), fmt, swap);
+        }
+        return;
+    }
+    if (repeat == 1)
+    {
+        for (size_t i = 0; i < count; i++, dst += step)
+        {
+            iioCorrectionOutput<T, Plain>(dst, k.sample(k.ii*(*src++ - k.offsetI)), fmt, swap);
+        }
+        return;
+    }
+    for (size_t i = 0; i < count; i++, dst += step)
+    {
+        for (size_t r = 0; r < repeat; r++)
+        {
+            iioCorrectionOutput<T, Plain>(dst + r*sizeof(T), k.sample(k.ii*(*src++ - k.offsetI)), fmt, swap);
+        }
+    }
+}
+
+template <typename T>
+static inline void iioInterleaveCorrectT(const struct iio_data_format &fmt, const T *src, const IIOCorrection &c, uint8_t *dst, const ptrdiff_t step, const size_t count, const size_t repeat)
+{
+    if (iioFormatIsPlain(fmt)) iioInterleaveCorrectT<T, true>(fmt, src, c, dst, step, count, repeat);
+    else iioInterleaveCorrectT<T, false>(fmt, src, c, dst, step, count, repeat);
+}
+
+template <typename U>
+static inline void iioDeinterleaveCorrectU(const struct iio_data_format &fmt, const uint8_t *src, const ptrdiff_t step, const IIOCorrection &c, void *dst, const size_t count, const size_t repeat)
+{
+    typedef typename std::make_signed<U>::type S;
+    if (fmt.is_signed) iioDeinterleaveCorrectT(fmt, src, step, c, static_cast<S *>(dst), count, repeat);
+    else iioDeinterleaveCorrectT(fmt, src, step, c, static_cast<U *>(dst), count, repeat);
+}
+
+template <typename U>
+static inline void iioInterleaveCorrectU(const struct iio_data_format &fmt, const void *src, const IIOCorrection &c, uint8_t *dst, const ptrdiff_t step, const size_t count, const size_t repeat)
+{
+    typedef typename std::make_signed<U>::type S;
+    if (fmt.is_signed) iioInterleaveCorrectT(fmt, static_cast<const S *>(src), c, dst, step, count, repeat);
+    else iioInterleaveCorrectT(fmt, static_cast<const U *>(src), c, dst, step, count, repeat);
+}
+
+/*!
+ * Convert count samples of one channel out of a scan buffer like
+ * iioDeinterleave(), correcting them in the same pass. Formats other than
+ * 8, 16, 32 or 64 bit integers are copied uncorrected.
+ * Returns the number of bytes written to dst.
+ */
+static inline size_t iioDeinterleaveCorrect(const struct iio_data_format &fmt, const void *first, const ptrdiff_t step, const IIOCorrection &c, void *dst, const size_t count)
+{
+    const auto src = static_cast<const uint8_t *>(first);
+    const size_t repeat = fmt.repeat ? fmt.repeat : 1;
+    switch (fmt.length)
+    {
+    case 8: iioDeinterleaveCorrectU<uint8_t>(fmt, src, step, c, dst, count, repeat); break;
+    case 16: iioDeinterleaveCorrectU<uint16_t>(fmt, src, step, c, dst, count, repeat); break;
+    case 32: iioDeinterleaveCorrectU<uint32_t>(fmt, src, step, c, dst, count, repeat); break;
+    case 64: iioDeinterleaveCorrectU<uint64_t>(fmt, src, step, c, dst, count, repeat); break;
+    default: return iioDeinterleave(fmt, first, step, dst, count);
+    }
+    return count*iioFormatBytes(fmt);
+}
+
+/*!
+ * Copy count samples of one channel from src into a scan buffer like
+ * iioInterleave(), correcting them in the same pass. Formats other than
+ * 8, 16, 32 or 64 bit integers are copied uncorrected.
+ * Returns the number of bytes read from src.
+ */
+static inline size_t iioInterleaveCorrect(const struct iio_data_format &fmt, const void *src, const IIOCorrection &c, void *first, const ptrdiff_t step, const size_t count)
+{
+    const auto dst = static_cast<uint8_t *>(first);
+    const size_t repeat = fmt.repeat ? fmt.repeat : 1;
+    switch (fmt.length)
+    {
+    case 8: iioInterleaveCorrectU<uint8_t>(fmt, src, c, dst, step, count, repeat); break;
+    case 16: iioInterleaveCorrectU<uint16_t>(fmt, src, c, dst, step, count, repeat); break;
+    case 32: iioInterleaveCorrectU<uint32_t>(fmt, src, c, dst, step, count, repeat); break;
+    case 64: iioInterleaveCorrectU<uint64_t>(fmt, src, c, dst, step, count, repeat); break;
+    default: return iioInterleave(fmt, src, first, step, count);
+    }
+    return count*iioFormatBytes(fmt);
+}
+
+/*!
+ * Correct count host format samples of one channel in place, as read from
+ * a device. The decimating conversion uses this on its output, which is
+ * the same as correcting its input since the correction is affine.
+ */
+static inline void iioCorrect(const struct iio_data_format &fmt, const IIOCorrection &c, void *samples, const size_t count)
+{
+    //host format samples read like a scan of one plain sample
+    struct iio_data_format host = fmt;
+    host.is_be = iioHostIsBigEndian();
+    host.shift = 0;
+    host.is_fully_defined = true;
+    iioDeinterleaveCorrect(host, samples, ptrdiff_t(iioFormatBytes(fmt)), c, samples, count);
+}
@@ -0,0 +1,185 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include "IIODeviceCache.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <thread>
+#ifdef __linux__
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+//invalidation count of each device ID, shared with invalidate()
+static std::mutex generationsMutex;
+static std::map<std::string, unsigned long long> generations;
+
+static unsigned long long generation(const std::string &deviceId)
+{
+    auto it = generations.find(deviceId);
+    return (it == generations.end()) ? 0 : it->second;
+}
+
+//maximum age of an entry, with and without uevent notifications
+static const std::chrono::seconds maxAgeWithEvents(30);
+static const std::chrono::seconds maxAgeWithoutEvents(2);
+
+IIODeviceCache::IIODeviceCache(void) : ueventFd(-1)
+{
+    #ifdef __linux__
+    //kernel uevents only describe the devices of the local context
+    if (IIOContext::get().name() != "local") return;
+    this->ueventFd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (this->ueventFd < 0) return;
+    struct sockaddr_nl addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1; //kernel broadcast group
+    if (bind(this->ueventFd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+        close(this->ueventFd);
+        this->ueventFd = -1;
+    }
+    #endif
+}
+
+IIODeviceCache::~IIODeviceCache(void)
+{
+    #ifdef __linux__
+    if (this->ueventFd >= 0) close(this->ueventFd);
+    #endif
+}
+
+IIODeviceCache &IIODeviceCache::get(void)
+{
+    static Poco::SingletonHolder<IIODeviceCache> sh;
+    return *sh.get();
+}
+
+void IIODeviceCache::drainEvents(void)
+{
+    #ifdef __linux__
+    if (this->ueventFd < 0) return;
+
+    //each message is "action@devpath" followed by NUL separated KEY=VALUE
+    //pairs; only the iio subsystem is of interest, keyed by the devpath
+    //basename, which is the libiio device ID (iio:deviceN or triggerN)
+    char msg[8192];
+    ssize_t len;
+    while ((len = recv(this->ueventFd, msg, sizeof(msg)-1, 0)) > 0)
+    {
+        msg[len] = '\0';
+        std::string devpath;
+        bool isIIO = false;
+        for (const char *p = msg; p < msg+len; p += std::strlen(p)+1)
+        {
+            if (std::strncmp(p, "DEVPATH=", 8) == 0) devpath = p+8;
+            else if (std::strcmp(p, "SUBSYSTEM=iio") == 0) isIIO = true;
+        }
+        if (!isIIO || devpath.empty()) continue;
+        generations[devpath.substr(devpath.find_last_of('/')+1)]++;
+    }
+    #endif
+}
+
+void IIODeviceCache::invalidate(const std::string &deviceId)
+{
+    std::lock_guard<std::mutex> lock(generationsMutex);
+    generations[deviceId]++;
+}
+
+std::vector<std::pair<std::string, std::string>> IIODeviceCache::devices(void)
+{
+    //the device list is held in memory by the context
+    std::vector<std::pair<std::string, std::string>> result;
+    for (auto d : IIOContext::get().devices())
+    {
+        result.emplace_back(d.id(), d.name());
+    }
+    return result;
+}
+
+std::vector<std::pair<IIODevice, std::string>> IIODeviceCache::info(const Builder &builder)
+{
+    //one build at a time, so concurrent callers share the rebuilt entries
+    std::lock_guard<std::mutex> buildLock(this->buildMutex);
+
+    //the one device list the result is built from
+    const auto devices = IIOContext::get().devices();
+    std::vector<std::string> ids;
+    for (auto d : devices) ids.push_back(d.id());
+
+    //find the stale entries and the generation they will be built at
+    std::vector<size_t> stale;
+    std::vector<unsigned long long> staleGenerations;
+    std::vector<std::string> infos(devices.size());
+    {
+        std::lock_guard<std::mutex> lock(generationsMutex);
+        this->drainEvents();
+        const auto now = Clock::now();
+        const auto maxAge = (this->ueventFd >= 0) ? maxAgeWithEvents : maxAgeWithoutEvents;
+        for (size_t i = 0; i < devices.size(); i++)
+        {
+            const auto gen = generation(ids[i]);
+            auto it = this->entries.find(ids[i]);
+            if (it != this->entries.end() && it->second.generation == gen && now - it->second.time < maxAge)
+            {
+                infos[i] = it->second.info;
+                continue;
+            }
+            stale.push_back(i);
+            staleGenerations.push_back(gen);
+        }
+
+        //forget devices that are no longer in the context
+        for (auto it = this->entries.begin(); it != this->entries.end();)
+        {
+            if (std::find(ids.begin(), ids.end(), it->first) == ids.end()) it = this->entries.erase(it);
+            else ++it;
+        }
+    }
+
+    //rebuild the stale entries in parallel, rethrowing the first error
+    std::atomic<size_t> next(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto worker = [&](void)
+    {
+        for (size_t n; (n = next++) < stale.size();)
+        {
+            try
+            {
+                infos[stale[n]] = builder(devices[stale[n]]);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) error = std::current_exception();
+            }
+        }
+    };
+    const size_t numThreads = std::min<size_t>(stale.size(), std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < numThreads; i++) threads.emplace_back(worker);
+    worker();
+    for (auto &t : threads) t.join();
+    if (error) std::rethrow_exception(error);
+
+    //entries invalidated while building keep their old generation
+    //and are therefore rebuilt on the next call
+    const auto now = Clock::now();
+    for (size_t n = 0; n < stale.size(); n++)
+    {
+        auto &entry = this->entries[ids[stale[n]]];
+        entry.info = infos[stale[n]];
+        entry.generation = staleGenerations[n];
+        entry.time = now;
+    }
+
+    std::vector<std::pair<IIODevice, std::string>> result;
+    for (size_t i = 0; i < devices.size(); i++) result.emplace_back(devices[i], infos[i]);
+    return result;
+}
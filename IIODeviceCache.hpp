@@ -0,0 +1,76 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include "IIOSupport.hpp"
+#include <Poco/SingletonHolder.h>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*!
+ * IIODeviceCache caches per-device information of the global IIOContext so
+ * that the info plugin and the block overlays do not walk every device,
+ * channel and attribute on each request.
+ *
+ * A device's entry is rebuilt when it is invalidated: by a kernel uevent for
+ * that device (local context on Linux), by a block after it has written an
+ * attribute of the device, or when it exceeds its maximum age. The maximum
+ * age is short when uevents are unavailable, and long otherwise so that
+ * volatile readings such as temperatures still refresh. Stale entries are
+ * rebuilt in parallel, one device per worker thread.
+ */
+class IIODeviceCache
+{
+    friend class Poco::SingletonHolder<IIODeviceCache>;
+public:
+    typedef std::function<std::string(IIODevice)> Builder;
+
+    /*!
+     * Get the global instance of the cache.
+     */
+    static IIODeviceCache &get(void);
+
+    /*!
+     * Get the (ID, name) pair of every device, in context order.
+     */
+    std::vector<std::pair<std::string, std::string>> devices(void);
+
+    /*!
+     * Get every device of the context, in context order, paired with its
+     * information string. Both come from the same device list, even if the
+     * context is rescanned concurrently. The builder is called concurrently
+     * for the devices whose entries are stale, and must be the same for
+     * every call.
+     */
+    std::vector<std::pair<IIODevice, std::string>> info(const Builder &builder);
+
+    /*!
+     * Mark a device's entry as stale, after an attribute of it was written.
+     * This does not create the cache.
+     */
+    static void invalidate(const std::string &deviceId);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry
+    {
+        std::string info;
+        unsigned long long generation;
+        Clock::time_point time;
+    };
+
+    IIODeviceCache(void);
+    ~IIODeviceCache(void);
+
+    void drainEvents(void);
+
+    std::mutex buildMutex;
+    int ueventFd;
+    std::map<std::string, Entry> entries;
+};
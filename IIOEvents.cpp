@@ -0,0 +1,243 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Poco/Error.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <linux/iio/events.h>
+#endif
+#include <cerrno>
+#include <string>
+#include <vector>
+#include "IIOSupport.hpp"
+#include "IIODeviceCache.hpp"
+
+#include <json.hpp>
+using json = nlohmann::json;
+
+/***********************************************************************
+ * |PothosDoc IIO Events
+ *
+ * The IIO events block listens for events such as threshold crossings on
+ * one or more IIO devices and emits each one as a message. All devices are
+ * multiplexed onto the block's thread with a single epoll set, so no
+ * attribute polling is needed to detect these conditions.
+ *
+ * Each message on the "events" port is a dictionary with the keys
+ * "deviceId", "timestampNs" (the kernel timestamp of the event), "code" (the
+ * raw event code), "type" (e.g. "thresh"), "direction" (e.g. "rising"),
+ * "channelType" (e.g. "voltage"), "channel", "channel2", "modifier" and
+ * "differential".
+ *
+ * The kernel only hands out an event descriptor while the device's character
+ * device is not open elsewhere, so devices that are busy when the block is
+ * activated (for example because a source is streaming) are retried each
+ * time the block waits for events.
+ * Events are only supported by the local (Linux) IIO context.
+ *
+ * |category /IIO
+ * |category /Sources
+ * |keywords iio industrial io event threshold interrupt irq
+ *
+ * |param deviceIds[Device IDs] The IDs of the IIO devices to listen to.
+ * |default []
+ *
+ * |factory /iio/events(deviceIds)
+ **********************************************************************/
+class IIOEvents : public Pothos::Block
+{
+private:
+    std::vector<std::string> deviceIds;
+    std::vector<int> eventFds;
+    int epollFd;
+
+public:
+    IIOEvents(const std::vector<std::string> &deviceIds)
+        : deviceIds(deviceIds), eventFds(deviceIds.size(), -1), epollFd(-1)
+    {
+        //expose overlay hook
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOEvents, overlay));
+        this->setupOutput("events");
+
+        #ifndef __linux__
+        throw Pothos::NotImplementedException("IIOEvents::IIOEvents()", "IIO events require Linux");
+        #endif
+
+        //validate the device IDs against the context
+        IIOContext& ctx = IIOContext::get();
+        for (const auto &id : deviceIds)
+        {
+            bool found = false;
+            for (auto d : ctx.devices()) found = found || (d.id() == id);
+            if (!found)
+            {
+                throw Pothos::SystemException("IIOEvents::IIOEvents()", "device not found: " + id);
+            }
+        }
+    }
+
+    ~IIOEvents(void)
+    {
+        this->closeAll();
+    }
+
+    std::string overlay(void) const
+    {
+        json topObj;
+        auto &params = topObj["params"];
+
+        //configure deviceIds as an editable dropdown of known devices
+        json deviceIdsParam;
+        deviceIdsParam["key"] = "deviceIds";
+        auto &deviceIdsOpts = deviceIdsParam["options"];
+        deviceIdsParam["widgetKwargs"]["editable"] = true;
+        deviceIdsParam["widgetType"] = "DropDown";
+
+        //enumerate iio devices
+        for (const auto &d : IIODeviceCache::get().devices())
+        {
+            json option;
+            option["name"] = d.second + " (" + d.first + ")";
+            option["value"] = "[\"" + d.first + "\"]";
+            deviceIdsOpts.push_back(option);
+        }
+        params.push_back(deviceIdsParam);
+
+        return topObj.dump();
+    }
+
+    static Block *make(const std::vector<std::string> &deviceIds)
+    {
+        return new IIOEvents(deviceIds);
+    }
+
+    #ifdef __linux__
+    void activate(void)
+    {
+        this->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (this->epollFd < 0)
+        {
+            throw Pothos::SystemException("IIOEvents::activate()", "epoll_create1: " + Poco::Error::getMessage(errno));
+        }
+        this->openPending();
+    }
+
+    void deactivate(void)
+    {
+        this->closeAll();
+    }
+
+    void work(void)
+    {
+        this->openPending();
+
+        const int timeoutMs = static_cast<int>((this->workInfo().maxTimeoutNs + 999999)/1000000);
+        struct epoll_event ready[16];
+        int ret = epoll_wait(this->epollFd, ready, 16, timeoutMs);
+        if (ret < 0 && errno == EINTR)
+            return this->yield();
+        else if (ret < 0)
+            throw Pothos::SystemException("IIOEvents::work()", "epoll_wait failed: " + Poco::Error::getMessage(errno));
+        else if (ret == 0)
+            return this->yield();
+
+        auto outputPort = this->output("events");
+        for (int i = 0; i < ret; i++)
+        {
+            const size_t index = ready[i].data.u32;
+
+            //drain every queued event for this device
+            struct iio_event_data events[16];
+            ssize_t len;
+            while ((len = read(this->eventFds[index], events, sizeof(events))) > 0)
+            {
+                for (size_t j = 0; j < size_t(len)/sizeof(events[0]); j++)
+                {
+                    outputPort->postMessage(this->decode(this->deviceIds[index], events[j]));
+                }
+            }
+            if (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                throw Pothos::SystemException("IIOEvents::work()", "read failed: " + Poco::Error::getMessage(errno));
+            }
+        }
+    }
+    #endif
+
+private:
+    void closeAll(void)
+    {
+        #ifdef __linux__
+        for (auto &fd : this->eventFds)
+        {
+            if (fd >= 0) close(fd);
+            fd = -1;
+        }
+        if (this->epollFd >= 0) close(this->epollFd);
+        this->epollFd = -1;
+        #endif
+    }
+
+    #ifdef __linux__
+    //try to get an event descriptor for each device that doesn't have one yet
+    void openPending(void)
+    {
+        for (size_t i = 0; i < this->deviceIds.size(); i++)
+        {
+            if (this->eventFds[i] >= 0) continue;
+
+            const int eventFd = iioOpenEventFd(this->deviceIds[i]);
+            if (eventFd < 0) continue;
+
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.u64 = 0;
+            ev.data.u32 = static_cast<uint32_t>(i);
+            if (epoll_ctl(this->epollFd, EPOLL_CTL_ADD, eventFd, &ev) < 0)
+            {
+                close(eventFd);
+                throw Pothos::SystemException("IIOEvents::openPending()", "epoll_ctl: " + Poco::Error::getMessage(errno));
+            }
+            this->eventFds[i] = eventFd;
+        }
+    }
+
+    Pothos::ObjectKwargs decode(const std::string &deviceId, const struct iio_event_data &event) const
+    {
+        //field layout of the event code, see linux/iio/events.h
+        static const char *types[] = {"thresh", "mag", "roc", "thresh_adaptive", "mag_adaptive", "change", "mag_referenced", "gesture"};
+        static const char *directions[] = {"either", "rising", "falling", "none", "singletap", "doubletap"};
+        static const char *channelTypes[] = {"voltage", "current", "power", "accel", "anglvel", "magn", "illuminance",
+            "intensity", "proximity", "temp", "incli", "rot", "angl", "timestamp", "capacitance", "altvoltage", "cct",
+            "pressure", "humidityrelative", "activity", "steps", "energy", "distance", "velocity", "concentration",
+            "resistance", "ph", "uvindex", "electricalconductivity", "count", "index", "gravity", "positionrelative",
+            "phase", "massconcentration"};
+        auto lookup = [](const char **names, size_t count, unsigned value) -> std::string
+        {
+            return (value < count) ? names[value] : std::to_string(value);
+        };
+
+        const unsigned long long code = event.id;
+        const unsigned type = (code >> 56) & 0xFF;
+        const unsigned direction = (code >> 48) & 0x7F;
+        const unsigned channelType = (code >> 32) & 0xFF;
+
+        Pothos::ObjectKwargs msg;
+        msg["deviceId"] = Pothos::Object(deviceId);
+        msg["timestampNs"] = Pothos::Object(static_cast<long long>(event.timestamp));
+        msg["code"] = Pothos::Object(code);
+        msg["type"] = Pothos::Object(lookup(types, sizeof(types)/sizeof(types[0]), type));
+        msg["direction"] = Pothos::Object(lookup(directions, sizeof(directions)/sizeof(directions[0]), direction));
+        msg["channelType"] = Pothos::Object(lookup(channelTypes, sizeof(channelTypes)/sizeof(channelTypes[0]), channelType));
+        msg["channel"] = Pothos::Object(static_cast<int>(static_cast<int16_t>(code & 0xFFFF)));
+        msg["channel2"] = Pothos::Object(static_cast<int>(static_cast<int16_t>((code >> 16) & 0xFFFF)));
+        msg["modifier"] = Pothos::Object(static_cast<int>((code >> 40) & 0xFF));
+        msg["differential"] = Pothos::Object(((code >> 55) & 0x1) != 0);
+        return msg;
+    }
+    #endif
+};
+
+static Pothos::BlockRegistry registerIIOEvents(
+    "/iio/events", &IIOEvents::make);
@@ -4,14 +4,58 @@
 
 #include <Pothos/Plugin.hpp>
 #include <Poco/Error.h>
+#include <fstream>
 #include <string>
+#include <utility>
+#include <vector>
 #include "IIOSupport.hpp"
+#include "IIOConvert.hpp"
+#include "IIODeviceCache.hpp"
+#include "IIOStats.hpp"
 
 #include <typeinfo>
 
 #include <json.hpp>
 using json = nlohmann::json;
 
+static json getIIOFormatInfo(const struct iio_data_format &fmt)
+{
+    json infoObject;
+    infoObject["Bits"] = fmt.bits;
+    infoObject["Storage Bits"] = fmt.length;
+    infoObject["Shift"] = fmt.shift;
+    infoObject["Repeat"] = fmt.repeat;
+    infoObject["Signed"] = fmt.is_signed ? "true" : "false";
+    infoObject["Endianness"] = fmt.is_be ? "Big" : "Little";
+    if (fmt.with_scale) infoObject["Scale"] = fmt.scale;
+    infoObject["Sample Bytes"] = iioFormatBytes(fmt);
+    return infoObject;
+}
+
+static json getIIOBufferInfo(IIOContext &ctx, IIODevice dev)
+{
+    json infoObject = json::object();
+
+    // The kernel buffer limits are only exposed through sysfs,
+    // so they are only available for the local context
+    if (ctx.name() != "local") return infoObject;
+    const std::string path = "/sys/bus/iio/devices/" + dev.id() + "/buffer/";
+    const std::vector<std::pair<std::string, std::string>> files = {
+        {"length", "Length"},
+        {"watermark", "Watermark"},
+        {"length_align_bytes", "Length Align Bytes"},
+        {"data_available", "Data Available"},
+        {"enable", "Enabled"},
+    };
+    for (const auto &file : files)
+    {
+        std::ifstream in(path + file.first);
+        std::string value;
+        if (in >> value) infoObject[file.second] = value;
+    }
+    return infoObject;
+}
+
 static json getIIOChannelInfo(IIOChannel chn)
 {
     json infoObject;
@@ -21,6 +65,11 @@ static json getIIOChannelInfo(IIOChannel chn)
     infoObject["Name"] = chn.name();
     infoObject["Is Scan Element"] = chn.isScanElement() ? "true" : "false";
     infoObject["Direction"] = chn.isOutput() ? "Output" : "Input";
+    if (chn.isScanElement())
+    {
+        infoObject["Scan Index"] = chn.index();
+        infoObject["Data Format"] = getIIOFormatInfo(chn.format());
+    }
 
     // Channel attributes
     auto &attrArray = infoObject["Attributes"];
@@ -35,7 +84,8 @@ static json getIIOChannelInfo(IIOChannel chn)
     return infoObject;
 }
 
-static json getIIODeviceInfo(IIODevice dev)
+// The static part of a device's info, which is cached by IIODeviceCache
+static std::string getIIODeviceInfo(IIODevice dev)
 {
     json infoObject;
 
@@ -43,6 +93,7 @@ static json getIIODeviceInfo(IIODevice dev)
     infoObject["Device ID"] = dev.id();
     infoObject["Device Name"] = dev.name();
     infoObject["Is Trigger"] = dev.isTrigger() ? "true" : "false";
+    infoObject["Scan Size Bytes"] = dev.scanSize(false);
 
     // Device attributes
     auto &attrArray = infoObject["Attributes"];
@@ -61,7 +112,26 @@ static json getIIODeviceInfo(IIODevice dev)
         chanArray.push_back(getIIOChannelInfo(c));
     }
 
-    return infoObject;
+    return infoObject.dump();
+}
+
+// The parts of a device's info that change while streaming
+static void addIIODeviceLiveInfo(IIOContext &ctx, IIODevice dev, json &infoObject)
+{
+    try
+    {
+        infoObject["Trigger"] = dev.trigger().id();
+    }
+    catch (const Pothos::Exception &)
+    {
+        infoObject["Trigger"] = "";
+    }
+
+    // Buffer capabilities and state
+    infoObject["Buffer"] = getIIOBufferInfo(ctx, dev);
+
+    // Live statistics of active source and sink blocks
+    infoObject["Active Streams"] = json::parse(IIOStreamRegistration::toJSON(dev.id()));
 }
 
 static std::string enumerateIIODevices(void)
@@ -70,9 +140,11 @@ static std::string enumerateIIODevices(void)
     IIOContext& ctx = IIOContext::get();
 
     auto &devicesArray = topObject["IIO Devices"];
-    for (auto d : ctx.devices())
+    for (const auto &cached : IIODeviceCache::get().info(&getIIODeviceInfo))
     {
-        devicesArray.push_back(getIIODeviceInfo(d));
+        auto infoObject = json::parse(cached.second);
+        addIIODeviceLiveInfo(ctx, cached.first, infoObject);
+        devicesArray.push_back(infoObject);
     }
 
     topObject["IIO Version"] = ctx.version();
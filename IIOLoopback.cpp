@@ -0,0 +1,556 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include "IIOLoopback.hpp"
+#include "IIOConvert.hpp"
+#include <Pothos/Framework.hpp>
+#include <Poco/Error.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include <json.hpp>
+using json = nlohmann::json;
+
+#define LDEV(dev) static_cast<Device *>(const_cast<void *>(dev))
+#define LCHN(chn) static_cast<Channel *>(const_cast<void *>(chn))
+#define LBUF(buf) static_cast<Buffer *>(buf)
+
+static const char *samplesAttr = "loopback_samples";
+static const char *checksumAttr = "loopback_checksum";
+
+/***********************************************************************
+ * Helpers
+ **********************************************************************/
+static struct iio_data_format parseFormat(const std::string &type)
+{
+    struct iio_data_format fmt;
+    if (!iioFormatFromString(type, fmt))
+    {
+        throw Pothos::DataFormatException("IIOLoopback::parseFormat()", "bad format: " + type);
+    }
+    return fmt;
+}
+
+static ssize_t readValue(const std::string &value, char *dst, size_t len)
+{
+    if (len == 0) return -EINVAL;
+    const size_t n = std::min(value.size(), len - 1);
+    std::memcpy(dst, value.data(), n);
+    dst[n] = '\0';
+    return ssize_t(n + 1);
+}
+
+template <typename T>
+static void fillRamp(unsigned long long *staging, size_t count, unsigned long long start)
+{
+    T *out = reinterpret_cast<T *>(staging);
+    for (size_t i = 0; i < count; i++) out[i] = T(start + i);
+}
+
+/***********************************************************************
+ * Construction
+ **********************************************************************/
+IIOLoopback::IIOLoopback(const std::string &path)
+{
+    const std::string xmlSuffix(".xml");
+    if (path.size() > xmlSuffix.size() && path.compare(path.size() - xmlSuffix.size(), xmlSuffix.size(), xmlSuffix) == 0)
+    {
+        this->loadXML(path);
+    }
+    else
+    {
+        this->loadJSON(path);
+    }
+
+    for (auto &dev : this->devices)
+    {
+        dev->samples = 0;
+        dev->checksum = 14695981039346656037ull;
+    }
+}
+
+IIOLoopback::~IIOLoopback(void) {}
+
+void IIOLoopback::loadJSON(const std::string &path)
+{
+    json top;
+    try
+    {
+        std::ifstream file(path);
+        if (!file) throw Pothos::NotFoundException("IIOLoopback::loadJSON()", "cannot open " + path);
+        top = json::parse(file);
+    }
+    catch (const json::exception &ex)
+    {
+        throw Pothos::DataFormatException("IIOLoopback::loadJSON(" + path + ")", ex.what());
+    }
+
+    this->ctxName = top.value("name", std::string("loopback"));
+    this->ctxDescription = top.value("description", "Pothos IIO loopback context (" + path + ")");
+    const json devicesArray = top.value("devices", json::array());
+    for (const auto &devObj : devicesArray)
+    {
+        std::unique_ptr<Device> dev(new Device());
+        dev->id = devObj.value("id", "iio:device" + std::to_string(this->devices.size()));
+        dev->name = devObj.value("name", std::string());
+        dev->defaultRate = devObj.value("rate", 0.0);
+        const json devAttrs = devObj.value("attributes", json::object());
+        for (auto it = devAttrs.begin(); it != devAttrs.end(); ++it)
+        {
+            dev->attrs.emplace_back(it.key(), it.value().is_string() ? it.value().get<std::string>() : it.value().dump());
+        }
+        dev->attrs.emplace_back(samplesAttr, "");
+        dev->attrs.emplace_back(checksumAttr, "");
+
+        const json channelsArray = devObj.value("channels", json::array());
+        for (const auto &chnObj : channelsArray)
+        {
+            std::unique_ptr<Channel> chn(new Channel());
+            chn->device = dev.get();
+            chn->id = chnObj.value("id", "voltage" + std::to_string(dev->channels.size()));
+            chn->name = chnObj.value("name", std::string());
+            chn->output = chnObj.value("output", false);
+            chn->scanElement = chnObj.value("scanElement", true);
+            chn->enabled = false;
+            chn->index = chnObj.value("index", long(dev->channels.size()));
+            chn->format = parseFormat(chnObj.value("format", std::string("le:s16/16>>0")));
+            const json chnAttrs = chnObj.value("attributes", json::object());
+            for (auto it = chnAttrs.begin(); it != chnAttrs.end(); ++it)
+            {
+                chn->attrs.emplace_back(it.key(), it.value().is_string() ? it.value().get<std::string>() : it.value().dump());
+            }
+            dev->channels.push_back(std::move(chn));
+        }
+        this->devices.push_back(std::move(dev));
+    }
+}
+
+void IIOLoopback::loadXML(const std::string &path)
+{
+    //let libiio parse the XML, then copy the layout it describes
+    struct iio_context *xml = iio_create_xml_context(path.c_str());
+    if (!xml)
+    {
+        throw Pothos::SystemException("IIOLoopback::loadXML(" + path + ")", "iio_create_xml_context: " + Poco::Error::getMessage(Poco::Error::last()));
+    }
+
+    this->ctxName = "loopback";
+    this->ctxDescription = "Pothos IIO loopback context (" + path + ")";
+    char value[1024];
+    for (unsigned int i = 0; i < iio_context_get_devices_count(xml); i++)
+    {
+        const struct iio_device *xdev = iio_context_get_device(xml, i);
+        std::unique_ptr<Device> dev(new Device());
+        dev->id = iio_device_get_id(xdev);
+        dev->name = iio_device_get_name(xdev) ? iio_device_get_name(xdev) : "";
+        dev->defaultRate = 0.0;
+        for (unsigned int a = 0; a < iio_device_get_attrs_count(xdev); a++)
+        {
+            const char *attr = iio_device_get_attr(xdev, a);
+            const bool haveValue = iio_device_attr_read(xdev, attr, value, sizeof(value)) > 0;
+            dev->attrs.emplace_back(attr, haveValue ? value : "0");
+        }
+        dev->attrs.emplace_back(samplesAttr, "");
+        dev->attrs.emplace_back(checksumAttr, "");
+
+        for (unsigned int c = 0; c < iio_device_get_channels_count(xdev); c++)
+        {
+            const struct iio_channel *xchn = iio_device_get_channel(xdev, c);
+            std::unique_ptr<Channel> chn(new Channel());
+            chn->device = dev.get();
+            chn->id = iio_channel_get_id(xchn);
+            chn->name = iio_channel_get_name(xchn) ? iio_channel_get_name(xchn) : "";
+            chn->output = iio_channel_is_output(xchn);
+            chn->scanElement = iio_channel_is_scan_element(xchn);
+            chn->enabled = false;
+            chn->index = iio_channel_get_index(xchn);
+            chn->format = *iio_channel_get_data_format(xchn);
+            for (unsigned int a = 0; a < iio_channel_get_attrs_count(xchn); a++)
+            {
+                const char *attr = iio_channel_get_attr(xchn, a);
+                const bool haveValue = iio_channel_attr_read(xchn, attr, value, sizeof(value)) > 0;
+                chn->attrs.emplace_back(attr, haveValue ? value : "0");
+            }
+            dev->channels.push_back(std::move(chn));
+        }
+        this->devices.push_back(std::move(dev));
+    }
+    iio_context_destroy(xml);
+}
+
+/***********************************************************************
+ * Context
+ **********************************************************************/
+int IIOLoopback::version(unsigned int *major, unsigned int *minor, char git_tag[8])
+{
+    *major = 0;
+    *minor = 0;
+    std::strncpy(git_tag, "loopbk", 8);
+    return 0;
+}
+
+const char *IIOLoopback::name(void) { return this->ctxName.c_str(); }
+const char *IIOLoopback::description(void) { return this->ctxDescription.c_str(); }
+unsigned int IIOLoopback::devicesCount(void) { return unsigned(this->devices.size()); }
+IIOBackend::Device IIOLoopback::device(unsigned int idx) { return this->devices.at(idx).get(); }
+
+/***********************************************************************
+ * Devices
+ **********************************************************************/
+const char *IIOLoopback::deviceId(IIOBackend::Device dev) { return LDEV(dev)->id.c_str(); }
+const char *IIOLoopback::deviceName(IIOBackend::Device dev) { return LDEV(dev)->name.empty() ? nullptr : LDEV(dev)->name.c_str(); }
+unsigned int IIOLoopback::deviceAttrsCount(IIOBackend::Device dev) { return unsigned(LDEV(dev)->attrs.size()); }
+const char *IIOLoopback::deviceAttr(IIOBackend::Device dev, unsigned int idx) { return LDEV(dev)->attrs.at(idx).first.c_str(); }
+
+ssize_t IIOLoopback::deviceAttrRead(IIOBackend::Device dev, const char *attr, char *dst, size_t len)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    Device *d = LDEV(dev);
+    if (std::strcmp(attr, samplesAttr) == 0) return readValue(std::to_string(d->samples), dst, len);
+    if (std::strcmp(attr, checksumAttr) == 0)
+    {
+        char hex[17];
+        std::snprintf(hex, sizeof(hex), "%016llx", d->checksum);
+        return readValue(hex, dst, len);
+    }
+    for (const auto &a : d->attrs)
+    {
+        if (a.first == attr) return readValue(a.second, dst, len);
+    }
+    return -ENOENT;
+}
+
+ssize_t IIOLoopback::deviceAttrWrite(IIOBackend::Device dev, const char *attr, const char *src)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (std::strcmp(attr, samplesAttr) == 0 || std::strcmp(attr, checksumAttr) == 0) return -EACCES;
+    for (auto &a : LDEV(dev)->attrs)
+    {
+        if (a.first != attr) continue;
+        a.second = src;
+
+        //wake the input buffers, whose next refill re-paces at the new rate
+        #ifdef __linux__
+        if (a.first == "sampling_frequency")
+        {
+            struct itimerspec spec;
+            std::memset(&spec, 0, sizeof(spec));
+            spec.it_value.tv_nsec = 1;
+            for (const auto b : LDEV(dev)->buffers)
+            {
+                if (!b->output && b->fd >= 0) timerfd_settime(b->fd, 0, &spec, nullptr);
+            }
+        }
+        #endif
+        return ssize_t(a.second.size() + 1);
+    }
+    return -ENOENT;
+}
+
+unsigned int IIOLoopback::channelsCount(IIOBackend::Device dev) { return unsigned(LDEV(dev)->channels.size()); }
+IIOBackend::Channel IIOLoopback::channel(IIOBackend::Device dev, unsigned int idx) { return LDEV(dev)->channels.at(idx).get(); }
+
+int IIOLoopback::deviceTrigger(IIOBackend::Device, IIOBackend::Device *trigger)
+{
+    *trigger = nullptr;
+    return 0;
+}
+
+int IIOLoopback::setDeviceTrigger(IIOBackend::Device, IIOBackend::Device trigger)
+{
+    return trigger ? -ENOSYS : 0;
+}
+
+bool IIOLoopback::deviceIsTrigger(IIOBackend::Device) { return false; }
+int IIOLoopback::setKernelBuffersCount(IIOBackend::Device, unsigned int) { return 0; }
+
+double IIOLoopback::rate(Device *dev)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (const auto &a : dev->attrs)
+    {
+        if (a.first == "sampling_frequency") return std::atof(a.second.c_str());
+    }
+    return dev->defaultRate;
+}
+
+IIOBackend::Buffer IIOLoopback::createBuffer(IIOBackend::Device dev, size_t samples_count, bool)
+{
+    Device *d = LDEV(dev);
+    if (samples_count == 0)
+    {
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    //lay out the enabled scan elements in index order, each aligned to its size
+    std::vector<const Channel *> enabled;
+    for (const auto &c : d->channels)
+    {
+        if (c->enabled && c->scanElement) enabled.push_back(c.get());
+    }
+    if (enabled.empty())
+    {
+        errno = EINVAL;
+        return nullptr;
+    }
+    std::stable_sort(enabled.begin(), enabled.end(), [](const Channel *a, const Channel *b){ return a->index < b->index; });
+
+    std::unique_ptr<Buffer> buf(new Buffer());
+    buf->device = d;
+    buf->output = enabled.front()->output;
+    buf->blocking = true;
+    buf->samplesCount = samples_count;
+    size_t offset = 0, maxAlign = 1;
+    for (const auto c : enabled)
+    {
+        const size_t align = std::max<size_t>(c->format.length/8, 1);
+        offset = (offset + align - 1)/align*align;
+        buf->offsets.emplace_back(c, offset);
+        offset += iioFormatBytes(c->format);
+        maxAlign = std::max(maxAlign, align);
+    }
+    buf->step = ptrdiff_t((offset + maxAlign - 1)/maxAlign*maxAlign);
+    buf->data.assign(buf->step*samples_count, 0);
+    buf->valid = buf->output ? buf->data.size() : 0;
+    buf->rate = this->rate(d);
+    buf->t0 = std::chrono::steady_clock::now();
+    buf->anchor = 0;
+    buf->produced = 0;
+
+    #ifdef __linux__
+    //inputs wake on a timer, which expires at once while unpaced;
+    //outputs are always ready
+    if (!buf->output)
+    {
+        buf->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (buf->fd >= 0) this->armTimer(buf.get());
+    }
+    else
+    {
+        buf->fd = eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+    if (buf->fd < 0) return nullptr;
+    #else
+    buf->fd = -1;
+    #endif
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    d->buffers.push_back(buf.get());
+    return buf.release();
+}
+
+/***********************************************************************
+ * Channels
+ **********************************************************************/
+IIOBackend::Device IIOLoopback::channelDevice(IIOBackend::Channel chn) { return LCHN(chn)->device; }
+const char *IIOLoopback::channelId(IIOBackend::Channel chn) { return LCHN(chn)->id.c_str(); }
+const char *IIOLoopback::channelName(IIOBackend::Channel chn) { return LCHN(chn)->name.empty() ? nullptr : LCHN(chn)->name.c_str(); }
+unsigned int IIOLoopback::channelAttrsCount(IIOBackend::Channel chn) { return unsigned(LCHN(chn)->attrs.size()); }
+const char *IIOLoopback::channelAttr(IIOBackend::Channel chn, unsigned int idx) { return LCHN(chn)->attrs.at(idx).first.c_str(); }
+
+ssize_t IIOLoopback::channelAttrRead(IIOBackend::Channel chn, const char *attr, char *dst, size_t len)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (const auto &a : LCHN(chn)->attrs)
+    {
+        if (a.first == attr) return readValue(a.second, dst, len);
+    }
+    return -ENOENT;
+}
+
+ssize_t IIOLoopback::channelAttrWrite(IIOBackend::Channel chn, const char *attr, const char *src)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (auto &a : LCHN(chn)->attrs)
+    {
+        if (a.first != attr) continue;
+        a.second = src;
+        return ssize_t(a.second.size() + 1);
+    }
+    return -ENOENT;
+}
+
+void IIOLoopback::channelEnable(IIOBackend::Channel chn) { LCHN(chn)->enabled = true; }
+void IIOLoopback::channelDisable(IIOBackend::Channel chn) { LCHN(chn)->enabled = false; }
+bool IIOLoopback::channelIsEnabled(IIOBackend::Channel chn) { return LCHN(chn)->enabled; }
+bool IIOLoopback::channelIsOutput(IIOBackend::Channel chn) { return LCHN(chn)->output; }
+bool IIOLoopback::channelIsScanElement(IIOBackend::Channel chn) { return LCHN(chn)->scanElement; }
+long IIOLoopback::channelIndex(IIOBackend::Channel chn) { return LCHN(chn)->scanElement ? LCHN(chn)->index : -1; }
+const struct iio_data_format *IIOLoopback::channelFormat(IIOBackend::Channel chn) { return &LCHN(chn)->format; }
+
+//libiio's iio_channel_read() and iio_channel_write(): whole samples up to len bytes
+ssize_t IIOLoopback::channelRead(IIOBackend::Channel chn, IIOBackend::Buffer buf, void *dst, size_t len)
+{
+    const auto &fmt = LCHN(chn)->format;
+    Buffer *b = LBUF(buf);
+    const size_t count = std::min(len/iioFormatBytes(fmt), b->valid/size_t(b->step));
+    return ssize_t(iioDeinterleave(fmt, this->bufferFirst(buf, chn), b->step, dst, count));
+}
+
+ssize_t IIOLoopback::channelWrite(IIOBackend::Channel chn, IIOBackend::Buffer buf, const void *src, size_t len)
+{
+    const auto &fmt = LCHN(chn)->format;
+    Buffer *b = LBUF(buf);
+    const size_t count = std::min(len/iioFormatBytes(fmt), b->samplesCount);
+    return ssize_t(iioInterleave(fmt, src, this->bufferFirst(buf, chn), b->step, count));
+}
+
+/***********************************************************************
+ * Buffers
+ **********************************************************************/
+void IIOLoopback::bufferDestroy(IIOBackend::Buffer buf)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto &buffers = LBUF(buf)->device->buffers;
+        buffers.erase(std::remove(buffers.begin(), buffers.end(), LBUF(buf)), buffers.end());
+    }
+    #ifdef __linux__
+    if (LBUF(buf)->fd >= 0) close(LBUF(buf)->fd);
+    #endif
+    delete LBUF(buf);
+}
+
+IIOBackend::Device IIOLoopback::bufferDevice(IIOBackend::Buffer buf) { return LBUF(buf)->device; }
+
+int IIOLoopback::bufferSetBlockingMode(IIOBackend::Buffer buf, bool blocking)
+{
+    LBUF(buf)->blocking = blocking;
+    return 0;
+}
+
+int IIOLoopback::bufferPollFd(IIOBackend::Buffer buf)
+{
+    return LBUF(buf)->fd >= 0 ? LBUF(buf)->fd : -ENOSYS;
+}
+
+std::chrono::steady_clock::time_point IIOLoopback::due(Buffer *buf)
+{
+    //the time at which the next full buffer of samples exists at the
+    //current rate; a new rate paces on from the samples produced so far
+    const double rate = this->rate(buf->device);
+    if (rate != buf->rate)
+    {
+        buf->rate = rate;
+        buf->t0 = std::chrono::steady_clock::now();
+        buf->anchor = buf->produced;
+    }
+    if (rate <= 0.0) return buf->t0;
+    const double seconds = (buf->produced - buf->anchor + buf->samplesCount)/rate;
+    return buf->t0 + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+void IIOLoopback::armTimer(Buffer *buf)
+{
+    #ifdef __linux__
+    if (buf->fd < 0) return;
+    uint64_t expirations;
+    while (read(buf->fd, &expirations, sizeof(expirations)) > 0) {}
+
+    //convert the steady clock deadline into an absolute CLOCK_MONOTONIC time
+    const auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(this->due(buf) - std::chrono::steady_clock::now()).count();
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long long ns = now.tv_nsec + std::max<long long>(remaining, 1);
+    struct itimerspec spec;
+    std::memset(&spec, 0, sizeof(spec));
+    spec.it_value.tv_sec = now.tv_sec + time_t(ns/1000000000);
+    spec.it_value.tv_nsec = long(ns%1000000000);
+    timerfd_settime(buf->fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    #else
+    (void)buf;
+    #endif
+}
+
+void IIOLoopback::generate(Buffer *buf)
+{
+    size_t k = 0;
+    for (const auto &entry : buf->offsets)
+    {
+        const auto &fmt = entry.first->format;
+        const size_t elems = buf->samplesCount*(fmt.repeat ? fmt.repeat : 1);
+        buf->staging.resize(elems);
+        const unsigned long long start = buf->produced + 4096*k++;
+        switch (fmt.length)
+        {
+        case 8: fillRamp<uint8_t>(buf->staging.data(), elems, start); break;
+        case 16: fillRamp<uint16_t>(buf->staging.data(), elems, start); break;
+        case 32: fillRamp<uint32_t>(buf->staging.data(), elems, start); break;
+        case 64: fillRamp<uint64_t>(buf->staging.data(), elems, start); break;
+        default: std::fill(buf->staging.begin(), buf->staging.end(), 0); break;
+        }
+        iioInterleave(fmt, buf->staging.data(), buf->data.data() + entry.second, buf->step, buf->samplesCount);
+    }
+}
+
+ssize_t IIOLoopback::bufferRefill(IIOBackend::Buffer buf)
+{
+    Buffer *b = LBUF(buf);
+    if (b->output) return -EBADF;
+
+    //re-arm the timer for a deadline that moved, so that a woken
+    //poller waits for it instead of spinning on EAGAIN
+    const auto due = this->due(b);
+    if (std::chrono::steady_clock::now() < due)
+    {
+        if (!b->blocking)
+        {
+            this->armTimer(b);
+            return -EAGAIN;
+        }
+        std::this_thread::sleep_until(due);
+    }
+
+    this->generate(b);
+    b->produced += b->samplesCount;
+    b->valid = b->data.size();
+    this->armTimer(b);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    b->device->samples += b->samplesCount;
+    return ssize_t(b->valid);
+}
+
+ssize_t IIOLoopback::bufferPush(IIOBackend::Buffer buf, size_t samples_count)
+{
+    Buffer *b = LBUF(buf);
+    if (!b->output) return -EBADF;
+    samples_count = std::min(samples_count, b->samplesCount);
+    const size_t bytes = samples_count*b->step;
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    unsigned long long hash = b->device->checksum;
+    for (size_t i = 0; i < bytes; i++)
+    {
+        hash ^= b->data[i];
+        hash *= 1099511628211ull;
+    }
+    b->device->checksum = hash;
+    b->device->samples += samples_count;
+    return ssize_t(bytes);
+}
+
+void *IIOLoopback::bufferStart(IIOBackend::Buffer buf) { return LBUF(buf)->data.data(); }
+void *IIOLoopback::bufferEnd(IIOBackend::Buffer buf) { return LBUF(buf)->data.data() + LBUF(buf)->valid; }
+ptrdiff_t IIOLoopback::bufferStep(IIOBackend::Buffer buf) { return LBUF(buf)->step; }
+
+void *IIOLoopback::bufferFirst(IIOBackend::Buffer buf, IIOBackend::Channel chn)
+{
+    Buffer *b = LBUF(buf);
+    for (const auto &entry : b->offsets)
+    {
+        if (entry.first == chn) return b->data.data() + entry.second;
+    }
+    return b->data.data();
+}
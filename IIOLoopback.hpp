@@ -0,0 +1,149 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include "IIOSupport.hpp"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*!
+ * IIOLoopback is an in-process IIOBackend for testing without hardware.
+ *
+ * Devices and channels are described by a JSON file of the form
+ * {"name": "...", "devices": [{"id": "iio:device0", "name": "adc",
+ * "rate": 1e6, "attributes": {"attr": "value"}, "channels": [{"id":
+ * "voltage0", "output": false, "scanElement": true, "index": 0, "format":
+ * "le:s16/16>>0", "attributes": {"attr": "value"}}]}]}
+ * or by a libiio XML context file, whose layout is copied.
+ *
+ * Input buffers are filled with a deterministic ramp: sample n of the k-th
+ * enabled channel holds n + 4096*k, truncated to the channel's bits. Refills
+ * are paced at the device's "sampling_frequency" attribute (or "rate" when
+ * the device has no such attribute); a rate of 0 generates data as fast as
+ * it is consumed. The rate is checked on every refill and writing
+ * sampling_frequency wakes the device's buffers, so pacing follows rate
+ * changes from the samples produced so far. Output buffers accept data at
+ * any rate.
+ *
+ * Two read-only device attributes are added for verification:
+ * "loopback_samples" counts the samples generated or pushed, and
+ * "loopback_checksum" is a 64-bit FNV-1a hash of every pushed scan.
+ */
+class IIOLoopback : public IIOBackend
+{
+private:
+    struct Device;
+
+    struct Channel
+    {
+        Device *device;
+        std::string id;
+        std::string name;
+        bool output;
+        bool scanElement;
+        bool enabled;
+        long index;
+        struct iio_data_format format;
+        std::vector<std::pair<std::string, std::string>> attrs;
+    };
+
+    struct Buffer;
+
+    struct Device
+    {
+        std::string id;
+        std::string name;
+        double defaultRate;
+        std::vector<std::pair<std::string, std::string>> attrs;
+        std::vector<std::unique_ptr<Channel>> channels;
+        unsigned long long samples;
+        unsigned long long checksum;
+        std::vector<Buffer *> buffers;
+    };
+
+    struct Buffer
+    {
+        Device *device;
+        bool output;
+        bool blocking;
+        size_t samplesCount;
+        ptrdiff_t step;
+        std::vector<std::pair<const Channel *, size_t>> offsets;
+        std::vector<unsigned char> data;
+        std::vector<unsigned long long> staging;
+        size_t valid;
+        int fd;
+        double rate;
+        std::chrono::steady_clock::time_point t0;
+        unsigned long long anchor;
+        unsigned long long produced;
+    };
+
+    std::string ctxName;
+    std::string ctxDescription;
+    std::vector<std::unique_ptr<Device>> devices;
+    std::mutex mutex;
+
+    void loadJSON(const std::string &path);
+    void loadXML(const std::string &path);
+    double rate(Device *dev);
+    std::chrono::steady_clock::time_point due(Buffer *buf);
+    void armTimer(Buffer *buf);
+    void generate(Buffer *buf);
+
+public:
+    explicit IIOLoopback(const std::string &path);
+    ~IIOLoopback(void);
+
+    int version(unsigned int *major, unsigned int *minor, char git_tag[8]);
+    const char *name(void);
+    const char *description(void);
+    unsigned int devicesCount(void);
+    IIOBackend::Device device(unsigned int idx);
+
+    const char *deviceId(IIOBackend::Device dev);
+    const char *deviceName(IIOBackend::Device dev);
+    unsigned int deviceAttrsCount(IIOBackend::Device dev);
+    const char *deviceAttr(IIOBackend::Device dev, unsigned int idx);
+    ssize_t deviceAttrRead(IIOBackend::Device dev, const char *attr, char *dst, size_t len);
+    ssize_t deviceAttrWrite(IIOBackend::Device dev, const char *attr, const char *src);
+    unsigned int channelsCount(IIOBackend::Device dev);
+    IIOBackend::Channel channel(IIOBackend::Device dev, unsigned int idx);
+    int deviceTrigger(IIOBackend::Device dev, IIOBackend::Device *trigger);
+    int setDeviceTrigger(IIOBackend::Device dev, IIOBackend::Device trigger);
+    bool deviceIsTrigger(IIOBackend::Device dev);
+    int setKernelBuffersCount(IIOBackend::Device dev, unsigned int nb_buffers);
+    IIOBackend::Buffer createBuffer(IIOBackend::Device dev, size_t samples_count, bool cyclic);
+
+    IIOBackend::Device channelDevice(IIOBackend::Channel chn);
+    const char *channelId(IIOBackend::Channel chn);
+    const char *channelName(IIOBackend::Channel chn);
+    unsigned int channelAttrsCount(IIOBackend::Channel chn);
+    const char *channelAttr(IIOBackend::Channel chn, unsigned int idx);
+    ssize_t channelAttrRead(IIOBackend::Channel chn, const char *attr, char *dst, size_t len);
+    ssize_t channelAttrWrite(IIOBackend::Channel chn, const char *attr, const char *src);
+    void channelEnable(IIOBackend::Channel chn);
+    void channelDisable(IIOBackend::Channel chn);
+    bool channelIsEnabled(IIOBackend::Channel chn);
+    bool channelIsOutput(IIOBackend::Channel chn);
+    bool channelIsScanElement(IIOBackend::Channel chn);
+    long channelIndex(IIOBackend::Channel chn);
+    const struct iio_data_format *channelFormat(IIOBackend::Channel chn);
+    ssize_t channelRead(IIOBackend::Channel chn, IIOBackend::Buffer buf, void *dst, size_t len);
+    ssize_t channelWrite(IIOBackend::Channel chn, IIOBackend::Buffer buf, const void *src, size_t len);
+
+    void bufferDestroy(IIOBackend::Buffer buf);
+    IIOBackend::Device bufferDevice(IIOBackend::Buffer buf);
+    int bufferSetBlockingMode(IIOBackend::Buffer buf, bool blocking);
+    int bufferPollFd(IIOBackend::Buffer buf);
+    ssize_t bufferRefill(IIOBackend::Buffer buf);
+    ssize_t bufferPush(IIOBackend::Buffer buf, size_t samples_count);
+    void *bufferStart(IIOBackend::Buffer buf);
+    void *bufferEnd(IIOBackend::Buffer buf);
+    ptrdiff_t bufferStep(IIOBackend::Buffer buf);
+    void *bufferFirst(IIOBackend::Buffer buf, IIOBackend::Channel chn);
+};
@@ -0,0 +1,373 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Poco/Error.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <memory>
+#include <string>
+#include <vector>
+#include "IIOSupport.hpp"
+#include "IIOConvert.hpp"
+#include "IIODeviceCache.hpp"
+#include "IIOStats.hpp"
+
+#include <json.hpp>
+using json = nlohmann::json;
+
+/***********************************************************************
+ * |PothosDoc IIO Multi-Device Source
+ *
+ * The IIO multi-device source streams from several IIO input devices in
+ * one block. It is meant for installations with many low-rate devices,
+ * where a source block per device would take as many work threads, each
+ * waiting on one buffer. Here the buffers of all devices are registered
+ * with a single epoll set, and each time the block wakes up it refills
+ * every device that is ready and converts its samples to the device's
+ * ports.
+ *
+ * Each streamed channel gets an output port named "deviceId/channelId",
+ * for example "iio:device3/voltage0". The devices stream independently,
+ * each at its own rate with its own buffer of bufferSize samples, and a
+ * device whose ports have no room for a refill is left out of the epoll
+ * set until they have, so a slow consumer of one device does not hold up
+ * the others.
+ *
+ * The streamStats probe returns a JSON object with the data path
+ * statistics of each device (see the IIO source), keyed by device ID, and
+ * the streams are listed by /devices/iio/info. A device that goes away
+ * while streaming, for example because it was unplugged, is dropped from
+ * the set and reported as lost by streamStats; its ports stay idle until
+ * the block is activated again. This covers refills failing with a
+ * device-gone error, and local devices that left sysfs and only make the
+ * poll time out. Other refill errors are thrown. Streaming from several
+ * devices in one block is only supported on Linux.
+ *
+ * |category /IIO
+ * |category /Sources
+ * |keywords iio industrial io adc sensor epoll
+ *
+ * |param deviceIds[Device IDs] The IDs of the IIO devices to stream from.
+ * |default []
+ *
+ * |param channelIds[Channel IDs] The channels to stream, as
+ * "deviceId/channelId". If no channels are specified, every input scan
+ * element of every device is streamed.
+ * |default []
+ * |preview disable
+ *
+ * |param bufferSize[Buffer Size] The number of samples to obtain from each
+ * IIO device during each refill operation.
+ * |preview disable
+ * |default 256
+ *
+ * |factory /iio/multi_device_source(deviceIds, channelIds, bufferSize)
+ **********************************************************************/
+class IIOMultiSource : public Pothos::Block
+{
+private:
+    //the buffer, channels and ports of one device
+    struct Stream
+    {
+        std::string deviceId;
+        std::unique_ptr<IIODevice> dev;
+        std::unique_ptr<IIOBuffer> buf;
+        std::vector<IIOChannel> channels;
+        std::vector<Pothos::OutputPort *> ports;
+        std::unique_ptr<IIOStreamStats> stats;
+        std::unique_ptr<IIOStreamRegistration> registration;
+        bool armed;
+        bool lost;
+    };
+    std::vector<Stream> streams;
+    size_t bufferSize;
+    int epollFd;
+
+public:
+    IIOMultiSource(const std::vector<std::string> &deviceIds, const std::vector<std::string> &channelIds, const size_t bufferSize)
+        : bufferSize(bufferSize), epollFd(-1)
+    {
+        //expose overlay hook
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOMultiSource, overlay));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOMultiSource, streamStats));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOMultiSource, bytesPerSec));
+        this->registerProbe("streamStats");
+        this->registerProbe("bytesPerSec");
+
+        #ifndef __linux__
+        throw Pothos::NotImplementedException("IIOMultiSource::IIOMultiSource()", "streaming from several devices requires Linux");
+        #endif
+
+        if (bufferSize == 0)
+        {
+            throw Pothos::InvalidArgumentException("IIOMultiSource::IIOMultiSource()", "buffer size must be positive");
+        }
+
+        //every selected channel must belong to one of the devices
+        for (const auto &name : channelIds)
+        {
+            const auto slash = name.rfind('/');
+            if (slash == std::string::npos || std::find(deviceIds.begin(), deviceIds.end(), name.substr(0, slash)) == deviceIds.end())
+            {
+                throw Pothos::InvalidArgumentException("IIOMultiSource::IIOMultiSource()", "not a channel of the devices: " + name);
+            }
+        }
+
+        IIOContext& ctx = IIOContext::get();
+        for (const auto &deviceId : deviceIds)
+        {
+            Stream stream;
+            stream.deviceId = deviceId;
+            stream.stats.reset(new IIOStreamStats());
+            stream.registration.reset(new IIOStreamRegistration());
+            stream.armed = false;
+            stream.lost = false;
+            for (auto d : ctx.devices())
+            {
+                if (d.id() == deviceId) stream.dev = std::unique_ptr<IIODevice>(new IIODevice(d));
+            }
+            if (!stream.dev)
+            {
+                throw Pothos::SystemException("IIOMultiSource::IIOMultiSource()", "device not found: " + deviceId);
+            }
+
+            //set up output ports for the selected scannable input channels
+            for (auto c : stream.dev->channels())
+            {
+                if (c.isOutput() || !c.isScanElement()) continue;
+                const std::string name = deviceId + "/" + c.id();
+                if (!channelIds.empty() && std::find(channelIds.begin(), channelIds.end(), name) == channelIds.end()) continue;
+                stream.channels.push_back(c);
+                stream.ports.push_back(this->setupOutput(name, c.dtype()));
+            }
+            if (!stream.channels.empty()) this->streams.push_back(std::move(stream));
+        }
+    }
+
+    ~IIOMultiSource(void)
+    {
+        this->closeAll();
+    }
+
+    std::string overlay(void) const
+    {
+        json topObj;
+        auto &params = topObj["params"];
+
+        //configure deviceIds as an editable dropdown of known devices
+        json deviceIdsParam;
+        deviceIdsParam["key"] = "deviceIds";
+        auto &deviceIdsOpts = deviceIdsParam["options"];
+        deviceIdsParam["widgetKwargs"]["editable"] = true;
+        deviceIdsParam["widgetType"] = "DropDown";
+
+        //enumerate iio devices
+        for (const auto &d : IIODeviceCache::get().devices())
+        {
+            json option;
+            option["name"] = d.second + " (" + d.first + ")";
+            option["value"] = "[\"" + d.first + "\"]";
+            deviceIdsOpts.push_back(option);
+        }
+        params.push_back(deviceIdsParam);
+
+        return topObj.dump();
+    }
+
+    static Block *make(const std::vector<std::string> &deviceIds, const std::vector<std::string> &channelIds, const size_t &bufferSize)
+    {
+        return new IIOMultiSource(deviceIds, channelIds, bufferSize);
+    }
+
+    std::string streamStats(void) const
+    {
+        json obj(json::object());
+        for (const auto &stream : this->streams)
+        {
+            auto stats = json::parse(stream.stats->toJSON());
+            stats["lost"] = stream.lost;
+            obj[stream.deviceId] = stats;
+        }
+        return obj.dump();
+    }
+
+    double bytesPerSec(void) const
+    {
+        double total = 0.0;
+        for (const auto &stream : this->streams) total += stream.stats->bytesPerSec();
+        return total;
+    }
+
+    #ifdef __linux__
+    void activate(void)
+    {
+        this->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (this->epollFd < 0)
+        {
+            throw Pothos::SystemException("IIOMultiSource::activate()", "epoll_create1: " + Poco::Error::getMessage(errno));
+        }
+
+        for (size_t i = 0; i < this->streams.size(); i++)
+        {
+            auto &stream = this->streams[i];
+
+            //disable the input scan elements that are not streamed,
+            //including those left enabled by other users
+            for (auto c : stream.dev->channels())
+            {
+                if (c.isOutput() || !c.isScanElement() || !c.isEnabled()) continue;
+                bool streamed = false;
+                for (auto &s : stream.channels) streamed = streamed || (s.id() == c.id());
+                if (!streamed) c.disable();
+            }
+            for (auto &c : stream.channels) c.enable();
+            stream.buf = std::unique_ptr<IIOBuffer>(new IIOBuffer(std::move(stream.dev->createBuffer(this->bufferSize, false))));
+            stream.buf->setBlockingMode(false);
+
+            //registered without events; work() arms the devices with room
+            struct epoll_event ev;
+            ev.events = 0;
+            ev.data.u64 = 0;
+            ev.data.u32 = static_cast<uint32_t>(i);
+            if (epoll_ctl(this->epollFd, EPOLL_CTL_ADD, stream.buf->fd(), &ev) < 0)
+            {
+                throw Pothos::SystemException("IIOMultiSource::activate()", "epoll_ctl: " + Poco::Error::getMessage(errno));
+            }
+            stream.armed = false;
+            stream.lost = false;
+            stream.stats->reset();
+            stream.registration->set(stream.deviceId, "multi-device source", this->bufferSize, *stream.stats);
+        }
+    }
+
+    void deactivate(void)
+    {
+        this->closeAll();
+    }
+
+    void work(void)
+    {
+        //only wait for the devices whose ports can take a whole refill
+        bool anyArmed = false;
+        for (auto &stream : this->streams)
+        {
+            if (stream.lost) continue;
+            bool room = true;
+            for (auto port : stream.ports) room = room && port->elements() >= this->bufferSize;
+            if (room != stream.armed) this->arm(stream, room);
+            anyArmed = anyArmed || stream.armed;
+        }
+        if (!anyArmed) return;
+
+        const auto tPoll = IIOStreamStats::Clock::now();
+        const int timeoutMs = static_cast<int>((this->workInfo().maxTimeoutNs + 999999)/1000000);
+        struct epoll_event ready[64];
+        int ret = epoll_wait(this->epollFd, ready, 64, timeoutMs);
+        if (ret < 0 && errno == EINTR)
+            return this->yield();
+        else if (ret < 0)
+            throw Pothos::SystemException("IIOMultiSource::work()", "epoll_wait failed: " + Poco::Error::getMessage(errno));
+        const auto pollNs = IIOStreamStats::elapsedNs(tPoll, IIOStreamStats::Clock::now());
+        if (ret == 0)
+        {
+            //an unregistered device does not fail, it only stops waking us
+            for (auto &stream : this->streams)
+            {
+                if (!stream.armed) continue;
+                stream.stats->pollTimeouts.add(1);
+                stream.stats->yields.add(1);
+                if (!stream.dev->isPresent()) this->dropStream(stream);
+            }
+            return this->yield();
+        }
+
+        for (int i = 0; i < ret; i++)
+        {
+            auto &stream = this->streams[ready[i].data.u32];
+            stream.stats->pollWait.record(pollNs);
+            this->refill(stream);
+        }
+    }
+    #endif
+
+private:
+    void closeAll(void)
+    {
+        #ifdef __linux__
+        for (auto &stream : this->streams)
+        {
+            stream.registration->clear();
+            stream.buf.reset();
+            stream.armed = false;
+        }
+        if (this->epollFd >= 0) close(this->epollFd);
+        this->epollFd = -1;
+        #endif
+    }
+
+    #ifdef __linux__
+    void arm(Stream &stream, const bool armed)
+    {
+        struct epoll_event ev;
+        ev.events = armed ? uint32_t(EPOLLIN) : 0;
+        ev.data.u64 = 0;
+        ev.data.u32 = static_cast<uint32_t>(&stream - this->streams.data());
+        if (epoll_ctl(this->epollFd, EPOLL_CTL_MOD, stream.buf->fd(), &ev) < 0)
+        {
+            throw Pothos::SystemException("IIOMultiSource::arm()", "epoll_ctl: " + Poco::Error::getMessage(errno));
+        }
+        stream.armed = armed;
+    }
+
+    //the other devices keep streaming without a lost one
+    void dropStream(Stream &stream)
+    {
+        epoll_ctl(this->epollFd, EPOLL_CTL_DEL, stream.buf->fd(), nullptr);
+        stream.buf.reset();
+        stream.registration->clear();
+        stream.armed = false;
+        stream.lost = true;
+    }
+
+    //refill one device and convert its samples to its ports
+    void refill(Stream &stream)
+    {
+        auto tTransfer = IIOStreamStats::Clock::now();
+        size_t bytes_read = 0;
+        try
+        {
+            bytes_read = stream.buf->refill();
+        }
+        catch (const Pothos::Exception &ex)
+        {
+            if (ex.code() == EAGAIN) return;
+            if (!iioIsDeviceGone(ex.code())) throw;
+            this->dropStream(stream);
+            return;
+        }
+        auto tConvert = IIOStreamStats::Clock::now();
+        stream.stats->transfer.record(IIOStreamStats::elapsedNs(tTransfer, tConvert));
+
+        const ptrdiff_t step = stream.buf->step();
+        const size_t sample_count = bytes_read / step;
+        for (size_t i = 0; i < stream.channels.size(); i++)
+        {
+            auto &c = stream.channels[i];
+            auto outputPort = stream.ports[i];
+            iioDeinterleave(c.format(), stream.buf->first(c), step, outputPort->buffer().as<void*>(), sample_count);
+            outputPort->produce(sample_count);
+        }
+        stream.stats->convert.record(IIOStreamStats::elapsedNs(tConvert, IIOStreamStats::Clock::now()));
+        stream.stats->transfers.add(1);
+        stream.stats->bytes.add(bytes_read);
+        stream.stats->samples.add(sample_count);
+    }
+    #endif
+};
+
+static Pothos::BlockRegistry registerIIOMultiSource(
+    "/iio/multi_device_source", &IIOMultiSource::make);
@@ -0,0 +1,169 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include "IIOPlacement.hpp"
+#include <Pothos/Framework.hpp>
+#include <Poco/Error.h>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#endif
+#include <cerrno>
+#include <cstdint>
+
+#ifdef __linux__
+//node masks for the memory policy system calls, which glibc does not wrap
+static const unsigned long maxNodes = 1024;
+typedef unsigned long NodeMask[maxNodes/(8*sizeof(unsigned long))];
+
+static void makeNodeMask(NodeMask &mask, const int node)
+{
+    for (auto &word : mask) word = 0;
+    mask[node/(8*sizeof(unsigned long))] |= 1ul << (node % (8*sizeof(unsigned long)));
+}
+#endif
+
+IIOPlacement::IIOPlacement(void):
+    priority(0),
+    node(-1)
+{
+}
+
+IIOPlacement::IIOPlacement(const std::vector<int> &cpus, const int priority, const int node):
+    cpus(cpus),
+    priority(priority),
+    node(node)
+{
+    #ifdef __linux__
+    for (const auto cpu : cpus)
+    {
+        if (cpu < 0 || cpu >= CPU_SETSIZE)
+        {
+            throw Pothos::RangeException("IIOPlacement::IIOPlacement()", "invalid CPU: " + std::to_string(cpu));
+        }
+    }
+    if (priority < 0 || priority > sched_get_priority_max(SCHED_FIFO))
+    {
+        throw Pothos::RangeException("IIOPlacement::IIOPlacement()", "invalid real-time priority: " + std::to_string(priority));
+    }
+    if (node < -1 || node >= int(maxNodes))
+    {
+        throw Pothos::RangeException("IIOPlacement::IIOPlacement()", "invalid NUMA node: " + std::to_string(node));
+    }
+    #else
+    if (!this->isDefault())
+    {
+        throw Pothos::NotImplementedException("IIOPlacement::IIOPlacement()", "thread and memory placement require Linux");
+    }
+    #endif
+}
+
+bool IIOPlacement::operator==(const IIOPlacement &other) const
+{
+    return this->cpus == other.cpus && this->priority == other.priority && this->node == other.node;
+}
+
+bool IIOPlacement::operator!=(const IIOPlacement &other) const
+{
+    return !(*this == other);
+}
+
+bool IIOPlacement::isDefault(void) const
+{
+    return this->cpus.empty() && this->priority == 0 && this->node == -1;
+}
+
+Pothos::ThreadPoolArgs IIOPlacement::threadPoolArgs(void) const
+{
+    Pothos::ThreadPoolArgs args(1);
+    if (!this->cpus.empty())
+    {
+        args.affinityMode = "CPU";
+        args.affinity.assign(this->cpus.begin(), this->cpus.end());
+    }
+    else if (this->node >= 0)
+    {
+        args.affinityMode = "NUMA";
+        args.affinity.push_back(size_t(this->node));
+    }
+
+    //the pool maps priorities above 0 onto the real-time range
+    #ifdef __linux__
+    if (this->priority > 0) args.priority = double(this->priority)/sched_get_priority_max(SCHED_FIFO);
+    #endif
+    return args;
+}
+
+void IIOPlacement::applyToThisThread(void) const
+{
+    #ifdef __linux__
+    //an empty list restores every CPU, undoing an earlier placement
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (this->cpus.empty())
+    {
+        const long numCpus = sysconf(_SC_NPROCESSORS_CONF);
+        for (long cpu = 0; cpu < numCpus && cpu < CPU_SETSIZE; cpu++) CPU_SET(cpu, &cpuSet);
+    }
+    for (const auto cpu : this->cpus) CPU_SET(cpu, &cpuSet);
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    if (ret != 0)
+    {
+        throw Pothos::SystemException("IIOPlacement::applyToThisThread()", "pthread_setaffinity_np: " + Poco::Error::getMessage(ret));
+    }
+
+    struct sched_param param;
+    param.sched_priority = this->priority;
+    ret = pthread_setschedparam(pthread_self(), (this->priority > 0) ? SCHED_FIFO : SCHED_OTHER, &param);
+    if (ret != 0)
+    {
+        throw Pothos::SystemException("IIOPlacement::applyToThisThread()", "pthread_setschedparam: " + Poco::Error::getMessage(ret));
+    }
+
+    //prefer the node for everything this thread allocates from now on
+    NodeMask mask;
+    if (this->node >= 0) makeNodeMask(mask, this->node);
+    ret = (this->node >= 0) ?
+        syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, maxNodes) :
+        syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0);
+    if (ret != 0)
+    {
+        throw Pothos::SystemException("IIOPlacement::applyToThisThread()", "set_mempolicy: " + Poco::Error::getMessage(errno));
+    }
+    #endif
+}
+
+bool IIOPlacement::bindMemory(void *addr, const size_t length) const
+{
+    #ifdef __linux__
+    if (this->node < 0 || length == 0) return true;
+
+    //the range has to start on a page boundary
+    const uintptr_t pageSize = uintptr_t(sysconf(_SC_PAGESIZE));
+    const uintptr_t start = uintptr_t(addr) & ~(pageSize-1);
+    const uintptr_t end = uintptr_t(addr) + length;
+    NodeMask mask;
+    makeNodeMask(mask, this->node);
+    return syscall(SYS_mbind, start, end - start, MPOL_PREFERRED, mask, maxNodes, MPOL_MF_MOVE) == 0;
+    #else
+    (void)addr;
+    (void)length;
+    return this->node < 0;
+    #endif
+}
+
+std::string IIOPlacement::toString(void) const
+{
+    std::string desc;
+    if (!this->cpus.empty())
+    {
+        desc += "cpus ";
+        for (size_t i = 0; i < this->cpus.size(); i++) desc += (i ? "," : "") + std::to_string(this->cpus[i]);
+    }
+    if (this->priority > 0) desc += std::string(desc.empty() ? "" : " ") + "fifo " + std::to_string(this->priority);
+    if (this->node >= 0) desc += std::string(desc.empty() ? "" : " ") + "node " + std::to_string(this->node);
+    return desc.empty() ? "default" : desc;
+}
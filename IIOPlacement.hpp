@@ -0,0 +1,70 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Framework.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*!
+ * IIOPlacement says where the threads and memory of a stream should live:
+ * the CPUs a thread may run on, its real-time (SCHED_FIFO) priority, and
+ * the NUMA node that its memory is allocated from.
+ *
+ * Blocks run their work in a dedicated thread pool made with the
+ * placement's threadPoolArgs(), apply the placement to the helper threads
+ * they create, and bind their buffers to the node, so that refills run
+ * close to the memory the device writes into. Placement is only supported
+ * on Linux; the default placement changes nothing and works everywhere.
+ */
+struct IIOPlacement
+{
+    IIOPlacement(void);
+
+    /*!
+     * Create and validate a placement. An empty CPU list means any CPU,
+     * a priority of 0 means normal scheduling, and a node of -1 means any.
+     */
+    IIOPlacement(const std::vector<int> &cpus, const int priority, const int node);
+
+    std::vector<int> cpus;
+    int priority;
+    int node;
+
+    bool operator==(const IIOPlacement &other) const;
+    bool operator!=(const IIOPlacement &other) const;
+
+    /*!
+     * Is this the default placement, which leaves threads and memory alone?
+     */
+    bool isDefault(void) const;
+
+    /*!
+     * Get the arguments of a one thread Pothos thread pool with this
+     * placement: CPU affinity to the CPUs, or else NUMA affinity to the
+     * node, and the real-time priority scaled to the pool's priority range.
+     */
+    Pothos::ThreadPoolArgs threadPoolArgs(void) const;
+
+    /*!
+     * Apply the CPU affinity, scheduling policy and memory policy to the
+     * calling thread, which must be owned by the caller. Throws if the
+     * system refuses, for example when the process may not use real-time
+     * priorities.
+     */
+    void applyToThisThread(void) const;
+
+    /*!
+     * Prefer the node for the pages of a memory range, moving the pages
+     * that are already allocated. This is best effort: returns false if
+     * the pages cannot be placed, for example because they are mapped
+     * device memory.
+     */
+    bool bindMemory(void *addr, const size_t length) const;
+
+    /*!
+     * Describe the placement, e.g. "cpus 2,3 fifo 50 node 0".
+     */
+    std::string toString(void) const;
+};
@@ -0,0 +1,105 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include "IIORateEstimator.hpp"
+
+#include <json.hpp>
+using json = nlohmann::json;
+
+//a wakeup takes a few microseconds when there is room already
+static const unsigned long long minWaitNs = 20000;
+
+//the pushes and time the fit needs before it is used
+static const size_t minPoints = 8;
+static const double minSpan = 0.1;
+
+const size_t IIORateEstimator::windowLength;
+
+IIORateEstimator::IIORateEstimator(void):
+    total(0),
+    restarts(0),
+    slope(0.0)
+{
+}
+
+void IIORateEstimator::reset(void)
+{
+    this->points.clear();
+    this->total = 0;
+    this->restarts = 0;
+    this->slope = 0.0;
+}
+
+void IIORateEstimator::record(const size_t samples, const Clock::time_point time, const unsigned long long waitNs)
+{
+    if (waitNs < minWaitNs)
+    {
+        if (!this->points.empty()) this->restarts++;
+        this->points.clear();
+        this->slope = 0.0;
+    }
+    else
+    {
+        //a fresh origin keeps the sums of the fit well conditioned
+        if (this->points.empty()) this->origin = time;
+        this->points.emplace_back(std::chrono::duration<double>(time - this->origin).count(), double(this->total));
+        if (this->points.size() > windowLength) this->points.pop_front();
+        this->fit();
+    }
+    this->total += samples;
+}
+
+void IIORateEstimator::fit(void)
+{
+    const double n = double(this->points.size());
+    double meanT = 0.0, meanS = 0.0;
+    for (const auto &p : this->points)
+    {
+        meanT += p.first;
+        meanS += p.second;
+    }
+    meanT /= n;
+    meanS /= n;
+
+    double covariance = 0.0, variance = 0.0;
+    for (const auto &p : this->points)
+    {
+        covariance += (p.first - meanT)*(p.second - meanS);
+        variance += (p.first - meanT)*(p.first - meanT);
+    }
+    this->slope = (variance > 0.0) ? covariance/variance : 0.0;
+}
+
+bool IIORateEstimator::locked(void) const
+{
+    return this->points.size() >= minPoints && this->points.back().first - this->points.front().first >= minSpan;
+}
+
+double IIORateEstimator::rate(void) const
+{
+    return this->locked() ? this->slope : 0.0;
+}
+
+double IIORateEstimator::driftPpm(const double nominalRate) const
+{
+    if (!this->locked() || !(nominalRate > 0.0)) return 0.0;
+    return (this->slope/nominalRate - 1.0)*1e6;
+}
+
+unsigned long long IIORateEstimator::samples(void) const
+{
+    return this->total;
+}
+
+std::string IIORateEstimator::toJSON(const double nominalRate) const
+{
+    json obj;
+    obj["locked"] = this->locked();
+    obj["rate"] = this->rate();
+    obj["nominalRate"] = nominalRate;
+    obj["driftPpm"] = this->driftPpm(nominalRate);
+    obj["samples"] = this->total;
+    obj["points"] = this->points.size();
+    obj["restarts"] = this->restarts;
+    return obj.dump();
+}
@@ -0,0 +1,80 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <utility>
+
+/*!
+ * IIORateEstimator measures the rate at which a device actually consumes
+ * the samples of an output stream, in samples per second of the host's
+ * steady clock, from the times the stream's pushes found room.
+ *
+ * While the producer keeps up, every push has to wait for the device to
+ * release a kernel buffer, so the time the wait ends follows the device's
+ * clock, and the samples pushed before it grow at the device's rate. The
+ * estimator fits a line to the last pushes that waited, by least squares,
+ * which averages out the scheduling jitter of the individual wakeups. A push
+ * that did not wait means the producer fell behind and the device may
+ * have run dry, so the fit starts over.
+ */
+class IIORateEstimator
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    //the number of pushes that the fit spans
+    static const size_t windowLength = 256;
+
+    IIORateEstimator(void);
+
+    /*!
+     * Forget all pushes, after the buffer was re-created.
+     */
+    void reset(void);
+
+    /*!
+     * Record a push of samples that waited waitNs for room in the device,
+     * until time.
+     */
+    void record(const size_t samples, const Clock::time_point time, const unsigned long long waitNs);
+
+    /*!
+     * Does the fit span enough pushes and time to be used?
+     */
+    bool locked(void) const;
+
+    /*!
+     * Get the measured rate, or 0 if the fit is not locked.
+     */
+    double rate(void) const;
+
+    /*!
+     * Get the deviation of the measured rate from the nominal rate, in
+     * parts per million, or 0 if either is unknown.
+     */
+    double driftPpm(const double nominalRate) const;
+
+    /*!
+     * Get the number of samples pushed since the last reset.
+     */
+    unsigned long long samples(void) const;
+
+    /*!
+     * Get the estimates as a JSON object.
+     */
+    std::string toJSON(const double nominalRate) const;
+
+private:
+    void fit(void);
+
+    //the pushes that waited, as seconds since the origin and samples pushed before them
+    std::deque<std::pair<double, double>> points;
+    Clock::time_point origin;
+    unsigned long long total;
+    unsigned long long restarts;
+    double slope;
+};
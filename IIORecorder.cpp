@@ -0,0 +1,601 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Poco/Error.h>
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "IIOSupport.hpp"
+#include "IIOConvert.hpp"
+#include "IIODeviceCache.hpp"
+#include "IIOStats.hpp"
+
+#include <json.hpp>
+using json = nlohmann::json;
+
+/***********************************************************************
+ * |PothosDoc IIO Recorder
+ *
+ * The IIO recorder captures an IIO input device straight to disk. Each
+ * refilled IIO buffer is copied once, unconverted, into a queue of aligned
+ * blocks that a writer thread writes with O_DIRECT (when the file system
+ * supports it), bypassing the page cache. There are no ports, and no
+ * deinterleaving is done on the capture path.
+ *
+ * Files are named path.NNNN.raw and are preallocated to the file size, then
+ * rotated once the next buffer would not fit. Each file holds whole scans in
+ * the kernel's buffer layout; next to it, path.NNNN.json describes the layout
+ * (scan size, and the index, offset and format of each channel), the sample
+ * rate, the number of the first sample, the sample count, the wall clock
+ * times of the first and last buffer, and any gaps where buffers were
+ * dropped because the disk could not keep up. The block queue holds at least
+ * two buffers of bufferSize samples (and no less than 64 MiB), so any buffer
+ * size can be recorded.
+ *
+ * The bytesWritten, droppedBytes and filesWritten probes report progress, and
+ * streamStats reports the same data path statistics as the IIO source.
+ * Recording is only supported on Linux.
+ *
+ * |category /IIO
+ * |category /Sinks
+ * |keywords iio industrial io adc record capture file disk
+ *
+ * |param deviceId[Device ID] The ID of an IIO device on the system.
+ * |default ""
+ *
+ * |param channelIds[Channel IDs] The IDs of channels to record.
+ * If no IDs are specified, all input scan elements are recorded.
+ * |preview disable
+ * |default []
+ *
+ * |param path[Path] The path prefix of the recorded files.
+ * |default "/tmp/iio_capture"
+ * |widget FileEntry(mode=save)
+ *
+ * |param bufferSize[Buffer Size] The number of samples to obtain from the IIO
+ * device during each refill operation.
+ * |preview disable
+ * |default 16384
+ *
+ * |param fileSize[File Size] The size at which files are rotated.
+ * |units bytes
+ * |preview valid
+ * |default 1073741824
+ *
+ * |factory /iio/recorder(deviceId, channelIds, path, bufferSize)
+ * |setter setFileSize(fileSize)
+ **********************************************************************/
+class IIORecorder : public Pothos::Block
+{
+private:
+    //direct I/O needs aligned memory, offsets and sizes
+    static const size_t ioAlign = 4096;
+    static const size_t blockBytes = 4 << 20;
+    static const size_t minBlocks = 16;
+
+    struct FileInfo
+    {
+        std::string name;
+        unsigned long long firstSample;
+        unsigned long long samples;
+        unsigned long long bytes;
+        long long startTimeNs;
+        long long endTimeNs;
+        json gaps;
+    };
+
+    //file identifies the destination and is not modified after opening;
+    //final is the file's completed description, set on its last block
+    struct WriteBlock
+    {
+        unsigned char *data;
+        size_t used;
+        std::shared_ptr<const FileInfo> file;
+        std::shared_ptr<const FileInfo> final;
+    };
+
+    std::unique_ptr<IIODevice> dev;
+    std::unique_ptr<IIOBuffer> buf;
+    std::vector<IIOChannel> channels;
+    std::string path;
+    size_t bufferSize;
+    unsigned long long fileSize;
+    IIOStreamStats stats;
+    IIOStreamRegistration registration;
+    IIOStatsCounter bytesWrittenCount;
+    IIOStatsCounter droppedBytesCount;
+    IIOStatsCounter filesWrittenCount;
+
+    //block pool and writer thread
+    std::unique_ptr<unsigned char, void(*)(void *)> pool;
+    size_t numBlocks;
+    std::vector<unsigned char *> freeBlocks;
+    std::deque<WriteBlock> pending;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool done;
+    std::string writeError;
+
+    //capture state, owned by work()
+    std::string layout;
+    WriteBlock current;
+    FileInfo fileInfo;
+    size_t fileIndex;
+    unsigned long long totalSamples;
+
+public:
+    IIORecorder(const std::string &deviceId, const std::vector<std::string> &channelIds,
+        const std::string &path, const size_t &bufferSize)
+        : path(path), bufferSize(bufferSize), fileSize(1ull << 30),
+          pool(nullptr, &std::free), numBlocks(0), done(false), fileIndex(0), totalSamples(0)
+    {
+        //expose overlay hook
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIORecorder, overlay));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIORecorder, setFileSize));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIORecorder, bytesWritten));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIORecorder, droppedBytes));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIORecorder, filesWritten));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIORecorder, streamStats));
+        this->registerProbe("bytesWritten");
+        this->registerProbe("droppedBytes");
+        this->registerProbe("filesWritten");
+        this->registerProbe("streamStats");
+
+        #ifndef __linux__
+        throw Pothos::NotImplementedException("IIORecorder::IIORecorder()", "IIO recording requires Linux");
+        #endif
+
+        //if deviceId is blank, create a partial object that exposes the
+        //overlay hook for the gui but cannot be activated
+        if (deviceId == "") return;
+
+        IIOContext& ctx = IIOContext::get();
+        for (auto d : ctx.devices())
+        {
+            if (d.id() == deviceId)
+            {
+                this->dev = std::unique_ptr<IIODevice>(new IIODevice(d));
+                break;
+            }
+        }
+        if (!this->dev)
+        {
+            throw Pothos::SystemException("IIORecorder::IIORecorder()", "device not found");
+        }
+
+        for (auto c : this->dev->channels())
+        {
+            if (c.isOutput() || !c.isScanElement()) continue;
+            const std::string cId = c.id();
+            if (!channelIds.empty() && std::find(channelIds.begin(), channelIds.end(), cId) == channelIds.end()) continue;
+            this->channels.push_back(c);
+        }
+        if (this->channels.empty())
+        {
+            throw Pothos::SystemException("IIORecorder::IIORecorder()", "no input scan elements to record");
+        }
+    }
+
+    ~IIORecorder(void)
+    {
+        this->stopWriter();
+    }
+
+    std::string overlay(void) const
+    {
+        json topObj;
+        auto &params = topObj["params"];
+
+        //configure deviceId dropdown options
+        json deviceIdParam;
+        deviceIdParam["key"] = "deviceId";
+        auto &deviceIdOpts = deviceIdParam["options"];
+        deviceIdParam["widgetKwargs"]["editable"] = false;
+        deviceIdParam["widgetType"] = "DropDown";
+
+        //add empty device option associated
+        json emptyOption;
+        emptyOption["name"] = "";
+        emptyOption["value"] = "\"\"";
+        deviceIdOpts.push_back(emptyOption);
+
+        //enumerate iio devices
+        for (const auto &d : IIODeviceCache::get().devices())
+        {
+            json option;
+            option["name"] = d.second + " (" + d.first + ")";
+            option["value"] = "\"" + d.first + "\"";
+            deviceIdOpts.push_back(option);
+        }
+        params.push_back(deviceIdParam);
+
+        return topObj.dump();
+    }
+
+    static Block *make(const std::string &deviceId, const std::vector<std::string> &channelIds,
+        const std::string &path, const size_t &bufferSize)
+    {
+        return new IIORecorder(deviceId, channelIds, path, bufferSize);
+    }
+
+    void setFileSize(const unsigned long long fileSize)
+    {
+        if (fileSize < blockBytes)
+        {
+            throw Pothos::InvalidArgumentException("IIORecorder::setFileSize()", "file size must be at least " + std::to_string(blockBytes) + " bytes");
+        }
+        this->fileSize = fileSize;
+    }
+
+    unsigned long long bytesWritten(void) const
+    {
+        return this->bytesWrittenCount.get();
+    }
+
+    unsigned long long droppedBytes(void) const
+    {
+        return this->droppedBytesCount.get();
+    }
+
+    unsigned long long filesWritten(void) const
+    {
+        return this->filesWrittenCount.get();
+    }
+
+    std::string streamStats(void) const
+    {
+        return this->stats.toJSON();
+    }
+
+    void activate(void)
+    {
+        if (!this->dev)
+        {
+            throw Pothos::SystemException("IIORecorder::activate()", "no device specified");
+        }
+
+        //only the recorded channels are part of the raw scans
+        for (auto c : this->dev->channels())
+        {
+            if (std::find(this->channels.begin(), this->channels.end(), c) != this->channels.end()) c.enable();
+            else if (c.isScanElement() && !c.isOutput()) c.disable();
+        }
+        this->buf = std::unique_ptr<IIOBuffer>(new IIOBuffer(this->dev->createBuffer(this->bufferSize, false)));
+        this->buf->setBlockingMode(false);
+
+        //describe the scan layout for the sidecar files
+        json layoutObj;
+        layoutObj["deviceId"] = this->dev->id();
+        layoutObj["deviceName"] = this->dev->name();
+        layoutObj["scanBytes"] = this->buf->step();
+        layoutObj["bufferSize"] = this->bufferSize;
+        auto &chans = layoutObj["channels"];
+        chans = json::array();
+        const auto start = static_cast<const char *>(this->buf->start());
+        for (auto &c : this->channels)
+        {
+            json chan;
+            chan["id"] = c.id();
+            chan["index"] = c.index();
+            chan["offset"] = static_cast<const char *>(this->buf->first(c)) - start;
+            chan["format"] = iioFormatToString(c.format());
+            if (c.format().with_scale) chan["scale"] = c.format().scale;
+            chans.push_back(chan);
+        }
+        layoutObj["sampleRate"] = this->sampleRate();
+        this->layout = layoutObj.dump();
+
+        //aligned block pool for the writer thread, holding at least two
+        //refills so that one can be copied while the other is written
+        const size_t refillBlocks = (this->bufferSize*this->buf->step() + blockBytes - 1)/blockBytes;
+        this->numBlocks = std::max(size_t(minBlocks), 2*refillBlocks);
+        void *mem = nullptr;
+        if (posix_memalign(&mem, ioAlign, blockBytes*this->numBlocks) != 0)
+        {
+            throw Pothos::SystemException("IIORecorder::activate()", "failed to allocate the write queue");
+        }
+        this->pool.reset(static_cast<unsigned char *>(mem));
+        this->freeBlocks.clear();
+        for (size_t i = 0; i < this->numBlocks; i++) this->freeBlocks.push_back(this->pool.get() + i*blockBytes);
+
+        this->current = WriteBlock();
+        this->current.data = nullptr;
+        this->current.used = 0;
+        this->totalSamples = 0;
+        this->stats.reset();
+        this->bytesWrittenCount.reset();
+        this->droppedBytesCount.reset();
+        this->filesWrittenCount.reset();
+
+        this->done = false;
+        this->writeError.clear();
+        this->writer = std::thread(&IIORecorder::writerLoop, this);
+        this->registration.set(this->dev->id(), "recorder", this->bufferSize, this->stats);
+    }
+
+    void deactivate(void)
+    {
+        this->registration.clear();
+        if (this->current.file) this->closeFile();
+        this->stopWriter();
+        this->buf.reset();
+        this->pool.reset();
+    }
+
+    void work(void)
+    {
+        if (!this->buf) return;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (!this->writeError.empty())
+            {
+                throw Pothos::SystemException("IIORecorder::work()", this->writeError);
+            }
+        }
+
+        #ifdef __linux__
+        //wait for samples
+        auto tPoll = IIOStreamStats::Clock::now();
+        struct pollfd pfd = {this->buf->fd(), POLLIN, 0};
+        const int timeoutMs = static_cast<int>(this->workInfo().maxTimeoutNs/1000000);
+        int ret = poll(&pfd, 1, timeoutMs);
+        if (ret < 0)
+        {
+            throw Pothos::SystemException("IIORecorder::work()", "poll failed: " + Poco::Error::getMessage(errno));
+        }
+        this->stats.pollWait.record(IIOStreamStats::elapsedNs(tPoll, IIOStreamStats::Clock::now()));
+        if (ret == 0)
+        {
+            this->stats.pollTimeouts.add(1);
+            this->stats.yields.add(1);
+            return this->yield();
+        }
+
+        auto tTransfer = IIOStreamStats::Clock::now();
+        size_t bytes = 0;
+        try
+        {
+            bytes = this->buf->refill();
+        }
+        catch (const Pothos::Exception &ex)
+        {
+            if (ex.code() == EAGAIN) return this->yield();
+            throw;
+        }
+        auto tCopy = IIOStreamStats::Clock::now();
+        this->stats.transfer.record(IIOStreamStats::elapsedNs(tTransfer, tCopy));
+        const size_t samples = bytes/this->buf->step();
+        const long long nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+        //rotate before a buffer that would overflow the file,
+        //so that every file holds whole scans
+        if (this->current.file && this->fileInfo.bytes + bytes > this->fileSize) this->closeFile();
+        if (!this->current.file) this->openFile(nowNs);
+        auto &file = this->fileInfo;
+
+        //the pool is sized for bufferSize, so a larger refill could never be
+        //queued; fail rather than record it as an endless run of gaps
+        if (bytes > blockBytes*(this->numBlocks - 1))
+        {
+            throw Pothos::RangeException("IIORecorder::work()", "refill of " + std::to_string(bytes) +
+                " bytes exceeds the write queue of " + std::to_string(blockBytes*this->numBlocks) + " bytes");
+        }
+        if (this->haveBlocksFor(bytes))
+        {
+            const unsigned char *src = static_cast<const unsigned char *>(this->buf->start());
+            size_t remaining = bytes;
+            while (remaining != 0)
+            {
+                if (!this->current.data) this->takeBlock();
+                const size_t n = std::min(remaining, blockBytes - this->current.used);
+                std::memcpy(this->current.data + this->current.used, src, n);
+                this->current.used += n;
+                src += n;
+                remaining -= n;
+                if (this->current.used == blockBytes) this->submitBlock();
+            }
+            file.bytes += bytes;
+            file.samples += samples;
+        }
+        else
+        {
+            //the writer has fallen behind, so record a gap rather than block
+            file.gaps.push_back({this->totalSamples, samples});
+            this->droppedBytesCount.add(bytes);
+        }
+        file.endTimeNs = nowNs;
+        this->totalSamples += samples;
+
+        this->stats.convert.record(IIOStreamStats::elapsedNs(tCopy, IIOStreamStats::Clock::now()));
+        this->stats.transfers.add(1);
+        this->stats.bytes.add(bytes);
+        this->stats.samples.add(samples);
+        #endif
+    }
+
+private:
+    double sampleRate(void)
+    {
+        //prefer the device attribute, then the first channel's
+        for (auto a : this->dev->attributes())
+        {
+            if (a.name() == "sampling_frequency") return std::atof(a.value().c_str());
+        }
+        for (auto a : this->channels.front().attributes())
+        {
+            if (a.name() == "sampling_frequency") return std::atof(a.value().c_str());
+        }
+        return 0.0;
+    }
+
+    void openFile(const long long nowNs)
+    {
+        char suffix[16];
+        std::snprintf(suffix, sizeof(suffix), ".%04zu", this->fileIndex++);
+        this->fileInfo.name = this->path + suffix;
+        this->fileInfo.firstSample = this->totalSamples;
+        this->fileInfo.samples = 0;
+        this->fileInfo.bytes = 0;
+        this->fileInfo.startTimeNs = nowNs;
+        this->fileInfo.endTimeNs = nowNs;
+        this->fileInfo.gaps = json::array();
+        this->current.file = std::make_shared<const FileInfo>(this->fileInfo);
+    }
+
+    void closeFile(void)
+    {
+        this->current.final = std::make_shared<const FileInfo>(this->fileInfo);
+        this->submitBlock();
+        this->current.file.reset();
+        this->current.final.reset();
+    }
+
+    //check that the current block and the free blocks can take the given
+    //number of bytes; only the writer returns blocks to the pool, so the
+    //blocks stay available until taken
+    bool haveBlocksFor(const size_t bytes)
+    {
+        const size_t space = this->current.data ? (blockBytes - this->current.used) : 0;
+        const size_t needed = (bytes > space) ? (bytes - space + blockBytes - 1)/blockBytes : 0;
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->freeBlocks.size() >= needed;
+    }
+
+    void takeBlock(void)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->current.data = this->freeBlocks.back();
+        this->current.used = 0;
+        this->freeBlocks.pop_back();
+    }
+
+    void submitBlock(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->pending.push_back(this->current);
+        }
+        this->cond.notify_all();
+        this->current.data = nullptr;
+        this->current.used = 0;
+    }
+
+    void stopWriter(void)
+    {
+        if (!this->writer.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->done = true;
+        }
+        this->cond.notify_all();
+        this->writer.join();
+    }
+
+    void writerLoop(void)
+    {
+        #ifdef __linux__
+        std::shared_ptr<const FileInfo> openInfo;
+        int fd = -1;
+        unsigned long long offset = 0;
+        std::string error;
+
+        while (true)
+        {
+            WriteBlock block;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->cond.wait(lock, [this]{return this->done || !this->pending.empty();});
+                if (this->pending.empty()) break;
+                block = this->pending.front();
+                this->pending.pop_front();
+            }
+
+            //after an error, keep draining so that the work thread never stalls
+            if (error.empty() && block.file != openInfo)
+            {
+                const std::string dataName = block.file->name + ".raw";
+                fd = open(dataName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_DIRECT, 0644);
+                if (fd < 0 && errno == EINVAL) fd = open(dataName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                if (fd < 0) error = "open " + dataName + ": " + Poco::Error::getMessage(errno);
+                else posix_fallocate(fd, 0, this->fileSize); //best effort
+                openInfo = block.file;
+                offset = 0;
+                this->writeSidecar(*block.file, false);
+            }
+
+            if (error.empty() && block.used != 0)
+            {
+                //pad the last block of a file to the alignment,
+                //the padding is truncated away when the file is closed
+                const size_t length = (block.used + ioAlign - 1)/ioAlign*ioAlign;
+                std::memset(block.data + block.used, 0, length - block.used);
+                for (size_t written = 0; written < length && error.empty();)
+                {
+                    const ssize_t ret = pwrite(fd, block.data + written, length - written, offset + written);
+                    if (ret < 0 && errno == EINTR) continue;
+                    if (ret <= 0) error = "write " + block.file->name + ".raw: " + Poco::Error::getMessage(errno);
+                    else written += size_t(ret);
+                }
+                offset += block.used;
+                this->bytesWrittenCount.add(block.used);
+            }
+
+            if (block.final && fd >= 0)
+            {
+                if (ftruncate(fd, offset) != 0 && error.empty()) error = "truncate " + block.file->name + ".raw: " + Poco::Error::getMessage(errno);
+                close(fd);
+                fd = -1;
+                openInfo.reset();
+                this->writeSidecar(*block.final, true);
+                this->filesWrittenCount.add(1);
+            }
+
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (block.data) this->freeBlocks.push_back(block.data);
+            if (!error.empty() && this->writeError.empty()) this->writeError = error;
+        }
+        if (fd >= 0) close(fd);
+        #endif
+    }
+
+    void writeSidecar(const FileInfo &file, const bool complete)
+    {
+        json meta = json::parse(this->layout);
+        //the data file sits next to the sidecar, which names it relative to itself
+        meta["dataFile"] = file.name.substr(file.name.find_last_of('/')+1) + ".raw";
+        meta["firstSample"] = file.firstSample;
+        meta["samples"] = file.samples;
+        meta["bytes"] = file.bytes;
+        meta["startTimeNs"] = file.startTimeNs;
+        meta["endTimeNs"] = file.endTimeNs;
+        meta["gaps"] = file.gaps;
+        meta["complete"] = complete;
+
+        const std::string metaName = file.name + ".json";
+        FILE *fp = std::fopen(metaName.c_str(), "w");
+        if (fp == nullptr) return;
+        const std::string text = meta.dump(2);
+        std::fwrite(text.data(), 1, text.size(), fp);
+        std::fclose(fp);
+    }
+};
+
+static Pothos::BlockRegistry registerIIORecorder(
+    "/iio/recorder", &IIORecorder::make);
@@ -0,0 +1,576 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Poco/Error.h>
+#include <Poco/Logger.h>
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "IIOSupport.hpp"
+#include "IIOConvert.hpp"
+
+#include <json.hpp>
+using json = nlohmann::json;
+
+/***********************************************************************
+ * |PothosDoc IIO Replay
+ *
+ * The IIO replay block plays a capture back through the IIO source's data
+ * path, so that recorded field data can be fed to the same graph.
+ *
+ * The path can name:
+ * <ul>
+ * <li>a capture written by the IIO recorder, either as the recorder's path
+ * prefix (all of path.0000.json, path.0001.json, ... are played in order) or
+ * as a single sidecar .json file;</li>
+ * <li>a SigMF recording (.sigmf-meta or .sigmf-data) with an integer
+ * datatype. Its channels play through ports named voltage0, voltage1, and
+ * so on; a complex channel plays through one complex port, in the same way
+ * as an I/Q channel pair of the IIO source.</li>
+ * </ul>
+ *
+ * The data files are memory mapped and converted with the same
+ * deinterleave engine as the IIO source, so the output ports have the same
+ * names, types and values. Where the recorder dropped buffers, a
+ * "discontinuity" label with the gap's duration in nanoseconds is posted on
+ * every port, as the source does after a recovery. Unlike the source, the
+ * replay also marks the start of each file or SigMF capture segment with an
+ * "rxTime" label holding the capture's wall clock time in nanoseconds.
+ *
+ * A data file shorter than its sidecar says only plays the scans it holds.
+ * The last file of an interrupted recording, whose sidecar was never
+ * completed, is skipped with a warning.
+ *
+ * |category /IIO
+ * |category /Sources
+ * |keywords iio industrial io replay playback file capture sigmf
+ *
+ * |param path[Path] The recorder path prefix, sidecar or SigMF file to play.
+ * |default ""
+ * |widget FileEntry(mode=open)
+ *
+ * |param channelIds[Channel IDs] The IDs of channels to play.
+ * If no IDs are specified, all recorded channels are played.
+ * |preview disable
+ * |default []
+ *
+ * |param bufferSize[Buffer Size] The maximum number of samples produced per
+ * port in each work call.
+ * |preview disable
+ * |default 2048
+ *
+ * |param rateMode[Rate Mode] How fast the capture is played.
+ * |option [Realtime] "realtime"
+ * |option [As fast as possible] "fast"
+ * |option [Scaled] "scaled"
+ * |default "realtime"
+ * |preview valid
+ *
+ * |param rateScale[Rate Scale] The playback speed relative to the recorded
+ * sample rate, in the scaled rate mode.
+ * |default 1.0
+ * |preview when(enum=rateMode, "scaled")
+ *
+ * |param repeat[Repeat] If true, restart the capture when it ends.
+ * |widget ToggleSwitch(on=True,off=False)
+ * |default false
+ * |preview valid
+ *
+ * |factory /iio/replay(path, channelIds, bufferSize)
+ * |setter setRateMode(rateMode)
+ * |setter setRateScale(rateScale)
+ * |setter setRepeat(repeat)
+ **********************************************************************/
+class IIOReplay : public Pothos::Block
+{
+private:
+    struct Channel
+    {
+        std::string id;
+        struct iio_data_format format;
+        size_t offset;
+        bool iq;
+    };
+
+    //one data file; sample positions are relative to the file
+    struct Segment
+    {
+        std::string dataPath;
+        size_t samples;
+        std::vector<std::pair<size_t, long long>> times;
+        std::vector<std::pair<size_t, unsigned long long>> gaps;
+    };
+
+    std::vector<Channel> channels;
+    std::vector<Segment> segments;
+    size_t step;
+    double sampleRate;
+    size_t bufferSize;
+    std::string rateMode;
+    double rateScale;
+    bool repeat;
+
+    //playback position
+    size_t segmentIndex;
+    size_t position;
+    const unsigned char *mapped;
+    size_t mappedLength;
+    unsigned long long produced;
+    std::chrono::steady_clock::time_point t0;
+
+public:
+    IIOReplay(const std::string &path, const std::vector<std::string> &channelIds, const size_t &bufferSize)
+        : step(0), sampleRate(0.0), bufferSize(bufferSize), rateMode("realtime"), rateScale(1.0), repeat(false),
+          segmentIndex(0), position(0), mapped(nullptr), mappedLength(0), produced(0)
+    {
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOReplay, setRateMode));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOReplay, setRateScale));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOReplay, setRepeat));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOReplay, sampleRateHz));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOReplay, samplesPlayed));
+        this->registerProbe("sampleRateHz");
+        this->registerProbe("samplesPlayed");
+
+        #ifndef __linux__
+        throw Pothos::NotImplementedException("IIOReplay::IIOReplay()", "IIO replay requires Linux");
+        #endif
+
+        //allow a partial object for the gui
+        if (path.empty()) return;
+
+        const auto endsWith = [&path](const std::string &suffix)
+        {
+            return path.size() >= suffix.size() && path.compare(path.size()-suffix.size(), suffix.size(), suffix) == 0;
+        };
+        if (endsWith(".sigmf-meta")) this->loadSigMF(path.substr(0, path.size()-11));
+        else if (endsWith(".sigmf-data")) this->loadSigMF(path.substr(0, path.size()-11));
+        else if (endsWith(".json"))
+        {
+            this->loadSidecar(path);
+            if (this->segments.empty())
+            {
+                throw Pothos::DataFormatException("IIOReplay::IIOReplay()", path + ": the recording was interrupted");
+            }
+        }
+        else
+        {
+            for (size_t i = 0;; i++)
+            {
+                char suffix[16];
+                std::snprintf(suffix, sizeof(suffix), ".%04zu.json", i);
+                if (!std::ifstream(path + suffix).good()) break;
+                this->loadSidecar(path + suffix);
+            }
+            if (this->segments.empty())
+            {
+                throw Pothos::NotFoundException("IIOReplay::IIOReplay()", "no capture found at " + path);
+            }
+        }
+
+        //select the channels and set up the same ports as the source
+        if (!channelIds.empty())
+        {
+            std::vector<Channel> selected;
+            for (const auto &id : channelIds)
+            {
+                auto it = std::find_if(this->channels.begin(), this->channels.end(), [&id](const Channel &c){return c.id == id;});
+                if (it == this->channels.end())
+                {
+                    throw Pothos::NotFoundException("IIOReplay::IIOReplay()", "channel not in capture: " + id);
+                }
+                selected.push_back(*it);
+            }
+            this->channels = selected;
+        }
+        for (const auto &c : this->channels)
+        {
+            this->setupOutput(c.id, c.iq ? iioIQPairDType(c.format) : iioFormatDType(c.format));
+        }
+    }
+
+    ~IIOReplay(void)
+    {
+        this->unmap();
+    }
+
+    static Block *make(const std::string &path, const std::vector<std::string> &channelIds, const size_t &bufferSize)
+    {
+        return new IIOReplay(path, channelIds, bufferSize);
+    }
+
+    void setRateMode(const std::string &mode)
+    {
+        if (mode != "realtime" && mode != "fast" && mode != "scaled")
+        {
+            throw Pothos::InvalidArgumentException("IIOReplay::setRateMode()", "unknown rate mode: " + mode);
+        }
+        this->rateMode = mode;
+        this->restartPacing();
+    }
+
+    void setRateScale(const double scale)
+    {
+        if (scale <= 0.0)
+        {
+            throw Pothos::InvalidArgumentException("IIOReplay::setRateScale()", "rate scale must be positive");
+        }
+        this->rateScale = scale;
+        this->restartPacing();
+    }
+
+    void setRepeat(const bool repeat)
+    {
+        this->repeat = repeat;
+    }
+
+    double sampleRateHz(void) const
+    {
+        return this->sampleRate;
+    }
+
+    unsigned long long samplesPlayed(void) const
+    {
+        return this->produced;
+    }
+
+    void activate(void)
+    {
+        if (this->segments.empty())
+        {
+            throw Pothos::SystemException("IIOReplay::activate()", "no capture specified");
+        }
+        this->segmentIndex = 0;
+        this->position = 0;
+        this->produced = 0;
+        this->restartPacing();
+    }
+
+    void deactivate(void)
+    {
+        this->unmap();
+    }
+
+    void work(void)
+    {
+        if (this->segments.empty() || this->channels.empty()) return;
+
+        //advance to the next segment with samples left
+        while (this->segmentIndex < this->segments.size() &&
+            this->position >= this->segments[this->segmentIndex].samples)
+        {
+            this->unmap();
+            this->segmentIndex++;
+            this->position = 0;
+        }
+        if (this->segmentIndex == this->segments.size())
+        {
+            if (!this->repeat) return;
+            this->segmentIndex = 0;
+        }
+        auto &segment = this->segments[this->segmentIndex];
+        if (this->mapped == nullptr) this->map(segment);
+
+        size_t count = std::min(this->bufferSize, this->workInfo().minOutElements);
+        count = std::min(count, segment.samples - this->position);
+        if (count == 0) return;
+
+        //pace the output against the recorded sample rate
+        const double rate = this->playbackRate();
+        if (rate > 0.0)
+        {
+            const auto due = this->t0 + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(this->produced/rate));
+            const auto now = std::chrono::steady_clock::now();
+            if (now < due)
+            {
+                const auto maxSleep = std::chrono::nanoseconds(this->workInfo().maxTimeoutNs);
+                std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(due - now, maxSleep));
+                return this->yield();
+            }
+            //produce only the samples that are due by now
+            const double elapsed = std::chrono::duration<double>(now - this->t0).count();
+            const auto dueSamples = static_cast<unsigned long long>(elapsed*rate);
+            if (dueSamples > this->produced) count = std::min<size_t>(count, dueSamples - this->produced);
+            else count = 1;
+        }
+
+        //labels that fall within this chunk
+        for (const auto &time : segment.times)
+        {
+            if (time.first < this->position || time.first >= this->position + count) continue;
+            for (const auto &c : this->channels)
+            {
+                this->output(c.id)->postLabel(Pothos::Label("rxTime", Pothos::Object(time.second), time.first - this->position));
+            }
+        }
+        //a gap after the file's last sample is marked on that sample
+        const bool lastChunk = (this->position + count == segment.samples);
+        for (const auto &gap : segment.gaps)
+        {
+            if (gap.first < this->position) continue;
+            if (gap.first >= this->position + count && !(lastChunk && gap.first == segment.samples)) continue;
+            const auto gapNs = (this->sampleRate > 0.0) ? static_cast<unsigned long long>(gap.second*1e9/this->sampleRate) : 0ull;
+            const size_t index = std::min(gap.first - this->position, count - 1);
+            for (const auto &c : this->channels)
+            {
+                this->output(c.id)->postLabel(Pothos::Label("discontinuity", Pothos::Object(gapNs), index));
+            }
+        }
+
+        //the same conversion as IIOChannel::read()
+        const unsigned char *scan = this->mapped + this->position*this->step;
+        for (const auto &c : this->channels)
+        {
+            auto outputPort = this->output(c.id);
+            iioDeinterleave(c.format, scan + c.offset, this->step, outputPort->buffer().as<void *>(), count);
+            outputPort->produce(count);
+        }
+        this->position += count;
+        this->produced += count;
+    }
+
+private:
+    double playbackRate(void) const
+    {
+        if (this->rateMode == "fast") return 0.0;
+        if (this->rateMode == "scaled") return this->sampleRate*this->rateScale;
+        return this->sampleRate;
+    }
+
+    void restartPacing(void)
+    {
+        //pace from the current position, so rate changes take effect smoothly
+        this->t0 = std::chrono::steady_clock::now();
+        const double rate = this->playbackRate();
+        if (rate > 0.0)
+        {
+            this->t0 -= std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(this->produced/rate));
+        }
+    }
+
+    //an I/Q channel is converted like a pair of the source: as one
+    //channel whose sample repeats twice, for the I and Q components
+    void addChannel(const std::string &id, const struct iio_data_format &format, const size_t offset, const bool iq = false)
+    {
+        Channel c;
+        c.id = id;
+        c.format = iq ? iioIQPairFormat(format) : format;
+        c.offset = offset;
+        c.iq = iq;
+        this->channels.push_back(c);
+    }
+
+    void loadSidecar(const std::string &metaPath)
+    {
+        std::ifstream in(metaPath);
+        json meta;
+        try
+        {
+            in >> meta;
+        }
+        catch (const std::exception &ex)
+        {
+            throw Pothos::DataFormatException("IIOReplay::loadSidecar()", metaPath + ": " + ex.what());
+        }
+
+        //the layout must match across the files of a capture
+        const size_t step = meta.value("scanBytes", size_t(0));
+        const json chans = meta.value("channels", json::array());
+        if (step == 0 || chans.empty())
+        {
+            throw Pothos::DataFormatException("IIOReplay::loadSidecar()", metaPath + ": missing scan layout");
+        }
+        if (this->segments.empty())
+        {
+            this->step = step;
+            this->sampleRate = meta.value("sampleRate", 0.0);
+            for (const auto &chan : chans)
+            {
+                struct iio_data_format format;
+                if (!iioFormatFromString(chan.value("format", std::string()), format))
+                {
+                    throw Pothos::DataFormatException("IIOReplay::loadSidecar()", metaPath + ": bad channel format");
+                }
+                this->addChannel(chan.value("id", std::string()), format, chan.value("offset", size_t(0)));
+            }
+        }
+        else if (step != this->step || chans.size() != this->channels.size())
+        {
+            throw Pothos::DataFormatException("IIOReplay::loadSidecar()", metaPath + ": layout differs from the first file");
+        }
+
+        //an interrupted recording leaves the sidecar of its last file as it
+        //was when the file was opened, without the samples written since
+        if (!meta.value("complete", true))
+        {
+            poco_warning(Poco::Logger::get("IIOReplay"), metaPath + ": the recording was interrupted, skipping this file");
+            return;
+        }
+
+        Segment segment;
+        //a relative data file is next to the sidecar
+        segment.dataPath = meta.value("dataFile", std::string());
+        const auto slash = metaPath.find_last_of('/');
+        if (!segment.dataPath.empty() && segment.dataPath[0] != '/' && slash != std::string::npos)
+        {
+            segment.dataPath = metaPath.substr(0, slash+1) + segment.dataPath;
+        }
+        segment.samples = meta.value("samples", size_t(0));
+        segment.times.emplace_back(0, meta.value("startTimeNs", 0ll));
+
+        //gaps are given at the absolute sample number where data was dropped;
+        //locate them in the file, whose samples skip over earlier gaps
+        const unsigned long long firstSample = meta.value("firstSample", 0ull);
+        unsigned long long skipped = 0;
+        const json gaps = meta.value("gaps", json::array());
+        for (const auto &gap : gaps)
+        {
+            const unsigned long long at = gap.at(0).get<unsigned long long>();
+            const unsigned long long length = gap.at(1).get<unsigned long long>();
+            segment.gaps.emplace_back(size_t(at - firstSample - skipped), length);
+            skipped += length;
+        }
+        this->segments.push_back(segment);
+    }
+
+    void loadSigMF(const std::string &base)
+    {
+        std::ifstream in(base + ".sigmf-meta");
+        json meta;
+        try
+        {
+            in >> meta;
+        }
+        catch (const std::exception &ex)
+        {
+            throw Pothos::DataFormatException("IIOReplay::loadSigMF()", base + ".sigmf-meta: " + ex.what());
+        }
+        const json global = meta.value("global", json::object());
+
+        //datatype is [c|r][i|u|f]bits[_le|_be], e.g. "ci16_le"
+        const std::string datatype = global.value("core:datatype", std::string());
+        char kind = 0, type = 0, endian[3] = {0};
+        unsigned bits = 0;
+        const int fields = std::sscanf(datatype.c_str(), "%c%c%u_%2s", &kind, &type, &bits, endian);
+        const bool isComplex = (kind == 'c');
+        if (fields < 3 || (kind != 'c' && kind != 'r') || (bits != 8 && bits != 16 && bits != 32) || (bits > 8 && fields < 4))
+        {
+            throw Pothos::DataFormatException("IIOReplay::loadSigMF()", "unsupported SigMF datatype: " + datatype);
+        }
+        if (type != 'i' && type != 'u')
+        {
+            throw Pothos::NotImplementedException("IIOReplay::loadSigMF()", "only integer SigMF datatypes can be played through the IIO data path: " + datatype);
+        }
+
+        struct iio_data_format format;
+        std::memset(&format, 0, sizeof(format));
+        format.length = bits;
+        format.bits = bits;
+        format.repeat = 1;
+        format.is_signed = (type == 'i');
+        format.is_fully_defined = true;
+        format.is_be = (std::string(endian) == "be");
+
+        //multi-channel recordings interleave the channels sample by sample,
+        //and the Q component of a complex sample follows its I component
+        const size_t numChannels = global.value("core:num_channels", size_t(1));
+        const size_t sampleBytes = (isComplex ? 2 : 1)*(bits/8);
+        for (size_t i = 0; i < numChannels; i++)
+        {
+            this->addChannel("voltage" + std::to_string(i), format, i*sampleBytes, isComplex);
+        }
+        this->step = numChannels*sampleBytes;
+        this->sampleRate = global.value("core:sample_rate", 0.0);
+
+        Segment segment;
+        segment.dataPath = base + ".sigmf-data";
+        #ifdef __linux__
+        struct stat st;
+        if (stat(segment.dataPath.c_str(), &st) != 0)
+        {
+            throw Pothos::NotFoundException("IIOReplay::loadSigMF()", segment.dataPath + ": " + Poco::Error::getMessage(errno));
+        }
+        segment.samples = size_t(st.st_size)/this->step;
+        #endif
+
+        //each capture segment starts with a timestamp
+        const json captures = meta.value("captures", json::array());
+        for (const auto &capture : captures)
+        {
+            const size_t start = capture.value("core:sample_start", size_t(0));
+            const std::string datetime = capture.value("core:datetime", std::string());
+            struct tm tm;
+            std::memset(&tm, 0, sizeof(tm));
+            double seconds = 0.0;
+            if (std::sscanf(datetime.c_str(), "%d-%d-%dT%d:%d:%lf", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &seconds) != 6) continue;
+            tm.tm_year -= 1900;
+            tm.tm_mon -= 1;
+            const long long timeNs = static_cast<long long>(timegm(&tm))*1000000000ll + static_cast<long long>(seconds*1e9);
+            segment.times.emplace_back(start, timeNs);
+        }
+        this->segments.push_back(segment);
+    }
+
+    void map(Segment &segment)
+    {
+        #ifdef __linux__
+        const int fd = open(segment.dataPath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            throw Pothos::SystemException("IIOReplay::map()", segment.dataPath + ": " + Poco::Error::getMessage(errno));
+        }
+
+        //a truncated file only plays the scans it has; reading past its
+        //end through the mapping would raise SIGBUS
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            const int err = errno;
+            close(fd);
+            throw Pothos::SystemException("IIOReplay::map()", segment.dataPath + ": fstat: " + Poco::Error::getMessage(err));
+        }
+        segment.samples = std::min(segment.samples, size_t(st.st_size)/this->step);
+        const size_t length = segment.samples*this->step;
+        void *addr = (length != 0) ? mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+        const int err = errno;
+        close(fd);
+        if (addr == MAP_FAILED)
+        {
+            throw Pothos::SystemException("IIOReplay::map()", segment.dataPath + ": mmap: " + Poco::Error::getMessage(err));
+        }
+        if (addr != nullptr) madvise(addr, length, MADV_SEQUENTIAL);
+        this->mapped = static_cast<const unsigned char *>(addr);
+        this->mappedLength = length;
+        #else
+        (void)segment;
+        #endif
+    }
+
+    void unmap(void)
+    {
+        #ifdef __linux__
+        if (this->mapped != nullptr) munmap(const_cast<unsigned char *>(this->mapped), this->mappedLength);
+        #endif
+        this->mapped = nullptr;
+        this->mappedLength = 0;
+    }
+};
+
+static Pothos::BlockRegistry registerIIOReplay(
+    "/iio/replay", &IIOReplay::make);
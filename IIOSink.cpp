@@ -9,11 +9,23 @@
 #include <winsock2.h>
 #endif
 #include <algorithm>
+#include <cmath>
+#include <map>
 #include <memory>
 #include <string>
+#include <cerrno>
 #include <cstring>
+#include <thread>
 #include <vector>
 #include "IIOSupport.hpp"
+#include "IIOBufferPool.hpp"
+#include "IIOBufferTuner.hpp"
+#include "IIOConvert.hpp"
+#include "IIODeviceCache.hpp"
+#include "IIOConfig.hpp"
+#include "IIOPlacement.hpp"
+#include "IIORateEstimator.hpp"
+#include "IIOStats.hpp"
 
 #include <json.hpp>
 using json = nlohmann::json;
@@ -23,6 +35,135 @@ using json = nlohmann::json;
  *
  * The IIO sink forwards an input sample stream to an IIO output device.
  *
+ * Several attributes can be changed at once with the setConfig() call, which
+ * takes a JSON object of the form
+ * {"device": {"attr": value}, "channels": {"id": {"attr": value}}}.
+ * A channel ID can be written as "in:id" or "out:id" to pick the input or
+ * output channel of a device where both have the same ID. The writes are
+ * applied in dependency order (sample rate, frequency, bandwidth, gain
+ * mode, gain, other) without tearing down the stream, and a JSON report
+ * with per-attribute errors and timing is returned.
+ *
+ * For fast retuning, configurations in the same format can be stored once
+ * with loadProfile(name, config) and then applied with switchProfile(name).
+ * Profiles are validated and pre-resolved when loaded, and a switch only
+ * writes the attributes that differ from the previous switch. Writes made
+ * through the block are taken into account; setProfileReadBack(true) also
+ * catches changes made from elsewhere, by reading back each attribute a
+ * switch would skip. The duration of the last switch is available from the
+ * profileSwitchLatency probe (in microseconds), and profileStats() reports
+ * the measured per-attribute write times.
+ *
+ * Data path statistics are always collected: the streamStats probe returns a
+ * JSON object with push latency, poll wait and conversion time histograms
+ * (power-of-two nanosecond bins), poll timeout and yield counts, and byte
+ * and sample totals. The bytesPerSec and transferLatency (mean, in
+ * microseconds) probes report the headline numbers.
+ *
+ * If the device disappears while streaming (for example an unplugged USB
+ * device or a lost network connection), the block keeps running instead of
+ * failing: it re-scans the IIO context in the background every 100 ms, and
+ * once a device with the same ID and channels reappears it re-creates the
+ * buffer, reloads any stored profiles and resumes streaming. A local device
+ * that is unregistered only stops reporting poll events, so on poll timeouts
+ * the block checks that the device still exists. Input samples received
+ * during the outage are discarded. The recoveries and total downtime are
+ * reported by streamStats. Only errors meaning that the device or the
+ * connection to it is gone (such as ENODEV) start a recovery; other
+ * transfer errors, and any loss with autoRecover disabled, fail the
+ * topology.
+ *
+ * The channels that are streamed can be narrowed down at runtime with
+ * setEnabledChannels(), which takes a subset of the block's channel IDs and
+ * quickly re-creates the buffer; the inputs of the other channels are
+ * consumed and discarded. Scan elements of the device that are not streamed
+ * are explicitly disabled, including those left enabled by previous users,
+ * so that the scan only carries the selected channels. The bytesPerScan
+ * probe reports the resulting scan size.
+ *
+ * On machines with many cores, the work thread can be pinned to the CPUs in
+ * cpuAffinity and given a real-time realtimePriority, and memory can be
+ * placed on numaNode, typically the node the device's DMA engine is
+ * attached to. The block's work then runs in a one thread pool of its own
+ * with that affinity (the node's CPUs if no CPUs are given) and priority,
+ * leaving the threads of the shared pool alone. The default placement
+ * returns the block to its original pool. The IIO buffer is moved to the
+ * node when it is created, and the input buffers of the block are allocated
+ * there when the topology is committed. Real-time priorities usually need
+ * the CAP_SYS_NICE capability or an rtprio limit. Placement is supported on
+ * Linux only.
+ *
+ * The input port buffers come from a pool owned by the block: one slab
+ * of memory for all ports, backed by 2 MB huge pages where the system
+ * allows it and pre-faulted when it is allocated, with four buffers of
+ * bufferSize samples per port. The slab is reused when the block is
+ * committed again, so steady-state streaming takes no page faults in the
+ * port buffers. Blocks upstream that bring their own buffer domain keep
+ * using their own buffers.
+ *
+ * Instead of a fixed bufferSize, the block can size its buffer itself. It
+ * measures the overhead of each push and the conversion cost of each
+ * sample, and reads the sample rate from the sampling_frequency attribute
+ * (or measures it, if the device has no such attribute). In the latency
+ * buffer mode, the four kernel buffers together hold the samples of
+ * targetLatency, unless the push overhead requires larger buffers to keep
+ * up. In the cpu mode, a buffer is the smallest that keeps the block's load
+ * within cpuBudget. Sizes are powers of two between 64 and 65536 samples,
+ * starting from bufferSize. The sample rate is checked every second and
+ * after attributes are written through the block, and the buffer is
+ * re-created when the best size changes. The bufferTuning probe reports
+ * the estimates.
+ *
+ * For closed loops inside the graph, attributes can also be written with
+ * messages on the "attr" input port. A message is a dictionary of attribute
+ * names to values, for example {"voltage0/hardwaregain": -10}, where device
+ * attributes are named "attr" and channel attributes "channelId/attr" (the
+ * names the attribute monitor reports). The messages are applied between
+ * pushes, in dependency order. For each one, a message is posted on the
+ * "attrChange" output port: a dictionary with the keys "index" (the input
+ * sample index of the first sample pushed after the change) and "update"
+ * (the message). Samples already queued in kernel buffers are played out
+ * with the new settings too.
+ *
+ * An I/Q channel pair such as voltage0_i and voltage0_q that is selected by
+ * its name (voltage0) in channelIds streams from a single input port named
+ * after the pair, which takes complex samples of the channels' type;
+ * channels selected by their own IDs keep separate ports. Channels pair
+ * when they have the same sample format and the Q sample directly follows
+ * the I sample in a scan, so that each complex sample is converted in the
+ * same single pass as a real one. In enabledChannels and correction, the
+ * pair's name and the IDs of both of its channels select the pair.
+ * Attributes are still set per channel.
+ *
+ * To save the extra passes of separate pre-distortion blocks, the samples
+ * of each channel can be corrected as they are converted into the device
+ * buffer. The correction map gives, per channel, a dictionary with the
+ * optional keys "offset" (the device's DC offset, which is subtracted,
+ * in converted sample units) and "gain" (a factor applied after that).
+ * I/Q pairs also take "offsetQ" (the DC offset of the Q samples, while
+ * "offset" is that of the I samples), "amplitude" (the gain of the Q path
+ * relative to the I path) and "phase" (the Q path's error from quadrature,
+ * in degrees), whose imbalance is pre-compensated. The samples are
+ * corrected like the source's, so a device that adds the offset to what
+ * it writes and has the given imbalance writes the uncorrected samples.
+ * Corrected samples are rounded and saturate at the limits of the
+ * channel's bits. New corrections are prepared as they are set and take
+ * effect together, on all ports, at the first sample of the next push.
+ *
+ * So that upstream blocks such as resamplers or jitter buffers can lock
+ * to the device, the block measures the rate at which the device actually
+ * consumes samples, in samples per second of the host clock. While the
+ * upstream keeps up, each push has to wait for the device to free a kernel
+ * buffer, and a least-squares fit over the last 256 of these wakeups gives
+ * the rate; a push that did not have to wait restarts the fit, since the
+ * device may have run dry. The measuredRate probe reports the rate (0 until
+ * the fit spans at least 8 pushes and 100 ms), clockDrift the deviation
+ * from the sampling_frequency attribute in parts per million, and
+ * rateStats both with the fit's details. Every rateInterval, a message on
+ * the "rate" output port carries a dictionary with the keys "rate",
+ * "nominalRate", "driftPpm", "samples" (the samples pushed so far) and
+ * "locked".
+ *
  * |category /IIO
  * |category /Sinks
  * |keywords iio industrial io adc sdr
@@ -31,7 +172,9 @@ using json = nlohmann::json;
  * |default ""
  *
  * |param channelIds[Channel IDs] The IDs of channels to enable.
- * If no IDs are specified, all channels will be enabled.
+ * If no IDs are specified, all channels will be enabled. The name of an
+ * I/Q pair (voltage0 for voltage0_i and voltage0_q) enables both channels
+ * through one complex port.
  * |preview disable
  * |default []
  *
@@ -47,8 +190,73 @@ using json = nlohmann::json;
  * increase latency.
  * |preview disable
  * |default 2048
+ *
+ * |param bufferMode[Buffer Mode] Use bufferSize as given, or size the
+ * buffer for a target latency or CPU budget.
+ * |option [Fixed] "fixed"
+ * |option [Latency] "latency"
+ * |option [CPU] "cpu"
+ * |preview valid
+ * |default "fixed"
+ *
+ * |param targetLatency[Target Latency] The time samples may wait in the
+ * kernel buffers in the latency buffer mode.
+ * |units us
+ * |preview valid
+ * |default 1000
+ *
+ * |param cpuBudget[CPU Budget] The fraction of one core the block may
+ * spend on conversion and pushes in the cpu buffer mode.
+ * |preview valid
+ * |default 0.1
+ *
+ * |param rateInterval[Rate Interval] The time between messages on the
+ * "rate" port, or 0 for none.
+ * |units ms
+ * |preview valid
+ * |default 100
+ *
+ * |param autoRecover[Auto Recover] If true, recover from the device
+ * disappearing by waiting for it to reappear; otherwise stop with an error.
+ * |preview valid
+ * |widget ToggleSwitch(on=True,off=False)
+ * |default true
  * 
+ * |param correction[Correction] A map of channel IDs to corrections of
+ * their samples, for example {"voltage0": {"offset": 12, "gain": 0.95}}.
+ * Channels that are not listed are not corrected.
+ * |preview valid
+ * |default {}
+ *
+ * |param enabledChannels[Enabled Channels] The IDs of the channels to
+ * stream, out of the block's channels. If no IDs are specified, all of them
+ * are streamed.
+ * |preview valid
+ * |default []
+ *
+ * |param cpuAffinity[CPU Affinity] The CPUs that the block's thread may
+ * run on. If no CPUs are specified, the thread may run on any CPU.
+ * |preview valid
+ * |default []
+ *
+ * |param realtimePriority[Real-time Priority] The real-time priority
+ * (1 to 99, as for SCHED_FIFO) of the block's thread, or 0 for normal
+ * scheduling.
+ * |preview valid
+ * |default 0
+ *
+ * |param numaNode[NUMA Node] The NUMA node to allocate buffers from,
+ * or -1 for any node.
+ * |preview valid
+ * |default -1
+ *
  * |factory /iio/sink(deviceId, channelIds, enablePorts, bufferSize)
+ * |setter setAutoRecover(autoRecover)
+ * |setter setBufferTuning(bufferMode, targetLatency, cpuBudget)
+ * |setter setRateInterval(rateInterval)
+ * |setter setCorrection(correction)
+ * |setter setEnabledChannels(enabledChannels)
+ * |setter setPlacement(cpuAffinity, realtimePriority, numaNode)
  **********************************************************************/
 class IIOSink : public Pothos::Block
 {
@@ -56,15 +264,99 @@ private:
     std::unique_ptr<IIODevice> dev;
     std::unique_ptr<IIOBuffer> buf;
     std::vector<IIOChannel> channels;
+    std::vector<bool> channelEnabled;
+
+    //for each channel, the other channel of its I/Q pair,
+    //or channels.size() for a channel with a port of its own
+    std::vector<size_t> iqPairs;
+
+    //sample corrections indexed like channels: the ones in use, and the
+    //ones that take their place at the next push
+    std::vector<IIOCorrection> corrections;
+    std::vector<IIOCorrection> nextCorrections;
+    bool correctionsChanged;
     bool enablePorts;
     size_t bufferSize;
+    IIOConfigProfiles profiles;
+    IIOStreamStats stats;
+    IIOStreamRegistration registration;
+    std::string deviceId;
+    std::map<std::string, std::string> profileConfigs;
+    bool autoRecover;
+    bool lost;
+    unsigned long long lostGeneration;
+    IIOStreamStats::Clock::time_point lostTime;
+    IIOStreamStats::Clock::time_point nextRecovery;
+
+    //thread and memory placement, and the thread pool the
+    //block had before a placement gave it a dedicated one
+    IIOPlacement placement;
+    Pothos::ThreadPool unplacedPool;
+
+    //pre-faulted memory for the input buffers, kept across commits
+    std::shared_ptr<IIOBufferPool> bufferPool;
+    size_t portBufferSize;
+
+    //automatic buffer sizing; a kernel buffer count of 0 leaves the device's alone
+    IIOBufferTuner tuner;
+    size_t fixedBufferSize;
+    size_t kernelBuffers;
+    double deviceRate;
+    IIOStreamStats::Clock::time_point nextRateCheck;
+
+    //writers for the "attr" port
+    std::unique_ptr<IIOAttributeWriter> attrWriter;
+
+    //consumption rate measurement, and the messages on the "rate" port
+    IIORateEstimator rateEstimator;
+    double nominalRate;
+    double rateInterval;
+    IIOStreamStats::Clock::time_point nextRateReport;
 public:
     IIOSink(const std::string &deviceId, const std::vector<std::string> &channelIds,
         const bool &enablePorts, const size_t &bufferSize)
-        : enablePorts(enablePorts), bufferSize(bufferSize)
+        : correctionsChanged(false), enablePorts(enablePorts), bufferSize(bufferSize),
+          deviceId(deviceId), autoRecover(true), lost(false), lostGeneration(0),
+          bufferPool(IIOBufferPool::make()), portBufferSize(0),
+          fixedBufferSize(bufferSize), kernelBuffers(0), deviceRate(0.0),
+          nominalRate(0.0), rateInterval(100.0)
     {
+        this->tuner.configure("fixed", 1000.0, 0.1, true);
+
         //expose overlay hook
         this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, overlay));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, setConfig));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, loadProfile));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, switchProfile));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, profileSwitchLatency));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, profileStats));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, setProfileReadBack));
+        this->registerProbe("profileSwitchLatency");
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, streamStats));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, bytesPerSec));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, transferLatency));
+        this->registerProbe("streamStats");
+        this->registerProbe("bytesPerSec");
+        this->registerProbe("transferLatency");
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, setAutoRecover));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, setBufferTuning));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, bufferTuning));
+        this->registerProbe("bufferTuning");
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, setCorrection));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, setEnabledChannels));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, setPlacement));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, bytesPerScan));
+        this->registerProbe("bytesPerScan");
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, setRateInterval));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, measuredRate));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, clockDrift));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSink, rateStats));
+        this->registerProbe("measuredRate");
+        this->registerProbe("clockDrift");
+        this->registerProbe("rateStats");
+        this->setupInput("attr");
+        this->setupOutput("attrChange");
+        this->setupOutput("rate");
 
         //get libiio context
         IIOContext& ctx = IIOContext::get();
@@ -95,9 +387,9 @@ public:
             Pothos::Callable attrGetter(&IIOSink::getDeviceAttribute);
             Pothos::Callable attrSetter(&IIOSink::setDeviceAttribute);
             attrGetter.bind(std::ref(*this), 0);
-            attrGetter.bind(a, 1);
+            attrGetter.bind(a.name(), 1);
             attrSetter.bind(std::ref(*this), 0);
-            attrSetter.bind(a, 1);
+            attrSetter.bind(a.name(), 1);
 
             std::string getDeviceAttrName = "deviceAttribute[" + a.name() + "]";
             std::string setDeviceAttrName = "setdeviceAttribute[" + a.name() + "]";
@@ -111,17 +403,10 @@ public:
         {
             if (!c.isOutput())
                 continue;
-            std::string cId = c.id();
-            if (channelIds.size() > 0 && std::none_of(channelIds.begin(), channelIds.end(),
-                    [cId](std::string s){ return s == cId; }))
+            if (!iioChannelSelected(c.id(), channelIds))
                 continue;
             this->channels.push_back(c);
-
-            //set up input ports for scannable input channels
-            if (c.isScanElement() && this->enablePorts)
-            {
-                this->setupInput(c.id(), c.dtype());
-            }
+            this->channelEnabled.push_back(true);
 
             //set up probes/setters for channel attributes
             for (auto a : c.attributes())
@@ -129,9 +414,11 @@ public:
                 Pothos::Callable attrGetter(&IIOSink::getChannelAttribute);
                 Pothos::Callable attrSetter(&IIOSink::setChannelAttribute);
                 attrGetter.bind(std::ref(*this), 0);
-                attrGetter.bind(a, 1);
+                attrGetter.bind(c.id(), 1);
+                attrGetter.bind(a.name(), 2);
                 attrSetter.bind(std::ref(*this), 0);
-                attrSetter.bind(a, 1);
+                attrSetter.bind(c.id(), 1);
+                attrSetter.bind(a.name(), 2);
 
                 std::string getChannelAttrName = "channelAttribute[" + c.id() + "][" + a.name() + "]";
                 std::string setChannelAttrName = "setChannelAttribute[" + c.id() + "][" + a.name() + "]";
@@ -140,12 +427,20 @@ public:
                 this->registerProbe(getChannelAttrName);
             }
         }
+
+        //set up input ports for scannable output channels, one per I/Q pair
+        this->iqPairs = iioFindIQPairs(this->channels, channelIds);
+        for (size_t i = 0; i < this->channels.size(); i++)
+        {
+            if (!this->hasPort(i) || !this->enablePorts) continue;
+            const auto &fmt = this->channels[i].format();
+            this->setupInput(this->portName(i), this->isPaired(i) ? iioIQPairDType(fmt) : this->channels[i].dtype());
+        }
+        this->corrections.resize(this->channels.size());
     }
 
     std::string overlay(void) const
     {
-        IIOContext& ctx = IIOContext::get();
-
         json topObj;
         auto &params = topObj["params"];
 
@@ -163,14 +458,14 @@ public:
         deviceIdOpts.push_back(emptyOption);
 
         //enumerate iio devices
-        for (auto d : ctx.devices())
+        for (const auto &d : IIODeviceCache::get().devices())
         {
             //use the standard label convention, but fall-back on driver/serial
             std::string name;
 
             json option;
-            option["name"] = d.name() + " (" + d.id() + ")";
-            option["value"] = "\"" + d.id() + "\"";
+            option["name"] = d.second + " (" + d.first + ")";
+            option["value"] = "\"" + d.first + "\"";
             deviceIdOpts.push_back(option);
         }
         params.push_back(deviceIdParam);
@@ -184,40 +479,328 @@ public:
         return new IIOSink(deviceId, channelIds, enablePorts, bufferSize);
     }
 
-    std::string getDeviceAttribute(IIOAttr<IIODevice> a)
+    bool isPaired(const size_t i) const
     {
-        return a.value();
+        return this->iqPairs[i] != this->channels.size();
     }
 
-    void setDeviceAttribute(IIOAttr<IIODevice> a, Pothos::Object value)
+    //is channel i the Q channel of a pair, which streams through the I channel's port?
+    //(told apart by ID, since the Q channel may come first in channels)
+    bool isPairQ(const size_t i)
     {
-        a = value.toString();
+        const auto id = this->channels[i].id();
+        return this->isPaired(i) && id.compare(id.size() - 2, 2, "_q") == 0;
     }
 
-    std::string getChannelAttribute(IIOAttr<IIOChannel> a)
+    //does channel i stream from an input port, on its own or as the I channel of a pair?
+    bool hasPort(const size_t i)
     {
-        return a.value();
+        return this->channels[i].isScanElement() && !this->isPairQ(i);
     }
 
-    void setChannelAttribute(IIOAttr<IIOChannel> a, Pothos::Object value)
+    std::string portName(const size_t i)
     {
-        a = value.toString();
+        return this->isPaired(i) ? iioIQPairName(this->channels[i].id()) : this->channels[i].id();
     }
 
-    void activate(void)
+    //the channel of the port that a port name or channel ID refers to
+    size_t portIndex(const std::string &name)
+    {
+        for (size_t i = 0; i < this->channels.size(); i++)
+        {
+            if (this->channels[i].id() == name || (this->hasPort(i) && this->portName(i) == name))
+            {
+                return this->isPairQ(i) ? this->iqPairs[i] : i;
+            }
+        }
+        return this->channels.size();
+    }
+
+    //attributes are looked up by name on each call,
+    //since the device is replaced when the stream recovers
+    std::string getDeviceAttribute(const std::string &attr)
+    {
+        return this->dev->attributes().at(attr).value();
+    }
+
+    void setDeviceAttribute(const std::string &attr, Pothos::Object value)
+    {
+        this->profiles.invalidate();
+        this->dev->attributes().at(attr) = value.toString();
+        this->attributesWritten();
+    }
+
+    IIOChannel &channel(const std::string &channelId)
+    {
+        for (auto &c : this->channels)
+        {
+            if (c.id() == channelId) return c;
+        }
+        throw Pothos::NotFoundException("IIOSink::channel()", "channel not found: " + channelId);
+    }
+
+    std::string getChannelAttribute(const std::string &channelId, const std::string &attr)
+    {
+        return this->channel(channelId).attributes().at(attr).value();
+    }
+
+    void setChannelAttribute(const std::string &channelId, const std::string &attr, Pothos::Object value)
+    {
+        this->profiles.invalidate();
+        this->channel(channelId).attributes().at(attr) = value.toString();
+        this->attributesWritten();
+    }
+
+    //after a successful write: recheck the rate, and refresh the
+    //device's entry in the info cache, which caches attribute values
+    void attributesWritten(void)
+    {
+        this->nextRateCheck = IIOStreamStats::Clock::time_point();
+        IIODeviceCache::invalidate(this->dev->id());
+    }
+
+    void setAutoRecover(const bool autoRecover)
+    {
+        this->autoRecover = autoRecover;
+    }
+
+    void setBufferTuning(const std::string &mode, const double targetLatency, const double cpuBudget)
+    {
+        this->tuner.configure(mode, targetLatency, cpuBudget, true);
+        this->tuner.restart();
+        this->nextRateCheck = IIOStreamStats::Clock::time_point();
+
+        //back to the factory's size, and libiio's default of four
+        //kernel buffers if we changed the count
+        if (!this->tuner.enabled() && (this->bufferSize != this->fixedBufferSize || this->kernelBuffers != 0))
+        {
+            this->resizeBuffer(this->fixedBufferSize, this->kernelBuffers ? 4 : 0);
+        }
+    }
+
+    std::string bufferTuning(void) const
+    {
+        return this->tuner.toJSON(this->tuningRate(), this->bufferSize, this->kernelBuffers);
+    }
+
+    void resizeBuffer(const size_t bufferSize, const size_t kernelBuffers)
+    {
+        this->bufferSize = bufferSize;
+        this->kernelBuffers = kernelBuffers;
+        this->tuner.restart();
+        if (!this->isActive() || this->lost) return;
+        this->setupBuffer();
+        this->registration.set(this->dev->id(), "sink", this->bufferSize, this->stats);
+    }
+
+    double readSampleRate(void)
+    {
+        //prefer the device attribute, then the first channel with one
+        for (auto a : this->dev->attributes())
+        {
+            if (a.name() == "sampling_frequency") return std::atof(a.value().c_str());
+        }
+        for (auto &c : this->channels)
+        {
+            for (auto a : c.attributes())
+            {
+                if (a.name() == "sampling_frequency") return std::atof(a.value().c_str());
+            }
+        }
+        return 0.0;
+    }
+
+    double tuningRate(void) const
+    {
+        return (this->deviceRate > 0.0) ? this->deviceRate : this->tuner.measuredRate();
+    }
+
+    //pick the buffer size again after measuring, or when the sample rate changed
+    void retune(void)
+    {
+        bool rateChanged = false;
+        const auto now = IIOStreamStats::Clock::now();
+        if (now >= this->nextRateCheck)
+        {
+            this->nextRateCheck = now + std::chrono::seconds(1);
+            const double rate = this->readSampleRate();
+            rateChanged = std::abs(rate - this->deviceRate) > 1e-3*std::max(rate, this->deviceRate);
+            this->deviceRate = rate;
+        }
+        if (!rateChanged && !this->tuner.settled()) return;
+
+        const double rate = this->tuningRate();
+        size_t size = this->tuner.bufferSize(rate, this->bufferSize);
+        if (this->portBufferSize != 0) size = std::min(size, this->portBufferSize);
+        const size_t kernelBuffers = this->tuner.kernelBuffers(size, rate);
+        if (size != this->bufferSize || kernelBuffers != this->kernelBuffers) this->resizeBuffer(size, kernelBuffers);
+        else if (rateChanged) this->tuner.restart();
+    }
+
+    void setCorrection(const Pothos::ObjectKwargs &correction)
+    {
+        std::vector<IIOCorrection> corrections(this->channels.size());
+        for (const auto &entry : correction)
+        {
+            //without a device there are no ports, so only check the values
+            const auto params = entry.second.convert<Pothos::ObjectKwargs>();
+            if (!this->dev)
+            {
+                iioCorrectionFromKwargs(params, true);
+                continue;
+            }
+            const size_t i = this->portIndex(entry.first);
+            if (i == this->channels.size() || !this->hasPort(i))
+            {
+                throw Pothos::NotFoundException("IIOSink::setCorrection()", "channel not found: " + entry.first);
+            }
+            corrections[i] = iioCorrectionFromKwargs(params, this->isPaired(i));
+        }
+
+        //switched to by work() between pushes, so that every push is converted with one set
+        this->nextCorrections = corrections;
+        this->correctionsChanged = true;
+    }
+
+    void setEnabledChannels(const std::vector<std::string> &channelIds)
+    {
+        std::vector<bool> enabled(this->channels.size(), channelIds.empty());
+        for (const auto &id : channelIds)
+        {
+            const size_t i = this->portIndex(id);
+            if (i == this->channels.size())
+            {
+                throw Pothos::NotFoundException("IIOSink::setEnabledChannels()", "channel not found: " + id);
+            }
+            enabled[i] = true;
+            if (this->isPaired(i)) enabled[this->iqPairs[i]] = true;
+        }
+        if (enabled == this->channelEnabled) return;
+        this->channelEnabled = enabled;
+
+        //the scan layout changes, so the buffer has to be re-created
+        if (this->isActive() && !this->lost) this->setupBuffer();
+    }
+
+    void setPlacement(const std::vector<int> &cpuAffinity, const int realtimePriority, const int numaNode)
+    {
+        const IIOPlacement placement(cpuAffinity, realtimePriority, numaNode);
+        if (placement == this->placement) return;
+
+        //work moves to a pool of its own instead of changing the threads of
+        //a shared pool; the default placement gives back the original pool,
+        //or a plain pool of its own if the topology had not assigned one yet
+        if (this->placement.isDefault()) this->unplacedPool = this->getThreadPool();
+        if (placement.isDefault() && this->unplacedPool) this->setThreadPool(this->unplacedPool);
+        else this->setThreadPool(Pothos::ThreadPool(placement.threadPoolArgs()));
+        this->placement = placement;
+    }
+
+    std::shared_ptr<Pothos::BufferManager> getInputBufferManager(const std::string &name, const std::string &domain)
+    {
+        //buffers from the block's pool, unless an upstream block provides them
+        if (!domain.empty()) return Pothos::Block::getInputBufferManager(name, domain);
+        //with automatic sizing, make room for the largest buffer up front
+        this->portBufferSize = this->tuner.enabled() ? std::max(this->bufferSize, IIOBufferTuner::maxBufferSize) : this->bufferSize;
+        std::vector<size_t> bufferBytes;
+        size_t index = 0;
+        for (size_t i = 0; i < this->inputs().size(); i++)
+        {
+            if (this->inputs()[i]->name() == name) index = i;
+            bufferBytes.push_back(this->portBufferSize*this->inputs()[i]->dtype().size());
+        }
+        return this->bufferPool->manager(index, bufferBytes, this->placement);
+    }
+
+    size_t bytesPerScan(void) const
+    {
+        if (this->buf) return this->buf->step();
+        return this->dev ? this->dev->scanSize() : 0;
+    }
+
+    std::string setConfig(const std::string &config)
     {
         if (!this->dev)
         {
-            throw Pothos::SystemException("IIOSink::activate()", "no device specified");
+            throw Pothos::SystemException("IIOSink::setConfig()", "no device specified");
+        }
+        this->profiles.invalidate();
+        const auto report = IIOConfig(*this->dev, this->channels, config).apply();
+        this->attributesWritten();
+        return report;
+    }
+
+    void loadProfile(const std::string &name, const std::string &config)
+    {
+        if (!this->dev)
+        {
+            throw Pothos::SystemException("IIOSink::loadProfile()", "no device specified");
         }
+        this->profiles.load(name, IIOConfig(*this->dev, this->channels, config));
+        this->profileConfigs[name] = config;
+    }
+
+    void switchProfile(const std::string &name)
+    {
+        this->profiles.apply(name);
+        this->attributesWritten();
+    }
+
+    double profileSwitchLatency(void) const
+    {
+        return this->profiles.lastSwitchLatency();
+    }
+
+    std::string profileStats(void) const
+    {
+        return this->profiles.stats();
+    }
+
+    void setProfileReadBack(const bool readBack)
+    {
+        this->profiles.setReadBack(readBack);
+    }
 
+    std::string streamStats(void) const
+    {
+        return this->stats.toJSON();
+    }
+
+    double bytesPerSec(void) const
+    {
+        return this->stats.bytesPerSec();
+    }
+
+    double transferLatency(void) const
+    {
+        return this->stats.transfer.meanUs();
+    }
+
+    void setupBuffer(void)
+    {
         bool haveScanElements = false;
         if (this->buf) {
             this->buf.reset();
         }
+        this->rateEstimator.reset();
 
-        for (auto c : this->channels)
+        //disable the output scan elements that are not streamed, including
+        //those left enabled by other users, to keep the scan small
+        for (auto c : this->dev->channels())
         {
+            if (!c.isOutput() || !c.isScanElement() || !c.isEnabled()) continue;
+            bool streamed = false;
+            for (size_t i = 0; i < this->channels.size(); i++)
+            {
+                streamed = streamed || (this->channelEnabled[i] && this->channels[i].id() == c.id());
+            }
+            if (!streamed) c.disable();
+        }
+
+        for (size_t i = 0; i < this->channels.size(); i++)
+        {
+            auto &c = this->channels[i];
+            if (c.isScanElement() && !this->channelEnabled[i]) continue;
             c.enable();
 
             if (c.isScanElement())
@@ -228,27 +811,232 @@ public:
 
         //create sample buffer if we've got any scan elements
         if (haveScanElements && this->enablePorts) {
+            if (this->kernelBuffers != 0) this->dev->setKernelBuffersCount(this->kernelBuffers);
             this->buf = std::unique_ptr<IIOBuffer>(new IIOBuffer(std::move(this->dev->createBuffer(this->bufferSize, false))));
             if (!this->buf)
             {
-                throw Pothos::SystemException("IIOSink::activate()", "buffer creation failed");
+                throw Pothos::SystemException("IIOSink::setupBuffer()", "buffer creation failed");
             }
             this->buf->setBlockingMode(false);
+            this->placement.bindMemory(this->buf->start(), static_cast<char *>(this->buf->end()) - static_cast<char *>(this->buf->start()));
         }
     }
 
+    void activate(void)
+    {
+        if (!this->dev)
+        {
+            throw Pothos::SystemException("IIOSink::activate()", "no device specified");
+        }
+
+        //start from the current size, with the matching kernel buffer count
+        if (this->tuner.enabled())
+        {
+            this->deviceRate = this->readSampleRate();
+            this->kernelBuffers = this->tuner.kernelBuffers(this->bufferSize, this->deviceRate);
+            this->nextRateCheck = IIOStreamStats::Clock::now() + std::chrono::seconds(1);
+        }
+        this->tuner.restart();
+        this->nominalRate = this->readSampleRate();
+        this->nextRateReport = IIOStreamStats::Clock::now();
+
+        this->setupBuffer();
+        this->lost = false;
+        this->stats.reset();
+        this->registration.set(this->dev->id(), "sink", this->bufferSize, this->stats);
+    }
+
+    void setRateInterval(const double rateInterval)
+    {
+        if (!(rateInterval >= 0.0))
+        {
+            throw Pothos::RangeException("IIOSink::setRateInterval()", "rate interval must not be negative");
+        }
+        this->rateInterval = rateInterval;
+    }
+
+    double measuredRate(void) const
+    {
+        return this->rateEstimator.rate();
+    }
+
+    double clockDrift(void) const
+    {
+        return this->rateEstimator.driftPpm(this->nominalRate);
+    }
+
+    std::string rateStats(void) const
+    {
+        return this->rateEstimator.toJSON(this->nominalRate);
+    }
+
+    //tell upstream how fast the device consumes samples, every rate interval
+    void reportRate(void)
+    {
+        const auto now = IIOStreamStats::Clock::now();
+        if (this->rateInterval == 0.0 || now < this->nextRateReport) return;
+        this->nextRateReport = now + std::chrono::duration_cast<IIOStreamStats::Clock::duration>(
+            std::chrono::duration<double, std::milli>(this->rateInterval));
+        this->nominalRate = this->readSampleRate();
+
+        Pothos::ObjectKwargs msg;
+        msg["rate"] = Pothos::Object(this->rateEstimator.rate());
+        msg["nominalRate"] = Pothos::Object(this->nominalRate);
+        msg["driftPpm"] = Pothos::Object(this->rateEstimator.driftPpm(this->nominalRate));
+        msg["samples"] = Pothos::Object(this->rateEstimator.samples());
+        msg["locked"] = Pothos::Object(this->rateEstimator.locked());
+        this->output("rate")->postMessage(msg);
+    }
+
     void deactivate(void)
     {
+        this->registration.clear();
         if (this->buf) {
             this->buf.reset();
         }
     }
 
+    void deviceLost(void)
+    {
+        this->buf.reset();
+        this->lost = true;
+        this->lostTime = IIOStreamStats::Clock::now();
+        this->nextRecovery = this->lostTime;
+        this->lostGeneration = IIOContext::get().generation();
+    }
+
+    //give the thread back to the scheduler, counted in the stream stats
+    void countedYield(void)
+    {
+        this->stats.yields.add(1);
+        this->yield();
+    }
+
+    //the device disappeared without failing a transfer
+    void deviceGone(void)
+    {
+        if (!this->autoRecover)
+        {
+            throw Pothos::SystemException("IIOSink::work()", this->deviceId + " is no longer present", ENODEV);
+        }
+        this->deviceLost();
+        this->countedYield();
+    }
+
+    bool recover(void)
+    {
+        //retry at most every 100 ms, sleeping no longer than the work timeout
+        const auto now = IIOStreamStats::Clock::now();
+        if (now < this->nextRecovery)
+        {
+            const auto maxSleep = std::chrono::nanoseconds(this->workInfo().maxTimeoutNs);
+            std::this_thread::sleep_for(std::min<IIOStreamStats::Clock::duration>(this->nextRecovery - now, maxSleep));
+            return false;
+        }
+        this->nextRecovery = now + std::chrono::milliseconds(100);
+
+        //find the device and the same channels in a context created after
+        //the loss; the context is re-created in the background, so that a
+        //slow remote context does not block this thread
+        IIOContext& ctx = IIOContext::get();
+        ctx.rescanAsync();
+        if (ctx.generation() == this->lostGeneration) return false;
+        std::unique_ptr<IIODevice> dev;
+        for (auto d : ctx.devices())
+        {
+            if (d.id() == this->deviceId) dev.reset(new IIODevice(d));
+        }
+        if (!dev) return false;
+        std::vector<IIOChannel> channels;
+        for (auto &old : this->channels)
+        {
+            for (auto c : dev->channels())
+            {
+                if (c.id() == old.id() && c.isOutput() == old.isOutput()) channels.push_back(c);
+            }
+        }
+        if (channels.size() != this->channels.size()) return false;
+
+        //recreate the stream and the stored profiles
+        this->dev = std::move(dev);
+        this->channels = channels;
+        this->attrWriter.reset();
+        try
+        {
+            this->setupBuffer();
+            for (const auto &profile : this->profileConfigs)
+            {
+                this->profiles.load(profile.first, IIOConfig(*this->dev, this->channels, profile.second));
+            }
+        }
+        catch (const Pothos::Exception &)
+        {
+            this->buf.reset();
+            return false;
+        }
+        this->profiles.invalidate();
+        this->registration.set(this->dev->id(), "sink", this->bufferSize, this->stats);
+
+        const auto downtimeNs = IIOStreamStats::elapsedNs(this->lostTime, IIOStreamStats::Clock::now());
+        this->stats.recoveries.add(1);
+        this->stats.downtimeNs.add(downtimeNs);
+        this->lost = false;
+        return true;
+    }
+
+    //apply the attribute updates that arrived since the last push, and
+    //report the index of the next input sample, the first pushed after them
+    void applyAttributeMessages(void)
+    {
+        auto port = this->input("attr");
+        while (port->hasMessage())
+        {
+            const auto msg = port->popMessage();
+            if (msg.type() != typeid(Pothos::ObjectKwargs))
+            {
+                throw Pothos::InvalidArgumentException("IIOSink::applyAttributeMessages()", "expected a dictionary of attribute names to values");
+            }
+            if (!this->attrWriter) this->attrWriter.reset(new IIOAttributeWriter(*this->dev, this->channels));
+            this->profiles.invalidate();
+            this->attrWriter->apply(msg.extract<Pothos::ObjectKwargs>());
+            this->attributesWritten();
+
+            //every channel port consumes the same number of samples
+            unsigned long long index = 0;
+            for (size_t i = 0; i < this->channels.size(); i++)
+            {
+                if (!this->hasPort(i) || !this->enablePorts) continue;
+                index = this->input(this->portName(i))->totalElements();
+                break;
+            }
+            Pothos::ObjectKwargs change;
+            change["index"] = Pothos::Object(index);
+            change["update"] = msg;
+            this->output("attrChange")->postMessage(change);
+        }
+    }
+
     void work(void)
     {
-        auto sample_count = this->workInfo().minInElements;
- 
-        if (this->buf) {
+
+        //never more than the buffer holds, which can shrink while streaming;
+        //the "attr" port carries no samples, so only count the channels
+        size_t sample_count = this->bufferSize;
+        for (size_t i = 0; i < this->channels.size(); i++)
+        {
+            if (this->hasPort(i) && this->enablePorts) sample_count = std::min(sample_count, this->input(this->portName(i))->elements());
+        }
+
+        //discard input while waiting for the device to reappear
+        if (this->lost && !this->recover())
+        {
+            for (auto port : this->inputs()) port->consume(port->elements());
+            return this->countedYield();
+        }
+        this->applyAttributeMessages();
+
+        if (this->buf && sample_count != 0) {
+            auto tPoll = IIOStreamStats::Clock::now();
             #ifndef _MSC_VER
             //wait for samples
             struct pollfd pfd = {
@@ -257,8 +1045,8 @@ public:
                 .revents = 0
             };
             struct timespec ts = {
-                .tv_sec = static_cast<time_t>(this->workInfo().maxTimeoutNs/10000000),
-                .tv_nsec = static_cast<long int>(this->workInfo().maxTimeoutNs % 10000000)
+                .tv_sec = static_cast<time_t>(this->workInfo().maxTimeoutNs/1000000000),
+                .tv_nsec = static_cast<long int>(this->workInfo().maxTimeoutNs % 1000000000)
             };
             int ret = ppoll(&pfd, 1, &ts, NULL);
             #else
@@ -266,25 +1054,82 @@ public:
             fd_set fds; FD_ZERO(&fds); FD_SET(this->buf->fd(), &fds);
             int ret = select(1, NULL, &fds, NULL, &ts);
             #endif
+            //the call returns -1 and leaves the error in errno
             if (ret < 0)
-                throw Pothos::SystemException("IIOSink::work()", "ppoll failed: " + Poco::Error::getMessage(-ret));
-            else if (ret == 0)
-                return this->yield();
+            {
+                const int error = Poco::Error::last();
+                if (error == EINTR) return this->countedYield();
+                throw Pothos::SystemException("IIOSink::work()", "ppoll failed: " + Poco::Error::getMessage(error), error);
+            }
+            const auto tReady = IIOStreamStats::Clock::now();
+            const auto pollNs = IIOStreamStats::elapsedNs(tPoll, tReady);
+            this->stats.pollWait.record(pollNs);
+            if (ret == 0)
+            {
+                this->stats.pollTimeouts.add(1);
+                if (!this->dev->isPresent()) return this->deviceGone();
+                return this->countedYield();
+            }
 
-            //consume samples
-            for (auto c : this->channels)
+            //consume samples, discarding those of channels that are not streamed
+            auto tConvert = IIOStreamStats::Clock::now();
+            if (this->correctionsChanged)
+            {
+                this->corrections.swap(this->nextCorrections);
+                this->correctionsChanged = false;
+            }
+            for (size_t i = 0; i < this->channels.size(); i++)
             {
-                if (c.isScanElement()) {
-                    auto inputPort = this->input(c.id());
+                auto &c = this->channels[i];
+                if (this->hasPort(i)) {
+                    auto inputPort = this->input(this->portName(i));
                     auto inputBuffer = inputPort->buffer();
 
-                    c.write(*this->buf, inputBuffer.as<void*>(), sample_count);
+                    //a pair's Q samples follow its I samples in the scan
+                    const auto &correction = this->corrections[i];
+                    const auto fmt = this->isPaired(i) ? iioIQPairFormat(c.format()) : c.format();
+                    if (this->channelEnabled[i] && !iioCorrectionIsIdentity(correction))
+                    {
+                        iioInterleaveCorrect(fmt, inputBuffer.as<const void*>(), correction,
+                            this->buf->first(c), this->buf->step(), sample_count);
+                    }
+                    else if (this->channelEnabled[i] && this->isPaired(i))
+                    {
+                        iioInterleave(fmt, inputBuffer.as<const void*>(),
+                            this->buf->first(c), this->buf->step(), sample_count);
+                    }
+                    else if (this->channelEnabled[i]) c.write(*this->buf, inputBuffer.as<void*>(), sample_count);
                     inputPort->consume(sample_count);
                 }
             }
 
             //push new samples to iio device
-            this->buf->push(sample_count);
+            const auto tTransfer = IIOStreamStats::Clock::now();
+            this->stats.convert.record(IIOStreamStats::elapsedNs(tConvert, tTransfer));
+            size_t bytes_written = 0;
+            try
+            {
+                bytes_written = this->buf->push(sample_count);
+            }
+            catch (const Pothos::Exception &ex)
+            {
+                if (!this->autoRecover || !iioIsDeviceGone(ex.code())) throw;
+                this->deviceLost();
+                return this->countedYield();
+            }
+            const auto transferNs = IIOStreamStats::elapsedNs(tTransfer, IIOStreamStats::Clock::now());
+            this->stats.transfer.record(transferNs);
+            this->stats.transfers.add(1);
+            this->stats.bytes.add(bytes_written);
+            this->stats.samples.add(sample_count);
+            this->rateEstimator.record(sample_count, tReady, pollNs);
+            this->reportRate();
+
+            if (this->tuner.enabled())
+            {
+                this->tuner.record(sample_count, transferNs, IIOStreamStats::elapsedNs(tConvert, tTransfer));
+                this->retune();
+            }
         }
     }
 };
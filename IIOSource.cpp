@@ -8,12 +8,31 @@
 #else
 #include <winsock2.h>
 #endif
+#ifdef __linux__
+#include <unistd.h>
+#include <linux/iio/events.h>
+#endif
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
 #include <memory>
 #include <string>
+#include <cerrno>
 #include <cstring>
+#include <functional>
+#include <thread>
 #include <vector>
 #include "IIOSupport.hpp"
+#include "IIOBufferBroker.hpp"
+#include "IIOBufferPool.hpp"
+#include "IIOBufferTuner.hpp"
+#include "IIOChangeLog.hpp"
+#include "IIOConvert.hpp"
+#include "IIODeviceCache.hpp"
+#include "IIOConfig.hpp"
+#include "IIOPlacement.hpp"
+#include "IIOStats.hpp"
 
 #include <json.hpp>
 using json = nlohmann::json;
@@ -23,6 +42,182 @@ using json = nlohmann::json;
  *
  * The IIO source forwards an IIO input device to an output sample stream.
  *
+ * Several attributes can be changed at once with the setConfig() call, which
+ * takes a JSON object of the form
+ * {"device": {"attr": value}, "channels": {"id": {"attr": value}}}.
+ * A channel ID can be written as "in:id" or "out:id" to pick the input or
+ * output channel of a device where both have the same ID. The writes are
+ * applied in dependency order (sample rate, frequency, bandwidth, gain
+ * mode, gain, other) without tearing down the stream, and a JSON report
+ * with per-attribute errors and timing is returned.
+ *
+ * For fast retuning, configurations in the same format can be stored once
+ * with loadProfile(name, config) and then applied with switchProfile(name).
+ * Profiles are validated and pre-resolved when loaded, and a switch only
+ * writes the attributes that differ from the previous switch. Writes made
+ * through the block are taken into account; setProfileReadBack(true) also
+ * catches changes made from elsewhere, by reading back each attribute a
+ * switch would skip. The duration of the last switch is available from the
+ * profileSwitchLatency probe (in microseconds), and profileStats() reports
+ * the measured per-attribute write times.
+ *
+ * Data path statistics are always collected: the streamStats probe returns a
+ * JSON object with refill latency, poll wait and conversion time histograms
+ * (power-of-two nanosecond bins), poll timeout and yield counts, and byte
+ * and sample totals. The bytesPerSec and transferLatency (mean, in
+ * microseconds) probes report the headline numbers.
+ *
+ * If the device disappears while streaming (for example an unplugged USB
+ * device or a lost network connection), the block keeps running instead of
+ * failing: it re-scans the IIO context in the background every 100 ms, and
+ * once a device with the same ID and channels reappears it re-creates the
+ * buffer, reloads any stored profiles and resumes streaming. A local device
+ * that is unregistered only stops reporting poll events, so on poll timeouts
+ * the block checks that the device still exists. A "discontinuity" label whose
+ * data is the downtime in nanoseconds marks the first sample after the gap
+ * on every output port. The recoveries and total downtime are reported
+ * by streamStats. Only errors meaning that the device or the connection to
+ * it is gone (such as ENODEV) start a recovery; other transfer errors, and
+ * any loss with autoRecover disabled, fail the topology.
+ *
+ * In the pretrigger capture mode the block produces no output while it is
+ * armed. Instead it keeps the latest samples of every channel in an
+ * in-memory ring, and when triggered it emits the preTrigger samples before
+ * the trigger plus the postTrigger samples from the trigger onwards as one
+ * burst. The first sample of a burst carries a "burst" label whose data is
+ * the offset of the trigger sample within the burst (which is less than
+ * preTrigger if not enough history was available). The block re-arms once
+ * the burst has been produced; triggers during a burst are ignored.
+ * The trigger source is one of:
+ * <ul>
+ * <li>message: the trigger() slot, which triggers at the latest sample</li>
+ * <li>level: a sample of triggerChannel crossing triggerLevel in the
+ * triggerSlope direction, checked as each refill is converted</li>
+ * <li>event: any IIO event of the device, such as a threshold crossing
+ * (local context only)</li>
+ * </ul>
+ * The capture mode, preTrigger and trigger source take effect when the block
+ * is activated; the other trigger settings take effect immediately.
+ * A burst that is interrupted by the device disappearing ends early, and the
+ * history after a recovery starts at the recovery.
+ *
+ * To cut the bandwidth entering the graph, channels can be decimated as
+ * they are converted from the device buffer, so that only every factor-th
+ * output is produced. The decimation map gives the factor of each channel.
+ * A decimation order of 1 averages each block of factor samples
+ * (integrate-and-dump); higher orders use a CIC filter of that order for
+ * better alias rejection, whose first outputs are a start-up transient.
+ * Outputs are normalized to the input scale and keep the channel's type.
+ * Decimation applies to the stream capture mode only.
+ *
+ * To save the extra passes of separate correction blocks, the samples of
+ * each channel can be corrected as they are converted from the device
+ * buffer. The correction map gives, per channel, a dictionary with the
+ * optional keys "offset" (the device's DC offset, which is subtracted,
+ * in converted sample units) and "gain" (a factor applied after that).
+ * I/Q pairs also take "offsetQ" (the DC offset of the Q samples, while
+ * "offset" is that of the I samples), "amplitude" (the gain of the Q path
+ * relative to the I path) and "phase" (the Q path's error from quadrature,
+ * in degrees), whose imbalance is undone. Corrected samples are rounded
+ * and saturate at the limits of the channel's bits. New corrections are
+ * prepared as they are set and take effect together, on all ports, at the
+ * first sample of the next refill, so no refill mixes two of them.
+ *
+ * The channels that are streamed can be narrowed down at runtime with
+ * setEnabledChannels(), which takes a subset of the block's channel IDs and
+ * quickly re-creates the buffer; the outputs of the other channels stay
+ * idle. Scan elements of the device that are not streamed are explicitly
+ * disabled, including those left enabled by previous users, so that the
+ * scan only carries the selected channels. The bytesPerScan probe reports
+ * the resulting scan size. In the stream capture mode, a "discontinuity"
+ * label whose data is the rebuild time in nanoseconds marks the first sample
+ * after a rebuild. In the pretrigger mode, rebuilds wait until the current
+ * burst has been produced.
+ *
+ * Normally the block owns the device's input buffer, so only one block can
+ * stream from a device. With shareBuffer enabled, the block subscribes to a
+ * per-device buffer broker instead: the broker refills one buffer with the
+ * channels of all subscribed blocks and fans each refill out to them
+ * without further copies, so several blocks (for example in different
+ * graphs) can stream different channels of one device. The shared buffer
+ * uses the largest bufferSize of the subscribers. A block that falls
+ * behind the others loses the oldest refills, and like a buffer re-created
+ * when subscribers change, this is marked with a "discontinuity" label.
+ * The setting takes effect when the block is activated.
+ *
+ * On machines with many cores, the work thread can be pinned to the CPUs in
+ * cpuAffinity and given a real-time realtimePriority, and memory can be
+ * placed on numaNode, typically the node the device's DMA engine is
+ * attached to. The block's work then runs in a one thread pool of its own
+ * with that affinity (the node's CPUs if no CPUs are given) and priority,
+ * leaving the threads of the shared pool alone, and the placement is
+ * applied to the refill thread of the shared buffer broker. The IIO
+ * buffer is moved to the node when it is created, and the output buffers
+ * of the block are allocated there when the topology is committed. Real-time
+ * priorities usually need the CAP_SYS_NICE capability or an rtprio limit.
+ * Placement is supported on Linux only.
+ *
+ * The output port buffers come from a pool owned by the block: one slab
+ * of memory for all ports, backed by 2 MB huge pages where the system
+ * allows it and pre-faulted when it is allocated, with four buffers of
+ * bufferSize samples per port. The slab is reused when the block is
+ * committed again, so steady-state streaming takes no page faults in the
+ * port buffers. Blocks downstream that bring their own buffer domain keep
+ * using their own buffers.
+ *
+ * Instead of a fixed bufferSize, the block can size its buffer itself. It
+ * measures the overhead of each refill and the conversion cost of each
+ * sample, and reads the sample rate from the sampling_frequency attribute
+ * (or measures it, if the device has no such attribute). In the latency
+ * buffer mode, a buffer then holds the samples of targetLatency, unless the
+ * refill overhead requires a larger buffer to keep up. In the cpu mode, it
+ * is the smallest buffer that keeps the block's load within cpuBudget.
+ * Sizes are powers of two between 64 and 65536 samples, starting from
+ * bufferSize. The kernel buffer count is raised with small buffers so that
+ * 20 ms of scheduling delay cannot overflow the device. The sample rate is
+ * checked every second and after attributes are written through the block,
+ * and the buffer is re-created when the best size changes, which is marked
+ * like any other rebuild. The bufferTuning probe reports the estimates.
+ * Automatic sizing applies when the block owns the device buffer, not with
+ * shareBuffer, and does not grow the buffer past bufferSize when a
+ * downstream block provides the output buffers.
+ *
+ * For closed loops inside the graph, such as an AGC, attributes can also be
+ * written with messages on the "attr" input port. A message is a dictionary
+ * of attribute names to values, for example {"voltage0/hardwaregain": -10},
+ * where device attributes are named "attr" and channel attributes
+ * "channelId/attr" (the names the attribute monitor reports). The messages
+ * are applied between refills, in dependency order. Samples already queued
+ * in kernel buffers were taken before a change; fewer kernel buffers tighten
+ * the loop. With shareBuffer, messages are applied between shared refills.
+ *
+ * Every attribute write made through the block (the attribute setters,
+ * setConfig(), switchProfile() and "attr" messages) is logged with its wall
+ * clock time, and in the stream capture mode the first sample taken after
+ * the write carries an "attrChange" label on every output port, so that
+ * guard intervals downstream only need to cover the hardware's settling
+ * time. The label data is a dictionary with the written attributes as
+ * "update", named like "attr" messages, and the write time in nanoseconds
+ * since the epoch as "timeNs". When the device's timestamp channel is
+ * among the streamed channels, the sample is found from the timestamps,
+ * in the clock the device's current_timestamp_clock attribute selects.
+ * Otherwise it is estimated from the sampling_frequency attribute and the
+ * time each refill completed, and without a sample rate the label marks
+ * the first sample of the next refill. The attributeLog probe returns the
+ * last 256 writes as JSON, with the stream sample each one was labeled on.
+ *
+ * An I/Q channel pair such as voltage0_i and voltage0_q that is selected by
+ * its name (voltage0) in channelIds streams to a single output port named
+ * after the pair, with complex samples of the channels' type; channels
+ * selected by their own IDs keep separate ports. Channels pair when they
+ * have the same sample format and the Q sample directly follows the I
+ * sample in a scan, so that each complex sample is converted in the same
+ * single pass as a real one. Wherever the block takes channel IDs
+ * (enabledChannels, decimation, correction, triggerChannel), the pair's
+ * name and the IDs of both of its channels select the pair, and a level
+ * trigger on a pair compares its I samples. Attributes are still set per
+ * channel.
+ *
  * |category /IIO
  * |category /Sources
  * |keywords iio industrial io adc sdr
@@ -31,13 +226,16 @@ using json = nlohmann::json;
  * |default ""
  *
  * |param channelIds[Channel IDs] The IDs of channels to enable.
- * If no IDs are specified, all channels will be enabled.
+ * If no IDs are specified, all channels will be enabled. The name of an
+ * I/Q pair (voltage0 for voltage0_i and voltage0_q) enables both channels
+ * through one complex port.
  * |preview disable
  * |default []
  *
  * |param enablePorts[Enable Ports] If true and compatible channels are
- * enabled, enable input ports. This option reserves the IIO buffer for this
- * device, and so can only be enabled for one IIO block per device.
+ * enabled, enable output ports. Unless shareBuffer is enabled, this option
+ * reserves the IIO buffer for this device, and so can only be enabled for
+ * one IIO block per device.
  * |preview disable
  * |widget ToggleSwitch(on=True,off=False)
  * |default true
@@ -47,8 +245,131 @@ using json = nlohmann::json;
  * increase latency.
  * |preview disable
  * |default 2048
- * 
+ *
+ * |param bufferMode[Buffer Mode] Use bufferSize as given, or size the
+ * buffer for a target latency or CPU budget.
+ * |option [Fixed] "fixed"
+ * |option [Latency] "latency"
+ * |option [CPU] "cpu"
+ * |preview valid
+ * |default "fixed"
+ *
+ * |param targetLatency[Target Latency] The time one buffer may take to
+ * fill in the latency buffer mode.
+ * |units us
+ * |preview valid
+ * |default 1000
+ *
+ * |param cpuBudget[CPU Budget] The fraction of one core the block may
+ * spend on refills and conversion in the cpu buffer mode.
+ * |preview valid
+ * |default 0.1
+ *
+ * |param autoRecover[Auto Recover] If true, recover from the device
+ * disappearing by waiting for it to reappear; otherwise stop with an error.
+ * |preview valid
+ * |widget ToggleSwitch(on=True,off=False)
+ * |default true
+ *
+ * |param captureMode[Capture Mode] Stream continuously, or only emit bursts
+ * around a trigger.
+ * |option [Stream] "stream"
+ * |option [Pre-trigger] "pretrigger"
+ * |preview valid
+ * |default "stream"
+ *
+ * |param preTrigger[Pre-trigger Samples] The number of samples before the
+ * trigger to emit with each burst.
+ * |preview valid
+ * |default 4096
+ *
+ * |param postTrigger[Post-trigger Samples] The number of samples from the
+ * trigger onwards to emit with each burst.
+ * |preview valid
+ * |default 4096
+ *
+ * |param triggerSource[Trigger Source] What triggers a burst in the
+ * pretrigger capture mode.
+ * |option [Message] "message"
+ * |option [Level] "level"
+ * |option [Event] "event"
+ * |preview valid
+ * |default "message"
+ *
+ * |param triggerChannel[Trigger Channel] The ID of the channel whose
+ * samples the level trigger checks.
+ * |preview valid
+ * |default ""
+ *
+ * |param triggerLevel[Trigger Level] The level of the level trigger,
+ * in converted sample units.
+ * |preview valid
+ * |default 0
+ *
+ * |param triggerSlope[Trigger Slope] The crossing direction of the level
+ * trigger.
+ * |option [Rising] "rising"
+ * |option [Falling] "falling"
+ * |preview valid
+ * |default "rising"
+ *
+ * |param decimation[Decimation] A map of channel IDs to decimation factors,
+ * for example {"voltage0": 8}. Channels that are not listed are not decimated.
+ * |preview valid
+ * |default {}
+ *
+ * |param decimationOrder[Decimation Order] 1 for block averaging, or the
+ * order of the CIC decimation filter.
+ * |preview valid
+ * |default 1
+ *
+ * |param correction[Correction] A map of channel IDs to corrections of
+ * their samples, for example {"voltage0": {"offset": -12, "gain": 1.05}}.
+ * Channels that are not listed are not corrected.
+ * |preview valid
+ * |default {}
+ *
+ * |param enabledChannels[Enabled Channels] The IDs of the channels to
+ * stream, out of the block's channels. If no IDs are specified, all of them
+ * are streamed.
+ * |preview valid
+ * |default []
+ *
+ * |param shareBuffer[Share Buffer] If true, share the device's buffer with
+ * other source blocks that also enable this option.
+ * |preview valid
+ * |widget ToggleSwitch(on=True,off=False)
+ * |default false
+ *
+ * |param cpuAffinity[CPU Affinity] The CPUs that the block's threads may
+ * run on. If no CPUs are specified, the threads may run on any CPU.
+ * |preview valid
+ * |default []
+ *
+ * |param realtimePriority[Real-time Priority] The real-time priority
+ * (1 to 99, as for SCHED_FIFO) of the block's threads, or 0 for normal
+ * scheduling.
+ * |preview valid
+ * |default 0
+ *
+ * |param numaNode[NUMA Node] The NUMA node to allocate buffers from,
+ * or -1 for any node.
+ * |preview valid
+ * |default -1
+ *
  * |factory /iio/source(deviceId, channelIds, enablePorts, bufferSize)
+ * |setter setAutoRecover(autoRecover)
+ * |setter setBufferTuning(bufferMode, targetLatency, cpuBudget)
+ * |setter setCaptureMode(captureMode)
+ * |setter setPreTriggerSamples(preTrigger)
+ * |setter setPostTriggerSamples(postTrigger)
+ * |setter setTriggerSource(triggerSource)
+ * |setter setTriggerLevel(triggerChannel, triggerLevel, triggerSlope)
+ * |setter setDecimation(decimation, decimationOrder)
+ * |setter setCorrection(correction)
+ * |setter setEnabledChannels(enabledChannels)
+ * |setter setShareBuffer(shareBuffer)
+ * |setter setPlacement(cpuAffinity, realtimePriority, numaNode)
  **********************************************************************/
 class IIOSource : public Pothos::Block
 {
@@ -56,15 +377,148 @@ private:
     std::unique_ptr<IIODevice> dev;
     std::unique_ptr<IIOBuffer> buf;
     std::vector<IIOChannel> channels;
+    std::vector<bool> channelEnabled;
+
+    //for each channel, the other channel of its I/Q pair,
+    //or channels.size() for a channel with a port of its own
+    std::vector<size_t> iqPairs;
     bool enablePorts;
     size_t bufferSize;
+    IIOConfigProfiles profiles;
+    IIOStreamStats stats;
+    IIOStreamRegistration registration;
+    std::string deviceId;
+    std::map<std::string, std::string> profileConfigs;
+    bool autoRecover;
+    bool lost;
+    unsigned long long lostGeneration;
+    IIOStreamStats::Clock::time_point lostTime;
+    IIOStreamStats::Clock::time_point nextRecovery;
+
+    //pretrigger capture settings
+    std::string captureMode;
+    size_t preTrigger;
+    size_t postTrigger;
+    std::string triggerSource;
+    std::string triggerChannel;
+    double triggerLevel;
+    bool triggerRising;
+
+    //pretrigger capture state; sample positions count every sample
+    //written to the ring since activation
+    std::vector<std::vector<char>> ring;
+    size_t ringCapacity;
+    unsigned long long ringStart;
+    unsigned long long ringWritten;
+    bool capturing;
+    bool triggerPending;
+
+    //changes that re-create the buffer, held back until the burst ends
+    std::vector<std::function<void(void)>> pendingRebuilds;
+    unsigned long long burstStart;
+    unsigned long long burstTrigger;
+    unsigned long long burstEnd;
+    unsigned long long burstEmitted;
+    size_t levelChannel;
+    double levelLast;
+    int eventFd;
+
+    //decimation factors by channel ID, and the filters indexed like channels
+    std::map<std::string, size_t> decimation;
+    size_t decimationOrder;
+    std::vector<IIODecimator> decimators;
+
+    //sample corrections indexed like channels: the ones in use, and the
+    //ones that take their place at the next refill
+    std::vector<IIOCorrection> corrections;
+    std::vector<IIOCorrection> nextCorrections;
+    bool correctionsChanged;
+
+    //subscription to the shared buffer, and the chunk being converted
+    bool shareBuffer;
+    std::unique_ptr<IIOBufferBroker::Subscription> subscription;
+    IIOBufferBroker::ChunkPtr chunk;
+    size_t chunkOffset;
+    bool haveSequence;
+    unsigned long long nextSequence;
+    IIOBufferBroker::Clock::time_point lastChunkTime;
+
+    //thread and memory placement, and the thread pool the
+    //block had before a placement gave it a dedicated one
+    IIOPlacement placement;
+    Pothos::ThreadPool unplacedPool;
+
+    //pre-faulted memory for the output buffers, kept across commits
+    std::shared_ptr<IIOBufferPool> bufferPool;
+    size_t portBufferSize;
+
+    //automatic buffer sizing; a kernel buffer count of 0 leaves the device's alone
+    IIOBufferTuner tuner;
+    size_t fixedBufferSize;
+    size_t kernelBuffers;
+    double deviceRate;
+    IIOStreamStats::Clock::time_point nextRateCheck;
+
+    //writers for the "attr" port, and the log of attribute writes; the
+    //anchor is the refill whose last sample was taken when it completed
+    std::unique_ptr<IIOAttributeWriter> attrWriter;
+    std::map<std::string, Pothos::ObjectKwargs> profileUpdates;
+    IIOChangeLog changeLog;
+    double changeRate;
+    IIOStreamStats::Clock::time_point anchorTime;
+    unsigned long long anchorSample;
+    std::vector<long long> timestamps;
 public:
     IIOSource(const std::string &deviceId, const std::vector<std::string> &channelIds,
         const bool &enablePorts, const size_t &bufferSize)
-        : enablePorts(enablePorts), bufferSize(bufferSize)
+        : enablePorts(enablePorts), bufferSize(bufferSize),
+          deviceId(deviceId), autoRecover(true), lost(false), lostGeneration(0),
+          captureMode("stream"), preTrigger(4096), postTrigger(4096),
+          triggerSource("message"), triggerLevel(0.0), triggerRising(true),
+          ringCapacity(0), ringStart(0), ringWritten(0), capturing(false), triggerPending(false),
+          burstStart(0), burstTrigger(0), burstEnd(0), burstEmitted(0),
+          levelChannel(0), levelLast(0.0), eventFd(-1), decimationOrder(1), correctionsChanged(false),
+          shareBuffer(false), chunkOffset(0), haveSequence(false), nextSequence(0),
+          bufferPool(IIOBufferPool::make()), portBufferSize(0),
+          fixedBufferSize(bufferSize), kernelBuffers(0), deviceRate(0.0),
+          changeRate(0.0), anchorSample(0)
     {
         //expose overlay hook
         this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, overlay));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, setConfig));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, loadProfile));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, switchProfile));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, profileSwitchLatency));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, profileStats));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, setProfileReadBack));
+        this->registerProbe("profileSwitchLatency");
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, streamStats));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, bytesPerSec));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, transferLatency));
+        this->registerProbe("streamStats");
+        this->registerProbe("bytesPerSec");
+        this->registerProbe("transferLatency");
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, setAutoRecover));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, setBufferTuning));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, bufferTuning));
+        this->registerProbe("bufferTuning");
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, attributeLog));
+        this->registerProbe("attributeLog");
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, setCaptureMode));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, setPreTriggerSamples));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, setPostTriggerSamples));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, setTriggerSource));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, setTriggerLevel));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, trigger));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, setDecimation));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, setCorrection));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, setEnabledChannels));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, setShareBuffer));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, setPlacement));
+        this->registerCall(this, POTHOS_FCN_TUPLE(IIOSource, bytesPerScan));
+        this->registerProbe("bytesPerScan");
+        this->registerSlot("trigger");
+        this->setupInput("attr");
 
         //get libiio context
         IIOContext& ctx = IIOContext::get();
@@ -95,9 +549,9 @@ public:
             Pothos::Callable attrGetter(&IIOSource::getDeviceAttribute);
             Pothos::Callable attrSetter(&IIOSource::setDeviceAttribute);
             attrGetter.bind(std::ref(*this), 0);
-            attrGetter.bind(a, 1);
+            attrGetter.bind(a.name(), 1);
             attrSetter.bind(std::ref(*this), 0);
-            attrSetter.bind(a, 1);
+            attrSetter.bind(a.name(), 1);
 
             std::string getDeviceAttrName = "deviceAttribute[" + a.name() + "]";
             std::string setDeviceAttrName = "setdeviceAttribute[" + a.name() + "]";
@@ -111,17 +565,10 @@ public:
         {
             if (c.isOutput())
                 continue;
-            std::string cId = c.id();
-            if (channelIds.size() > 0 && std::none_of(channelIds.begin(), channelIds.end(),
-                    [cId](std::string s){ return s == cId; }))
+            if (!iioChannelSelected(c.id(), channelIds))
                 continue;
             this->channels.push_back(c);
-
-            //set up output ports for scannable input channels
-            if (c.isScanElement() && this->enablePorts)
-            {
-                this->setupOutput(c.id(), c.dtype());
-            }
+            this->channelEnabled.push_back(true);
 
             //set up probes/setters for channel attributes
             for (auto a : c.attributes())
@@ -129,9 +576,11 @@ public:
                 Pothos::Callable attrGetter(&IIOSource::getChannelAttribute);
                 Pothos::Callable attrSetter(&IIOSource::setChannelAttribute);
                 attrGetter.bind(std::ref(*this), 0);
-                attrGetter.bind(a, 1);
+                attrGetter.bind(c.id(), 1);
+                attrGetter.bind(a.name(), 2);
                 attrSetter.bind(std::ref(*this), 0);
-                attrSetter.bind(a, 1);
+                attrSetter.bind(c.id(), 1);
+                attrSetter.bind(a.name(), 2);
 
                 std::string getChannelAttrName = "channelAttribute[" + c.id() + "][" + a.name() + "]";
                 std::string setChannelAttrName = "setChannelAttribute[" + c.id() + "][" + a.name() + "]";
@@ -140,12 +589,20 @@ public:
                 this->registerProbe(getChannelAttrName);
             }
         }
+
+        //set up output ports for scannable input channels, one per I/Q pair
+        this->iqPairs = iioFindIQPairs(this->channels, channelIds);
+        for (size_t i = 0; i < this->channels.size(); i++)
+        {
+            if (!this->hasPort(i) || !this->enablePorts) continue;
+            const auto &fmt = this->channels[i].format();
+            this->setupOutput(this->portName(i), this->isPaired(i) ? iioIQPairDType(fmt) : this->channels[i].dtype());
+        }
+        this->corrections.resize(this->channels.size());
     }
 
     std::string overlay(void) const
     {
-        IIOContext& ctx = IIOContext::get();
-
         json topObj;
         auto &params = topObj["params"];
 
@@ -163,14 +620,14 @@ public:
         deviceIdOpts.push_back(emptyOption);
 
         //enumerate iio devices
-        for (auto d : ctx.devices())
+        for (const auto &d : IIODeviceCache::get().devices())
         {
             //use the standard label convention, but fall-back on driver/serial
             std::string name;
 
             json option;
-            option["name"] = d.name() + " (" + d.id() + ")";
-            option["value"] = "\"" + d.id() + "\"";
+            option["name"] = d.second + " (" + d.first + ")";
+            option["value"] = "\"" + d.first + "\"";
             deviceIdOpts.push_back(option);
         }
         params.push_back(deviceIdParam);
@@ -184,40 +641,505 @@ public:
         return new IIOSource(deviceId, channelIds, enablePorts, bufferSize);
     }
 
-    std::string getDeviceAttribute(IIOAttr<IIODevice> a)
+    bool isPaired(const size_t i) const
     {
-        return a.value();
+        return this->iqPairs[i] != this->channels.size();
     }
 
-    void setDeviceAttribute(IIOAttr<IIODevice> a, Pothos::Object value)
+    //is channel i the Q channel of a pair, which streams through the I channel's port?
+    //(told apart by ID, since the Q channel may come first in channels)
+    bool isPairQ(const size_t i)
     {
-        a = value.toString();
+        const auto id = this->channels[i].id();
+        return this->isPaired(i) && id.compare(id.size() - 2, 2, "_q") == 0;
     }
 
-    std::string getChannelAttribute(IIOAttr<IIOChannel> a)
+    //does channel i stream to an output port, on its own or as the I channel of a pair?
+    bool hasPort(const size_t i)
     {
-        return a.value();
+        return this->channels[i].isScanElement() && !this->isPairQ(i);
     }
 
-    void setChannelAttribute(IIOAttr<IIOChannel> a, Pothos::Object value)
+    std::string portName(const size_t i)
     {
-        a = value.toString();
+        return this->isPaired(i) ? iioIQPairName(this->channels[i].id()) : this->channels[i].id();
     }
 
-    void activate(void)
+    //the format of a port's samples in the scan, starting at its first channel
+    struct iio_data_format portFormat(const size_t i)
+    {
+        return this->isPaired(i) ? iioIQPairFormat(this->channels[i].format()) : this->channels[i].format();
+    }
+
+    //the channel of the port that a port name or channel ID refers to
+    size_t portIndex(const std::string &name)
+    {
+        for (size_t i = 0; i < this->channels.size(); i++)
+        {
+            if (this->channels[i].id() == name || (this->hasPort(i) && this->portName(i) == name))
+            {
+                return this->isPairQ(i) ? this->iqPairs[i] : i;
+            }
+        }
+        return this->channels.size();
+    }
+
+    //attributes are looked up by name on each call,
+    //since the device is replaced when the stream recovers
+    std::string getDeviceAttribute(const std::string &attr)
+    {
+        return this->dev->attributes().at(attr).value();
+    }
+
+    void setDeviceAttribute(const std::string &attr, Pothos::Object value)
+    {
+        this->profiles.invalidate();
+        this->dev->attributes().at(attr) = value.toString();
+        this->nextRateCheck = IIOStreamStats::Clock::time_point();
+        Pothos::ObjectKwargs update;
+        update[attr] = value;
+        this->recordChange(update);
+    }
+
+    IIOChannel &channel(const std::string &channelId)
+    {
+        for (auto &c : this->channels)
+        {
+            if (c.id() == channelId) return c;
+        }
+        throw Pothos::NotFoundException("IIOSource::channel()", "channel not found: " + channelId);
+    }
+
+    std::string getChannelAttribute(const std::string &channelId, const std::string &attr)
+    {
+        return this->channel(channelId).attributes().at(attr).value();
+    }
+
+    void setChannelAttribute(const std::string &channelId, const std::string &attr, Pothos::Object value)
+    {
+        this->profiles.invalidate();
+        this->channel(channelId).attributes().at(attr) = value.toString();
+        this->nextRateCheck = IIOStreamStats::Clock::time_point();
+        Pothos::ObjectKwargs update;
+        update[channelId + "/" + attr] = value;
+        this->recordChange(update);
+    }
+
+    void setAutoRecover(const bool autoRecover)
+    {
+        this->autoRecover = autoRecover;
+    }
+
+    void setBufferTuning(const std::string &mode, const double targetLatency, const double cpuBudget)
+    {
+        this->tuner.configure(mode, targetLatency, cpuBudget, false);
+        this->tuner.restart();
+        this->nextRateCheck = IIOStreamStats::Clock::time_point();
+
+        //back to the factory's size, and libiio's default of four
+        //kernel buffers if we changed the count
+        if (!this->tuner.enabled() && (this->bufferSize != this->fixedBufferSize || this->kernelBuffers != 0))
+        {
+            this->resizeBuffer(this->fixedBufferSize, this->kernelBuffers ? 4 : 0);
+        }
+    }
+
+    std::string bufferTuning(void) const
+    {
+        return this->tuner.toJSON(this->tuningRate(), this->bufferSize, this->kernelBuffers);
+    }
+
+    void setCaptureMode(const std::string &mode)
+    {
+        if (mode != "stream" && mode != "pretrigger")
+        {
+            throw Pothos::InvalidArgumentException("IIOSource::setCaptureMode()", "unknown capture mode: " + mode);
+        }
+        this->captureMode = mode;
+    }
+
+    void setPreTriggerSamples(const size_t samples)
+    {
+        this->preTrigger = samples;
+    }
+
+    void setPostTriggerSamples(const size_t samples)
+    {
+        this->postTrigger = samples;
+    }
+
+    void setTriggerSource(const std::string &source)
+    {
+        if (source != "message" && source != "level" && source != "event")
+        {
+            throw Pothos::InvalidArgumentException("IIOSource::setTriggerSource()", "unknown trigger source: " + source);
+        }
+        this->triggerSource = source;
+    }
+
+    void setTriggerLevel(const std::string &channelId, const double level, const std::string &slope)
+    {
+        if (slope != "rising" && slope != "falling")
+        {
+            throw Pothos::InvalidArgumentException("IIOSource::setTriggerLevel()", "unknown trigger slope: " + slope);
+        }
+        //validate the channel before changing any state
+        const bool armed = !this->ring.empty();
+        const size_t levelChannel = armed ? this->findLevelChannel(channelId) : this->channels.size();
+        this->triggerChannel = channelId;
+        this->triggerLevel = level;
+        this->triggerRising = (slope == "rising");
+        if (!armed) return;
+        this->levelChannel = levelChannel;
+        this->levelLast = std::numeric_limits<double>::quiet_NaN();
+    }
+
+    void setDecimation(const Pothos::ObjectKwargs &factors, const size_t order)
+    {
+        if (order < 1)
+        {
+            throw Pothos::InvalidArgumentException("IIOSource::setDecimation()", "decimation order must be at least 1");
+        }
+        std::map<std::string, size_t> decimation;
+        for (const auto &entry : factors)
+        {
+            const auto factor = entry.second.convert<size_t>();
+            if (factor < 1)
+            {
+                throw Pothos::InvalidArgumentException("IIOSource::setDecimation()", "decimation factor must be at least 1: " + entry.first);
+            }
+            std::string name = entry.first;
+            if (this->dev)
+            {
+                const size_t i = this->portIndex(entry.first);
+                if (i == this->channels.size())
+                {
+                    throw Pothos::NotFoundException("IIOSource::setDecimation()", "channel not found: " + entry.first);
+                }
+                if (!this->hasPort(i) || !iioDecimatorFits(this->portFormat(i), factor, order))
+                {
+                    throw Pothos::InvalidArgumentException("IIOSource::setDecimation()", "cannot decimate " + entry.first + " by " +
+                        std::to_string(factor) + " with order " + std::to_string(order));
+                }
+                name = this->portName(i);
+            }
+            decimation[name] = factor;
+        }
+        this->decimation = decimation;
+        this->decimationOrder = order;
+        this->setupDecimation();
+    }
+
+    //(re)start the decimation filters, one per port
+    void setupDecimation(void)
+    {
+        this->decimators.clear();
+        for (size_t i = 0; i < this->channels.size(); i++)
+        {
+            auto it = this->hasPort(i) ? this->decimation.find(this->portName(i)) : this->decimation.end();
+            if (it == this->decimation.end() || it->second == 1) this->decimators.emplace_back();
+            else this->decimators.emplace_back(it->second, this->decimationOrder, this->portFormat(i).repeat ? this->portFormat(i).repeat : 1);
+        }
+    }
+
+    void setCorrection(const Pothos::ObjectKwargs &correction)
+    {
+        std::vector<IIOCorrection> corrections(this->channels.size());
+        for (const auto &entry : correction)
+        {
+            //without a device there are no ports, so only check the values
+            const auto params = entry.second.convert<Pothos::ObjectKwargs>();
+            if (!this->dev)
+            {
+                iioCorrectionFromKwargs(params, true);
+                continue;
+            }
+            const size_t i = this->portIndex(entry.first);
+            if (i == this->channels.size() || !this->hasPort(i))
+            {
+                throw Pothos::NotFoundException("IIOSource::setCorrection()", "channel not found: " + entry.first);
+            }
+            corrections[i] = iioCorrectionFromKwargs(params, this->isPaired(i));
+        }
+
+        //switched to by work() between refills, so that every refill is converted with one set
+        this->nextCorrections = corrections;
+        this->correctionsChanged = true;
+    }
+
+    //convert count samples of a port from the device buffer, correcting them if configured
+    void deinterleave(const size_t i, const void *first, const ptrdiff_t step, void *dst, const size_t count)
+    {
+        const auto fmt = this->portFormat(i);
+        const auto &correction = this->corrections[i];
+        if (iioCorrectionIsIdentity(correction)) iioDeinterleave(fmt, first, step, dst, count);
+        else iioDeinterleaveCorrect(fmt, first, step, correction, dst, count);
+    }
+
+    void setEnabledChannels(const std::vector<std::string> &channelIds)
+    {
+        std::vector<bool> enabled(this->channels.size(), channelIds.empty());
+        for (const auto &id : channelIds)
+        {
+            const size_t i = this->portIndex(id);
+            if (i == this->channels.size())
+            {
+                throw Pothos::NotFoundException("IIOSource::setEnabledChannels()", "channel not found: " + id);
+            }
+            enabled[i] = true;
+            if (this->isPaired(i)) enabled[this->iqPairs[i]] = true;
+        }
+        if (enabled == this->channelEnabled) return;
+
+        //the scan layout changes, so the buffer has to be re-created
+        this->changeBuffer([this, enabled](void)
+        {
+            this->channelEnabled = enabled;
+        });
+    }
+
+    //apply a change that needs a new buffer; a rebuild resets the ring,
+    //so during a burst the change waits for the burst to be produced
+    void changeBuffer(const std::function<void(void)> &change)
+    {
+        this->pendingRebuilds.push_back(change);
+        if (this->capturing) return;
+        this->applyPendingRebuilds();
+        this->rebuildBuffer();
+    }
+
+    bool applyPendingRebuilds(void)
+    {
+        if (this->pendingRebuilds.empty()) return false;
+        for (const auto &change : this->pendingRebuilds) change();
+        this->pendingRebuilds.clear();
+        return true;
+    }
+
+    //re-create the buffer while active, marking the samples lost meanwhile
+    void rebuildBuffer(void)
+    {
+        if (!this->isActive() || this->lost) return;
+        const auto start = IIOStreamStats::Clock::now();
+        this->setupBuffer();
+        this->setupCapture();
+        this->registration.set(this->dev->id(), this->shareBuffer ? "source (shared)" : "source", this->bufferSize, this->stats);
+        if (this->streaming()) this->markGap(IIOStreamStats::elapsedNs(start, IIOStreamStats::Clock::now()));
+    }
+
+    void resizeBuffer(const size_t bufferSize, const size_t kernelBuffers)
+    {
+        this->changeBuffer([this, bufferSize, kernelBuffers](void)
+        {
+            this->bufferSize = bufferSize;
+            this->kernelBuffers = kernelBuffers;
+            this->tuner.restart();
+        });
+    }
+
+    double readSampleRate(void)
+    {
+        //prefer the device attribute, then the first channel with one
+        for (auto a : this->dev->attributes())
+        {
+            if (a.name() == "sampling_frequency") return std::atof(a.value().c_str());
+        }
+        for (auto &c : this->channels)
+        {
+            for (auto a : c.attributes())
+            {
+                if (a.name() == "sampling_frequency") return std::atof(a.value().c_str());
+            }
+        }
+        return 0.0;
+    }
+
+    double tuningRate(void) const
+    {
+        return (this->deviceRate > 0.0) ? this->deviceRate : this->tuner.measuredRate();
+    }
+
+    //pick the buffer size again after measuring, or when the sample rate changed
+    void retune(void)
+    {
+        if (!this->tuner.enabled() || this->shareBuffer || this->capturing) return;
+
+        bool rateChanged = false;
+        const auto now = IIOStreamStats::Clock::now();
+        if (now >= this->nextRateCheck)
+        {
+            this->nextRateCheck = now + std::chrono::seconds(1);
+            const double rate = this->readSampleRate();
+            rateChanged = std::abs(rate - this->deviceRate) > 1e-3*std::max(rate, this->deviceRate);
+            this->deviceRate = rate;
+        }
+        if (!rateChanged && !this->tuner.settled()) return;
+
+        const double rate = this->tuningRate();
+        size_t size = this->tuner.bufferSize(rate, this->bufferSize);
+        if (this->portBufferSize != 0) size = std::min(size, this->portBufferSize);
+        const size_t kernelBuffers = this->tuner.kernelBuffers(size, rate);
+        if (size != this->bufferSize || kernelBuffers != this->kernelBuffers) this->resizeBuffer(size, kernelBuffers);
+        else if (rateChanged) this->tuner.restart();
+    }
+
+    void setShareBuffer(const bool shareBuffer)
+    {
+        this->shareBuffer = shareBuffer;
+    }
+
+    void setPlacement(const std::vector<int> &cpuAffinity, const int realtimePriority, const int numaNode)
+    {
+        const IIOPlacement placement(cpuAffinity, realtimePriority, numaNode);
+        if (placement == this->placement) return;
+
+        //work moves to a pool of its own instead of changing the threads of
+        //a shared pool; the default placement gives back the original pool,
+        //or a plain pool of its own if the topology had not assigned one yet
+        if (this->placement.isDefault()) this->unplacedPool = this->getThreadPool();
+        if (placement.isDefault() && this->unplacedPool) this->setThreadPool(this->unplacedPool);
+        else this->setThreadPool(Pothos::ThreadPool(placement.threadPoolArgs()));
+        this->placement = placement;
+    }
+
+    std::shared_ptr<Pothos::BufferManager> getOutputBufferManager(const std::string &name, const std::string &domain)
+    {
+        //buffers from the block's pool, unless a downstream block provides
+        //them; those are sized for the current buffer, which caps the tuner
+        if (!domain.empty())
+        {
+            this->portBufferSize = this->bufferSize;
+            return Pothos::Block::getOutputBufferManager(name, domain);
+        }
+        //with automatic sizing, make room for the largest buffer up front
+        this->portBufferSize = this->tuner.enabled() ? std::max(this->bufferSize, IIOBufferTuner::maxBufferSize) : this->bufferSize;
+        std::vector<size_t> bufferBytes;
+        size_t index = 0;
+        for (size_t i = 0; i < this->outputs().size(); i++)
+        {
+            if (this->outputs()[i]->name() == name) index = i;
+            bufferBytes.push_back(this->portBufferSize*this->outputs()[i]->dtype().size());
+        }
+        return this->bufferPool->manager(index, bufferBytes, this->placement);
+    }
+
+    size_t bytesPerScan(void) const
+    {
+        if (this->buf) return this->buf->step();
+        return this->dev ? this->dev->scanSize() : 0;
+    }
+
+    void trigger(void)
+    {
+        if (!this->capturing) this->triggerPending = true;
+    }
+
+    std::string setConfig(const std::string &config)
     {
         if (!this->dev)
         {
-            throw Pothos::SystemException("IIOSource::activate()", "no device specified");
+            throw Pothos::SystemException("IIOSource::setConfig()", "no device specified");
+        }
+        this->profiles.invalidate();
+        this->nextRateCheck = IIOStreamStats::Clock::time_point();
+        const IIOConfig batch(*this->dev, this->channels, config);
+        const auto report = batch.apply();
+        this->recordChange(batch.update());
+        return report;
+    }
+
+    void loadProfile(const std::string &name, const std::string &config)
+    {
+        if (!this->dev)
+        {
+            throw Pothos::SystemException("IIOSource::loadProfile()", "no device specified");
         }
+        const IIOConfig batch(*this->dev, this->channels, config);
+        this->profiles.load(name, batch);
+        this->profileConfigs[name] = config;
+        this->profileUpdates[name] = batch.update();
+    }
+
+    void switchProfile(const std::string &name)
+    {
+        this->profiles.apply(name);
+        this->nextRateCheck = IIOStreamStats::Clock::time_point();
+        this->recordChange(this->profileUpdates[name]);
+    }
+
+    double profileSwitchLatency(void) const
+    {
+        return this->profiles.lastSwitchLatency();
+    }
+
+    std::string profileStats(void) const
+    {
+        return this->profiles.stats();
+    }
 
+    void setProfileReadBack(const bool readBack)
+    {
+        this->profiles.setReadBack(readBack);
+    }
+
+    std::string streamStats(void) const
+    {
+        return this->stats.toJSON();
+    }
+
+    double bytesPerSec(void) const
+    {
+        return this->stats.bytesPerSec();
+    }
+
+    double transferLatency(void) const
+    {
+        return this->stats.transfer.meanUs();
+    }
+
+    void setupBuffer(void)
+    {
         bool haveScanElements = false;
         if (this->buf) {
             this->buf.reset();
         }
+        this->subscription.reset();
+        this->chunk.reset();
+        this->haveSequence = false;
+        this->anchorTime = IIOStreamStats::Clock::time_point();
+
+        //the broker enables the channels of all its subscribers
+        if (this->shareBuffer)
+        {
+            std::vector<std::string> channelIds;
+            for (size_t i = 0; i < this->channels.size(); i++)
+            {
+                if (this->channels[i].isScanElement() && this->channelEnabled[i]) channelIds.push_back(this->channels[i].id());
+            }
+            if (!channelIds.empty() && this->enablePorts)
+            {
+                this->subscription = IIOBufferBroker::subscribe(this->deviceId, channelIds, this->bufferSize, this->placement);
+            }
+            return;
+        }
+
+        //disable the input scan elements that are not streamed, including
+        //those left enabled by other users, to keep the scan small
+        for (auto c : this->dev->channels())
+        {
+            if (c.isOutput() || !c.isScanElement() || !c.isEnabled()) continue;
+            bool streamed = false;
+            for (size_t i = 0; i < this->channels.size(); i++)
+            {
+                streamed = streamed || (this->channelEnabled[i] && this->channels[i].id() == c.id());
+            }
+            if (!streamed) c.disable();
+        }
 
-        for (auto c : this->channels)
+        for (size_t i = 0; i < this->channels.size(); i++)
         {
+            auto &c = this->channels[i];
+            if (c.isScanElement() && !this->channelEnabled[i]) continue;
             c.enable();
 
             if (c.isScanElement())
@@ -228,69 +1150,636 @@ public:
 
         //create sample buffer if we've got any scan elements
         if (haveScanElements && this->enablePorts) {
+            if (this->kernelBuffers != 0) this->dev->setKernelBuffersCount(this->kernelBuffers);
             this->buf = std::unique_ptr<IIOBuffer>(new IIOBuffer(std::move(this->dev->createBuffer(this->bufferSize, false))));
             if (!this->buf)
             {
-                throw Pothos::SystemException("IIOSource::activate()", "buffer creation failed");
+                throw Pothos::SystemException("IIOSource::setupBuffer()", "buffer creation failed");
             }
             this->buf->setBlockingMode(false);
+            this->placement.bindMemory(this->buf->start(), static_cast<char *>(this->buf->end()) - static_cast<char *>(this->buf->start()));
         }
     }
 
+    void activate(void)
+    {
+        if (!this->dev)
+        {
+            throw Pothos::SystemException("IIOSource::activate()", "no device specified");
+        }
+
+        //the event descriptor can only be had before the buffer is created
+        if (this->captureMode == "pretrigger" && this->triggerSource == "event")
+        {
+            if (IIOContext::get().name() != "local")
+            {
+                throw Pothos::NotImplementedException("IIOSource::activate()", "event triggers require the local context");
+            }
+            this->eventFd = iioOpenEventFd(this->deviceId);
+            if (this->eventFd < 0)
+            {
+                throw Pothos::SystemException("IIOSource::activate()", "device is busy, cannot listen for events");
+            }
+        }
+
+        //changes left over from a burst when the block was deactivated
+        this->applyPendingRebuilds();
+
+        //start from the current size, with a matching kernel buffer count
+        if (this->tuner.enabled() && !this->shareBuffer)
+        {
+            this->deviceRate = this->readSampleRate();
+            this->kernelBuffers = this->tuner.kernelBuffers(this->bufferSize, this->deviceRate);
+            this->nextRateCheck = IIOStreamStats::Clock::now() + std::chrono::seconds(1);
+        }
+        this->tuner.restart();
+        this->changeLog.clearPending();
+        this->changeRate = this->readSampleRate();
+
+        //the clock of the timestamp channel, which the IIO core defaults to realtime
+        std::string timestampClock = "realtime";
+        for (auto a : this->dev->attributes())
+        {
+            if (a.name() == "current_timestamp_clock") timestampClock = a.value();
+        }
+        this->changeLog.setTimestampClock(timestampClock);
+
+        this->setupBuffer();
+        this->setupCapture();
+        this->setupDecimation();
+        this->lost = false;
+        this->stats.reset();
+        this->registration.set(this->dev->id(), this->shareBuffer ? "source (shared)" : "source", this->bufferSize, this->stats);
+    }
+
     void deactivate(void)
     {
+        this->registration.clear();
         if (this->buf) {
             this->buf.reset();
         }
+        this->subscription.reset();
+        this->chunk.reset();
+        this->closeEventFd();
+        this->ring.clear();
+    }
+
+    void closeEventFd(void)
+    {
+        #ifdef __linux__
+        if (this->eventFd >= 0) close(this->eventFd);
+        #endif
+        this->eventFd = -1;
+    }
+
+    void setupCapture(void)
+    {
+        this->ring.clear();
+        this->ringStart = this->ringWritten = 0;
+        this->capturing = false;
+        this->triggerPending = false;
+        if (this->captureMode != "pretrigger" || !this->streaming()) return;
+
+        //the history plus a few refills, so that the device
+        //can keep streaming while a burst is being produced
+        this->ringCapacity = this->preTrigger + 4*this->bufferSize;
+        this->ring.resize(this->channels.size());
+        for (size_t i = 0; i < this->channels.size(); i++)
+        {
+            if (!this->hasPort(i)) continue;
+            this->ring[i].resize(this->ringCapacity*iioFormatBytes(this->portFormat(i)));
+        }
+        this->setupLevelTrigger();
+    }
+
+    void setupLevelTrigger(void)
+    {
+        this->levelChannel = this->findLevelChannel(this->triggerChannel);
+        this->levelLast = std::numeric_limits<double>::quiet_NaN();
+    }
+
+    //the index of the level trigger's channel, or channels.size() without a level trigger
+    size_t findLevelChannel(const std::string &channelId)
+    {
+        if (this->triggerSource != "level") return this->channels.size();
+        const size_t i = this->portIndex(channelId);
+        if (i == this->channels.size() || !this->hasPort(i) || !this->channelEnabled[i])
+        {
+            throw Pothos::InvalidArgumentException("IIOSource::findLevelChannel()", "trigger channel is not a streamed channel: " + channelId);
+        }
+        const auto length = this->portFormat(i).length;
+        if (length != 8 && length != 16 && length != 32 && length != 64)
+        {
+            throw Pothos::InvalidArgumentException("IIOSource::findLevelChannel()", "unsupported trigger channel sample size: " + std::to_string(length));
+        }
+        return i;
+    }
+
+    void startBurst(const unsigned long long triggerAt)
+    {
+        this->capturing = true;
+        this->triggerPending = false;
+        this->burstTrigger = triggerAt;
+        this->burstStart = std::max(this->ringStart, triggerAt - std::min<unsigned long long>(triggerAt, this->preTrigger));
+        this->burstEnd = triggerAt + this->postTrigger;
+        this->burstEmitted = this->burstStart;
+    }
+
+    //copy a refill into the ring, checking the level trigger as we go
+    void captureSamples(const size_t count)
+    {
+        const size_t offset = this->ringWritten % this->ringCapacity;
+        const size_t head = std::min(count, this->ringCapacity - offset);
+        const ptrdiff_t step = this->scanStep();
+        size_t triggerAt = count;
+        for (size_t i = 0; i < this->channels.size(); i++)
+        {
+            if (!this->hasPort(i) || !this->channelEnabled[i]) continue;
+            const auto fmt = this->portFormat(i);
+            const size_t bytes = iioFormatBytes(fmt);
+            auto src = static_cast<const char *>(this->scanFirst(i));
+            auto dst = this->ring[i].data();
+            this->deinterleave(i, src, step, dst + offset*bytes, head);
+            this->deinterleave(i, src + head*step, step, dst, count - head);
+
+            if (i != this->levelChannel || this->capturing) continue;
+            triggerAt = iioFindCrossing(fmt, dst + offset*bytes, head, this->triggerLevel, this->triggerRising, this->levelLast);
+            if (triggerAt == head) triggerAt += iioFindCrossing(fmt, dst, count - head, this->triggerLevel, this->triggerRising, this->levelLast);
+        }
+        this->ringWritten += count;
+        if (this->ringWritten - this->ringStart > this->ringCapacity) this->ringStart = this->ringWritten - this->ringCapacity;
+        if (triggerAt < count) this->startBurst(this->ringWritten - count + triggerAt);
+    }
+
+    //produce as much of the current burst as the outputs can take
+    void emitBurst(void)
+    {
+        if (!this->capturing) return;
+        const auto available = std::min(this->ringWritten, this->burstEnd) - this->burstEmitted;
+        const size_t count = size_t(std::min<unsigned long long>(available, this->workInfo().minOutElements));
+        if (count != 0)
+        {
+            const size_t offset = this->burstEmitted % this->ringCapacity;
+            const size_t head = std::min(count, this->ringCapacity - offset);
+            for (size_t i = 0; i < this->channels.size(); i++)
+            {
+                if (!this->hasPort(i) || !this->channelEnabled[i]) continue;
+                const size_t bytes = iioFormatBytes(this->portFormat(i));
+                auto outputPort = this->output(this->portName(i));
+                auto dst = outputPort->buffer().as<char *>();
+                std::memcpy(dst, this->ring[i].data() + offset*bytes, head*bytes);
+                std::memcpy(dst + head*bytes, this->ring[i].data(), (count - head)*bytes);
+                if (this->burstEmitted == this->burstStart)
+                {
+                    const auto triggerOffset = static_cast<long long>(this->burstTrigger - this->burstStart);
+                    outputPort->postLabel(Pothos::Label("burst", Pothos::Object(triggerOffset), 0));
+                }
+                outputPort->produce(count);
+            }
+            this->burstEmitted += count;
+        }
+
+        //re-arm, requiring a fresh crossing for the level trigger
+        if (this->burstEmitted == this->burstEnd)
+        {
+            this->capturing = false;
+            this->levelLast = std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+
+    void drainEvents(void)
+    {
+        #ifdef __linux__
+        struct iio_event_data events[16];
+        bool any = false;
+        while (read(this->eventFd, events, sizeof(events)) > 0) any = true;
+        if (any && !this->capturing) this->triggerPending = true;
+        #endif
+    }
+
+    void deviceLost(void)
+    {
+        this->buf.reset();
+        this->subscription.reset();
+        this->chunk.reset();
+        this->closeEventFd();
+        if (this->capturing) this->burstEnd = std::max(this->burstEmitted, std::min(this->burstEnd, this->ringWritten));
+        this->lost = true;
+        this->lostTime = IIOStreamStats::Clock::now();
+        this->nextRecovery = this->lostTime;
+        this->lostGeneration = IIOContext::get().generation();
+    }
+
+    //give the thread back to the scheduler, counted in the stream stats
+    void countedYield(void)
+    {
+        this->stats.yields.add(1);
+        this->yield();
+    }
+
+    //the device disappeared without failing a transfer
+    void deviceGone(void)
+    {
+        if (!this->autoRecover)
+        {
+            throw Pothos::SystemException("IIOSource::work()", this->deviceId + " is no longer present", ENODEV);
+        }
+        this->deviceLost();
+        this->countedYield();
+    }
+
+    bool recover(void)
+    {
+        //retry at most every 100 ms, sleeping no longer than the work timeout
+        const auto now = IIOStreamStats::Clock::now();
+        if (now < this->nextRecovery)
+        {
+            const auto maxSleep = std::chrono::nanoseconds(this->workInfo().maxTimeoutNs);
+            std::this_thread::sleep_for(std::min<IIOStreamStats::Clock::duration>(this->nextRecovery - now, maxSleep));
+            return false;
+        }
+        this->nextRecovery = now + std::chrono::milliseconds(100);
+
+        //find the device and the same channels in a context created after
+        //the loss; the context is re-created in the background, so that a
+        //slow remote context does not block this thread
+        IIOContext& ctx = IIOContext::get();
+        ctx.rescanAsync();
+        if (ctx.generation() == this->lostGeneration) return false;
+        std::unique_ptr<IIODevice> dev;
+        for (auto d : ctx.devices())
+        {
+            if (d.id() == this->deviceId) dev.reset(new IIODevice(d));
+        }
+        if (!dev) return false;
+        std::vector<IIOChannel> channels;
+        for (auto &old : this->channels)
+        {
+            for (auto c : dev->channels())
+            {
+                if (c.id() == old.id() && c.isOutput() == old.isOutput()) channels.push_back(c);
+            }
+        }
+        if (channels.size() != this->channels.size()) return false;
+
+        //recreate the stream and the stored profiles
+        this->dev = std::move(dev);
+        this->channels = channels;
+        this->attrWriter.reset();
+        try
+        {
+            if (this->captureMode == "pretrigger" && this->triggerSource == "event")
+            {
+                this->eventFd = iioOpenEventFd(this->deviceId);
+                if (this->eventFd < 0) return false;
+            }
+            this->setupBuffer();
+            for (const auto &profile : this->profileConfigs)
+            {
+                this->profiles.load(profile.first, IIOConfig(*this->dev, this->channels, profile.second));
+            }
+        }
+        catch (const Pothos::Exception &)
+        {
+            this->buf.reset();
+            this->closeEventFd();
+            return false;
+        }
+        this->profiles.invalidate();
+        this->registration.set(this->dev->id(), this->shareBuffer ? "source (shared)" : "source", this->bufferSize, this->stats);
+
+        const auto downtimeNs = IIOStreamStats::elapsedNs(this->lostTime, IIOStreamStats::Clock::now());
+        this->stats.recoveries.add(1);
+        this->stats.downtimeNs.add(downtimeNs);
+
+        if (this->streaming()) this->markGap(downtimeNs);
+        this->lost = false;
+        return true;
+    }
+
+    //mark samples lost for gapNs before the next ones
+    void markGap(const unsigned long long gapNs)
+    {
+        //captured bursts never span the gap, so there is nothing to label
+        if (!this->ring.empty())
+        {
+            this->ringStart = this->ringWritten;
+            this->levelLast = std::numeric_limits<double>::quiet_NaN();
+            return;
+        }
+        for (size_t i = 0; i < this->channels.size(); i++)
+        {
+            if (this->hasPort(i) && this->channelEnabled[i])
+            {
+                this->output(this->portName(i))->postLabel(Pothos::Label("discontinuity", Pothos::Object(gapNs), 0));
+            }
+        }
+    }
+
+    //apply the attribute updates that arrived since the last refill,
+    //so that the next samples read are the first taken with them
+    void applyAttributeMessages(void)
+    {
+        auto port = this->input("attr");
+        while (port->hasMessage())
+        {
+            const auto msg = port->popMessage();
+            if (msg.type() != typeid(Pothos::ObjectKwargs))
+            {
+                throw Pothos::InvalidArgumentException("IIOSource::applyAttributeMessages()", "expected a dictionary of attribute names to values");
+            }
+            if (!this->attrWriter) this->attrWriter.reset(new IIOAttributeWriter(*this->dev, this->channels));
+            this->profiles.invalidate();
+            this->nextRateCheck = IIOStreamStats::Clock::time_point();
+            this->attrWriter->apply(msg.extract<Pothos::ObjectKwargs>());
+            this->recordChange(msg.extract<Pothos::ObjectKwargs>());
+        }
+    }
+
+    //log a write, to be labeled on the stream unless capturing;
+    //samples already read were taken at the rate before the write,
+    //which is only read again when the write may have changed it.
+    //The device's info cache entry holds attribute values, so refresh it
+    void recordChange(const Pothos::ObjectKwargs &update)
+    {
+        IIODeviceCache::invalidate(this->dev->id());
+        this->changeLog.record(update, this->changeRate, this->ring.empty() && this->streaming());
+        for (const auto &entry : update)
+        {
+            const auto &key = entry.first;
+            if (key.substr(key.find_last_of('/')+1) != "sampling_frequency") continue;
+            this->changeRate = this->readSampleRate();
+            break;
+        }
+    }
+
+    std::string attributeLog(void) const
+    {
+        return this->changeLog.toJSON();
+    }
+
+    //find the attribute changes that a refill is the first to reflect
+    std::vector<std::pair<size_t, Pothos::Object>> placeChanges(const size_t count, const ptrdiff_t step, const unsigned long long pollNs)
+    {
+        const auto now = IIOStreamStats::Clock::now();
+        const unsigned long long first = this->stats.samples.get();
+        const auto samplesTime = [this](const double samples)
+        {
+            return std::chrono::duration_cast<IIOStreamStats::Clock::duration>(std::chrono::duration<double>(samples/this->changeRate));
+        };
+
+        //estimate when the last sample was taken: a shared refill completed
+        //at its chunk time, and one of our own completed just now if we had
+        //to wait for it (for a tenth of its fill time), otherwise it was
+        //queued since the last one we waited for
+        IIOStreamStats::Clock::time_point lastTime;
+        if (this->changeRate > 0.0 && this->chunk)
+        {
+            lastTime = this->chunk->time - samplesTime(double(this->chunk->samples - this->chunkOffset - count));
+        }
+        else if (this->changeRate > 0.0)
+        {
+            if (this->anchorTime == IIOStreamStats::Clock::time_point() || pollNs*this->changeRate*10 >= count*1e9)
+            {
+                this->anchorTime = now;
+                this->anchorSample = first + count;
+            }
+            lastTime = std::min(now, this->anchorTime + samplesTime(double(first + count) - this->anchorSample));
+        }
+
+        //a streamed timestamp channel gives the time of every sample
+        const long long *timestamps = nullptr;
+        for (size_t i = 0; i < this->channels.size() && this->changeLog.hasPending(); i++)
+        {
+            auto &c = this->channels[i];
+            if (c.id() != "timestamp" || !c.isScanElement() || !this->channelEnabled[i] || c.format().length != 64) continue;
+            this->timestamps.resize(count);
+            iioDeinterleave(c.format(), this->scanFirst(i), step, this->timestamps.data(), count);
+            timestamps = this->timestamps.data();
+        }
+        return this->changeLog.place(count, first, timestamps, lastTime);
+    }
+
+    bool streaming(void) const
+    {
+        return this->buf || this->subscription;
+    }
+
+    //the first sample of a channel in the scans being converted,
+    //which come from the shared chunk or from our own buffer
+    const void *scanFirst(const size_t i)
+    {
+        if (this->chunk)
+        {
+            return static_cast<const char *>(this->chunk->first(this->channels[i].id())) + this->chunkOffset*this->chunk->layout->step;
+        }
+        return this->buf->first(this->channels[i]);
+    }
+
+    ptrdiff_t scanStep(void) const
+    {
+        return this->chunk ? this->chunk->layout->step : this->buf->step();
+    }
+
+    //get the next chunk of the shared buffer, returning false if there is none yet
+    bool nextChunk(const bool capture)
+    {
+        if (this->chunk) return true;
+        auto tPoll = IIOStreamStats::Clock::now();
+        try
+        {
+            this->chunk = this->subscription->pop(std::chrono::nanoseconds(this->workInfo().maxTimeoutNs));
+        }
+        catch (const Pothos::Exception &ex)
+        {
+            if (!this->autoRecover || !iioIsDeviceGone(ex.code())) throw;
+            this->deviceLost();
+            this->countedYield();
+            return false;
+        }
+        this->stats.pollWait.record(IIOStreamStats::elapsedNs(tPoll, IIOStreamStats::Clock::now()));
+        if (!this->chunk)
+        {
+            this->stats.pollTimeouts.add(1);
+            if (capture) this->emitBurst();
+            this->countedYield();
+            return false;
+        }
+        this->chunkOffset = 0;
+        this->stats.transfer.record(this->chunk->refillNs);
+
+        //refills lost to a rebuild or to falling behind leave a sequence gap
+        if (this->haveSequence && this->chunk->sequence != this->nextSequence)
+        {
+            this->markGap(IIOStreamStats::elapsedNs(this->lastChunkTime, this->chunk->previousTime));
+        }
+        this->haveSequence = true;
+        this->nextSequence = this->chunk->sequence + 1;
+        this->lastChunkTime = this->chunk->time;
+        return true;
     }
 
     void work(void)
     {
-        if (this->buf) {
-            //verify we have enough space in our output buffers to refill
-            if (this->workInfo().minOutElements < this->bufferSize)
-                return;
+        if (this->lost && !this->recover()) return this->countedYield();
+        if (!this->chunk) this->applyAttributeMessages();
+        if (!this->capturing && this->applyPendingRebuilds()) this->rebuildBuffer();
+        if (!this->streaming()) return;
+
+        const bool capture = !this->ring.empty();
+        if (capture)
+        {
+            if (this->triggerPending && !this->capturing) this->startBurst(this->ringWritten);
+
+            //refill only when it cannot overwrite samples of the burst
+            if (this->capturing && this->ringWritten + this->bufferSize - this->burstEmitted > this->ringCapacity)
+                return this->emitBurst();
+        }
+        //verify we have enough space in our output buffers to refill;
+        //shared chunks are converted in as many parts as needed
+        else if (this->workInfo().minOutElements < (this->subscription ? 1 : this->bufferSize))
+            return;
 
-            //wait for samples
+        size_t sample_count = 0;
+        unsigned long long transferNs = 0;
+        unsigned long long pollNs = 0;
+        if (this->subscription)
+        {
+            if (!this->nextChunk(capture)) return;
+            sample_count = std::min(this->chunk->samples - this->chunkOffset, capture ? this->bufferSize : this->workInfo().minOutElements);
+        }
+        else
+        {
+            //wait for samples, and for events when triggering on them
+            auto tPoll = IIOStreamStats::Clock::now();
             #ifndef _MSC_VER
-            struct pollfd pfd = {
-                .fd = this->buf->fd(),
-                .events = POLLIN,
-                .revents = 0
+            struct pollfd pfd[2] = {
+                {this->buf->fd(), POLLIN, 0},
+                {this->eventFd, POLLIN, 0}
             };
             struct timespec ts = {
-                .tv_sec = static_cast<time_t>(this->workInfo().maxTimeoutNs/10000000),
-                .tv_nsec = static_cast<long int>(this->workInfo().maxTimeoutNs % 10000000)
+                .tv_sec = static_cast<time_t>(this->workInfo().maxTimeoutNs/1000000000),
+                .tv_nsec = static_cast<long int>(this->workInfo().maxTimeoutNs % 1000000000)
             };
-            int ret = ppoll(&pfd, 1, &ts, NULL);
+            int ret = ppoll(pfd, (this->eventFd >= 0) ? 2 : 1, &ts, NULL);
             #else
             struct timeval ts;// = {0, static_cast<long int>(this->workInfo().maxTimeoutNs / 1024)};
             fd_set fds; FD_ZERO(&fds); FD_SET(this->buf->fd(), &fds);
             int ret = select(1, &fds, NULL, NULL, &ts);
             #endif
+            //the call returns -1 and leaves the error in errno
             if (ret < 0)
-                throw Pothos::SystemException("IIOSource::work()", "ppoll failed: " + Poco::Error::getMessage(-ret));
-            else if (ret == 0)
-                return this->yield();
+            {
+                const int error = Poco::Error::last();
+                if (error == EINTR) return this->countedYield();
+                throw Pothos::SystemException("IIOSource::work()", "ppoll failed: " + Poco::Error::getMessage(error), error);
+            }
+            pollNs = IIOStreamStats::elapsedNs(tPoll, IIOStreamStats::Clock::now());
+            this->stats.pollWait.record(pollNs);
+            if (ret == 0)
+            {
+                this->stats.pollTimeouts.add(1);
+                if (!this->dev->isPresent()) return this->deviceGone();
+                if (capture) this->emitBurst();
+                return this->countedYield();
+            }
+            #ifndef _MSC_VER
+            //errors on the buffer fall through to refill(), which reports them
+            if (pfd[1].revents & POLLIN) this->drainEvents();
+            if (!(pfd[0].revents & (POLLIN | POLLERR | POLLHUP | POLLNVAL)))
+            {
+                if (capture && this->triggerPending && !this->capturing) this->startBurst(this->ringWritten);
+                if (capture) this->emitBurst();
+                return;
+            }
+            #endif
 
             //get new samples from iio device
-            auto bytes_read = this->buf->refill();
+            auto tTransfer = IIOStreamStats::Clock::now();
+            size_t bytes_read = 0;
+            try
+            {
+                bytes_read = this->buf->refill();
+            }
+            catch (const Pothos::Exception &ex)
+            {
+                if (ex.code() == EAGAIN) return this->countedYield();
+                if (!this->autoRecover || !iioIsDeviceGone(ex.code())) throw;
+                this->deviceLost();
+                return this->countedYield();
+            }
+            transferNs = IIOStreamStats::elapsedNs(tTransfer, IIOStreamStats::Clock::now());
+            this->stats.transfer.record(transferNs);
             //libiio read operations shouldn't return partial scans
             assert(bytes_read % this->buf->step() == 0);
-            auto sample_count = bytes_read / this->buf->step();
+            sample_count = bytes_read / this->buf->step();
+        }
+        auto tConvert = IIOStreamStats::Clock::now();
+        const ptrdiff_t step = this->scanStep();
+        if (this->correctionsChanged && this->chunkOffset == 0)
+        {
+            this->corrections.swap(this->nextCorrections);
+            this->correctionsChanged = false;
+        }
+
+        //keep the samples for a burst instead of producing them
+        if (capture)
+        {
+            this->captureSamples(sample_count);
+            this->emitBurst();
+        }
+        else
+        {
+            //label the first sample taken after each attribute change
+            const auto changes = this->placeChanges(sample_count, step, pollNs);
 
-            //generate samples
-            for (auto c : this->channels)
+            //generate samples, decimating on the way where configured
+            for (size_t i = 0; i < this->channels.size(); i++)
             {
-                if (c.isScanElement()) {
-                    auto outputPort = this->output(c.id());
+                if (this->hasPort(i) && this->channelEnabled[i]) {
+                    const auto fmt = this->portFormat(i);
+                    auto outputPort = this->output(this->portName(i));
                     auto outputBuffer = outputPort->buffer();
+                    auto &decimator = this->decimators[i];
+                    for (const auto &change : changes)
+                    {
+                        outputPort->postLabel(Pothos::Label("attrChange", change.second, (decimator.phase + change.first)/decimator.factor));
+                    }
 
-                    c.read(*this->buf, outputBuffer.as<void*>(), sample_count);
-                    outputPort->produce(sample_count);
+                    if (decimator.factor == 1)
+                    {
+                        this->deinterleave(i, this->scanFirst(i), step, outputBuffer.as<void*>(), sample_count);
+                        outputPort->produce(sample_count);
+                    }
+                    else
+                    {
+                        //correcting the decimated samples is the same and costs less
+                        const size_t produced = iioDeinterleaveDecimate(fmt, this->scanFirst(i),
+                            step, decimator, outputBuffer.as<void*>(), sample_count);
+                        const auto &correction = this->corrections[i];
+                        if (!iioCorrectionIsIdentity(correction)) iioCorrect(fmt, correction, outputBuffer.as<void*>(), produced);
+                        outputPort->produce(produced);
+                    }
                 }
             }
         }
+        const auto convertNs = IIOStreamStats::elapsedNs(tConvert, IIOStreamStats::Clock::now());
+        this->stats.convert.record(convertNs);
+        this->stats.transfers.add(1);
+        this->stats.bytes.add(sample_count*step);
+        this->stats.samples.add(sample_count);
+
+        //release a shared chunk as soon as it has been converted
+        if (this->chunk)
+        {
+            this->chunkOffset += sample_count;
+            if (this->chunkOffset == this->chunk->samples) this->chunk.reset();
+        }
+        else if (this->tuner.enabled())
+        {
+            this->tuner.record(sample_count, transferNs, convertNs);
+            this->retune();
+        }
     }
 };
 
@@ -0,0 +1,138 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include "IIOStats.hpp"
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include <json.hpp>
+using json = nlohmann::json;
+
+void IIOLatencyHistogram::reset(void)
+{
+    for (auto &bin : bins) bin.reset();
+    count.reset();
+    sumNs.reset();
+    maxNs.reset();
+}
+
+double IIOLatencyHistogram::meanUs(void) const
+{
+    const auto n = count.get();
+    return n ? (sumNs.get()/1e3)/n : 0.0;
+}
+
+std::string IIOLatencyHistogram::toJSON(void) const
+{
+    json obj;
+    obj["count"] = count.get();
+    obj["meanUs"] = this->meanUs();
+    obj["maxUs"] = maxNs.get()/1e3;
+
+    //bins are keyed by their lower bound in nanoseconds
+    auto &binsObj = obj["bins"];
+    binsObj = json::object();
+    for (size_t i = 0; i < NUM_BINS; i++)
+    {
+        const auto n = bins[i].get();
+        if (n == 0) continue;
+        binsObj[std::to_string(i ? (1ull << i) : 0)] = n;
+    }
+    return obj.dump();
+}
+
+void IIOStreamStats::reset(void)
+{
+    transfer.reset();
+    pollWait.reset();
+    convert.reset();
+    transfers.reset();
+    pollTimeouts.reset();
+    yields.reset();
+    bytes.reset();
+    samples.reset();
+    recoveries.reset();
+    downtimeNs.reset();
+    startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+double IIOStreamStats::bytesPerSec(void) const
+{
+    const long long start = startNs;
+    if (start == 0) return 0.0;
+    const long long now = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    return (now > start) ? bytes.get()/((now - start)/1e9) : 0.0;
+}
+
+std::string IIOStreamStats::toJSON(void) const
+{
+    json obj;
+    obj["transfers"] = transfers.get();
+    obj["pollTimeouts"] = pollTimeouts.get();
+    obj["yields"] = yields.get();
+    obj["bytes"] = bytes.get();
+    obj["samples"] = samples.get();
+    obj["recoveries"] = recoveries.get();
+    obj["downtimeUs"] = downtimeNs.get()/1e3;
+    obj["bytesPerSec"] = this->bytesPerSec();
+    obj["transferLatency"] = json::parse(transfer.toJSON());
+    obj["pollWait"] = json::parse(pollWait.toJSON());
+    obj["convertTime"] = json::parse(convert.toJSON());
+    return obj.dump();
+}
+
+/***********************************************************************
+ * Registry of active streams
+ **********************************************************************/
+static std::mutex &registryMutex(void)
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::vector<const IIOStreamRegistration *> &registryEntries(void)
+{
+    static std::vector<const IIOStreamRegistration *> entries;
+    return entries;
+}
+
+IIOStreamRegistration::~IIOStreamRegistration(void)
+{
+    this->clear();
+}
+
+void IIOStreamRegistration::set(const std::string &deviceId, const std::string &kind, const size_t bufferSize, const IIOStreamStats &stats)
+{
+    std::lock_guard<std::mutex> lock(registryMutex());
+    auto &entries = registryEntries();
+    this->deviceId = deviceId;
+    this->kind = kind;
+    this->bufferSize = bufferSize;
+    this->stats = &stats;
+    if (std::find(entries.begin(), entries.end(), this) == entries.end()) entries.push_back(this);
+}
+
+void IIOStreamRegistration::clear(void)
+{
+    std::lock_guard<std::mutex> lock(registryMutex());
+    auto &entries = registryEntries();
+    entries.erase(std::remove(entries.begin(), entries.end(), this), entries.end());
+    this->stats = nullptr;
+}
+
+std::string IIOStreamRegistration::toJSON(const std::string &deviceId)
+{
+    std::lock_guard<std::mutex> lock(registryMutex());
+    json streams = json::array();
+    for (const auto *entry : registryEntries())
+    {
+        if (entry->deviceId != deviceId) continue;
+        json stream;
+        stream["Kind"] = entry->kind;
+        stream["Buffer Size"] = entry->bufferSize;
+        stream["Statistics"] = json::parse(entry->stats->toJSON());
+        streams.push_back(stream);
+    }
+    return streams.dump();
+}
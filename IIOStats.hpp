@@ -0,0 +1,160 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+/*!
+ * IIOStatsCounter is a counter with a single writer and any number of
+ * readers. Updates are a relaxed load and store, so recording never takes a
+ * lock or a locked read-modify-write instruction.
+ */
+class IIOStatsCounter
+{
+private:
+    std::atomic<unsigned long long> value;
+
+public:
+    IIOStatsCounter(void) : value(0) {}
+
+    void add(unsigned long long v)
+    {
+        value.store(value.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+    }
+
+    void max(unsigned long long v)
+    {
+        if (v > value.load(std::memory_order_relaxed)) value.store(v, std::memory_order_relaxed);
+    }
+
+    void reset(void)
+    {
+        value.store(0, std::memory_order_relaxed);
+    }
+
+    unsigned long long get(void) const
+    {
+        return value.load(std::memory_order_relaxed);
+    }
+};
+
+/*!
+ * IIOLatencyHistogram counts durations in power-of-two nanosecond bins,
+ * from [0, 2ns) up to [2^(NUM_BINS-2)ns, inf).
+ */
+class IIOLatencyHistogram
+{
+public:
+    static const size_t NUM_BINS = 32;
+
+    void record(unsigned long long ns)
+    {
+        size_t bin = 0;
+        while (bin < NUM_BINS-1 && (ns >> bin) > 1) bin++;
+        bins[bin].add(1);
+        count.add(1);
+        sumNs.add(ns);
+        maxNs.max(ns);
+    }
+
+    void reset(void);
+
+    /*!
+     * Get the mean recorded duration in microseconds.
+     */
+    double meanUs(void) const;
+
+    /*!
+     * Get a JSON object with the count, mean, max and non-empty bins.
+     */
+    std::string toJSON(void) const;
+
+private:
+    IIOStatsCounter bins[NUM_BINS];
+    IIOStatsCounter count;
+    IIOStatsCounter sumNs;
+    IIOStatsCounter maxNs;
+};
+
+/*!
+ * IIOStreamStats collects the data path statistics of a source or sink.
+ *
+ * All recording is done by the block's work() thread; the probes read the
+ * counters concurrently without locking.
+ */
+struct IIOStreamStats
+{
+    typedef std::chrono::steady_clock Clock;
+
+    //! Duration of each refill() or push() call.
+    IIOLatencyHistogram transfer;
+    //! Time spent waiting in poll for the buffer to become ready.
+    IIOLatencyHistogram pollWait;
+    //! Time spent converting between the IIO buffer and the port buffers.
+    IIOLatencyHistogram convert;
+
+    IIOStatsCounter transfers;
+    IIOStatsCounter pollTimeouts;
+    IIOStatsCounter yields;
+    IIOStatsCounter bytes;
+    IIOStatsCounter samples;
+    //! Streams recovered after the device was lost, and the total downtime.
+    IIOStatsCounter recoveries;
+    IIOStatsCounter downtimeNs;
+
+    std::atomic<long long> startNs;
+
+    IIOStreamStats(void) : startNs(0) {}
+
+    static unsigned long long elapsedNs(const Clock::time_point &t0, const Clock::time_point &t1)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    }
+
+    /*!
+     * Clear all statistics and restart the rate measurement.
+     */
+    void reset(void);
+
+    /*!
+     * Get the average number of bytes transferred per second since reset().
+     */
+    double bytesPerSec(void) const;
+
+    /*!
+     * Get all statistics as a JSON object.
+     */
+    std::string toJSON(void) const;
+};
+
+/*!
+ * IIOStreamRegistration publishes the statistics of an active source or sink
+ * so that /devices/iio/info can report them. The statistics must outlive the
+ * registration; clear() (or destruction) withdraws it.
+ */
+class IIOStreamRegistration
+{
+public:
+    IIOStreamRegistration(void) : stats(nullptr), bufferSize(0) {}
+    ~IIOStreamRegistration(void);
+
+    void set(const std::string &deviceId, const std::string &kind, const size_t bufferSize, const IIOStreamStats &stats);
+    void clear(void);
+
+    /*!
+     * Get a JSON array describing every registered stream of a device.
+     */
+    static std::string toJSON(const std::string &deviceId);
+
+private:
+    IIOStreamRegistration(const IIOStreamRegistration &);
+    IIOStreamRegistration &operator=(const IIOStreamRegistration &);
+
+    std::string deviceId;
+    std::string kind;
+    const IIOStreamStats *stats;
+    size_t bufferSize;
+};
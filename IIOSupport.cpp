@@ -2,10 +2,23 @@
 // SPDX-License-Identifier: BSL-1.0
 
 #include "IIOSupport.hpp"
+#include "IIOConvert.hpp"
+#include "IIOLoopback.hpp"
 #include <Pothos/Framework.hpp>
 #include <Poco/Error.h>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
+#include <cerrno>
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <linux/iio/events.h>
+#endif
 
 IIOContextRaw::IIOContextRaw(void)
 {
@@ -16,12 +29,181 @@ IIOContextRaw::IIOContextRaw(void)
     }
 }
 
+IIOContextRaw::IIOContextRaw(const std::string &uri)
+{
+    this->raw_ptr = iio_create_context_from_uri(uri.c_str());
+    if (!this->raw_ptr)
+    {
+        throw Pothos::SystemException("IIOContextRaw::IIOContextRaw(" + uri + ")", "iio_create_context_from_uri: " + Poco::Error::getMessage(Poco::Error::last()));
+    }
+}
+
 IIOContextRaw::~IIOContextRaw(void)
 {
     iio_context_destroy(this->raw_ptr);
 }
 
-IIOContext::IIOContext(void) : ctx(new IIOContextRaw()) {}
+/***********************************************************************
+ * libiio backend
+ **********************************************************************/
+#define DEV(dev) static_cast<const struct iio_device *>(dev)
+#define CHN(chn) static_cast<const struct iio_channel *>(chn)
+#define CHN_MUT(chn) const_cast<struct iio_channel *>(CHN(chn))
+#define BUF(buf) static_cast<struct iio_buffer *>(buf)
+
+int IIOContextRaw::version(unsigned int *major, unsigned int *minor, char git_tag[8]) { return iio_context_get_version(this->raw_ptr, major, minor, git_tag); }
+const char *IIOContextRaw::name(void) { return iio_context_get_name(this->raw_ptr); }
+const char *IIOContextRaw::description(void) { return iio_context_get_description(this->raw_ptr); }
+unsigned int IIOContextRaw::devicesCount(void) { return iio_context_get_devices_count(this->raw_ptr); }
+IIOBackend::Device IIOContextRaw::device(unsigned int idx) { return iio_context_get_device(this->raw_ptr, idx); }
+
+const char *IIOContextRaw::deviceId(Device dev) { return iio_device_get_id(DEV(dev)); }
+const char *IIOContextRaw::deviceName(Device dev) { return iio_device_get_name(DEV(dev)); }
+unsigned int IIOContextRaw::deviceAttrsCount(Device dev) { return iio_device_get_attrs_count(DEV(dev)); }
+const char *IIOContextRaw::deviceAttr(Device dev, unsigned int idx) { return iio_device_get_attr(DEV(dev), idx); }
+ssize_t IIOContextRaw::deviceAttrRead(Device dev, const char *attr, char *dst, size_t len) { return iio_device_attr_read(DEV(dev), attr, dst, len); }
+ssize_t IIOContextRaw::deviceAttrWrite(Device dev, const char *attr, const char *src) { return iio_device_attr_write(DEV(dev), attr, src); }
+unsigned int IIOContextRaw::channelsCount(Device dev) { return iio_device_get_channels_count(DEV(dev)); }
+IIOBackend::Channel IIOContextRaw::channel(Device dev, unsigned int idx) { return iio_device_get_channel(DEV(dev), idx); }
+int IIOContextRaw::deviceTrigger(Device dev, Device *trigger)
+{
+    const struct iio_device *t = nullptr;
+    int ret = iio_device_get_trigger(DEV(dev), &t);
+    *trigger = t;
+    return ret;
+}
+int IIOContextRaw::setDeviceTrigger(Device dev, Device trigger) { return iio_device_set_trigger(DEV(dev), DEV(trigger)); }
+bool IIOContextRaw::deviceIsTrigger(Device dev) { return iio_device_is_trigger(DEV(dev)); }
+int IIOContextRaw::setKernelBuffersCount(Device dev, unsigned int nb_buffers) { return iio_device_set_kernel_buffers_count(DEV(dev), nb_buffers); }
+IIOBackend::Buffer IIOContextRaw::createBuffer(Device dev, size_t samples_count, bool cyclic) { return iio_device_create_buffer(DEV(dev), samples_count, cyclic); }
+
+IIOBackend::Device IIOContextRaw::channelDevice(Channel chn) { return iio_channel_get_device(CHN(chn)); }
+const char *IIOContextRaw::channelId(Channel chn) { return iio_channel_get_id(CHN(chn)); }
+const char *IIOContextRaw::channelName(Channel chn) { return iio_channel_get_name(CHN(chn)); }
+unsigned int IIOContextRaw::channelAttrsCount(Channel chn) { return iio_channel_get_attrs_count(CHN(chn)); }
+const char *IIOContextRaw::channelAttr(Channel chn, unsigned int idx) { return iio_channel_get_attr(CHN(chn), idx); }
+ssize_t IIOContextRaw::channelAttrRead(Channel chn, const char *attr, char *dst, size_t len) { return iio_channel_attr_read(CHN(chn), attr, dst, len); }
+ssize_t IIOContextRaw::channelAttrWrite(Channel chn, const char *attr, const char *src) { return iio_channel_attr_write(CHN(chn), attr, src); }
+void IIOContextRaw::channelEnable(Channel chn) { iio_channel_enable(CHN_MUT(chn)); }
+void IIOContextRaw::channelDisable(Channel chn) { iio_channel_disable(CHN_MUT(chn)); }
+bool IIOContextRaw::channelIsEnabled(Channel chn) { return iio_channel_is_enabled(CHN(chn)); }
+bool IIOContextRaw::channelIsOutput(Channel chn) { return iio_channel_is_output(CHN(chn)); }
+bool IIOContextRaw::channelIsScanElement(Channel chn) { return iio_channel_is_scan_element(CHN(chn)); }
+long IIOContextRaw::channelIndex(Channel chn) { return iio_channel_get_index(CHN(chn)); }
+const struct iio_data_format *IIOContextRaw::channelFormat(Channel chn) { return iio_channel_get_data_format(CHN(chn)); }
+ssize_t IIOContextRaw::channelRead(Channel chn, Buffer buf, void *dst, size_t len) { return iio_channel_read(CHN(chn), BUF(buf), dst, len); }
+ssize_t IIOContextRaw::channelWrite(Channel chn, Buffer buf, const void *src, size_t len) { return iio_channel_write(CHN(chn), BUF(buf), src, len); }
+
+void IIOContextRaw::bufferDestroy(Buffer buf) { iio_buffer_destroy(BUF(buf)); }
+IIOBackend::Device IIOContextRaw::bufferDevice(Buffer buf) { return iio_buffer_get_device(BUF(buf)); }
+int IIOContextRaw::bufferSetBlockingMode(Buffer buf, bool blocking) { return iio_buffer_set_blocking_mode(BUF(buf), blocking); }
+int IIOContextRaw::bufferPollFd(Buffer buf) { return iio_buffer_get_poll_fd(BUF(buf)); }
+ssize_t IIOContextRaw::bufferRefill(Buffer buf) { return iio_buffer_refill(BUF(buf)); }
+ssize_t IIOContextRaw::bufferPush(Buffer buf, size_t samples_count) { return iio_buffer_push_partial(BUF(buf), samples_count); }
+void *IIOContextRaw::bufferStart(Buffer buf) { return iio_buffer_start(BUF(buf)); }
+void *IIOContextRaw::bufferEnd(Buffer buf) { return iio_buffer_end(BUF(buf)); }
+ptrdiff_t IIOContextRaw::bufferStep(Buffer buf) { return iio_buffer_step(BUF(buf)); }
+void *IIOContextRaw::bufferFirst(Buffer buf, Channel chn) { return iio_buffer_first(BUF(buf), CHN(chn)); }
+
+/***********************************************************************
+ * Backend selection
+ **********************************************************************/
+IIOBackend::~IIOBackend(void) {}
+
+std::shared_ptr<IIOBackend> IIOBackend::make(const std::string &uri)
+{
+    const std::string loopbackPrefix("loopback:");
+    if (uri.empty()) return std::make_shared<IIOContextRaw>();
+    if (uri.compare(0, loopbackPrefix.size(), loopbackPrefix) == 0)
+    {
+        return std::make_shared<IIOLoopback>(uri.substr(loopbackPrefix.size()));
+    }
+    return std::make_shared<IIOContextRaw>(uri);
+}
+
+/***********************************************************************
+ * Wrappers
+ **********************************************************************/
+IIOContext::IIOContext(void)
+{
+    const char *uri = std::getenv("POTHOS_IIO_URI");
+    this->uri = uri ? uri : "";
+    this->ctx = IIOBackend::make(this->uri);
+    this->lastRescan = std::chrono::steady_clock::now();
+    this->rescans = 0;
+    this->rescanning = false;
+}
+
+IIOContext::IIOContext(const std::string &uri)
+    : uri(uri), ctx(IIOBackend::make(uri)), lastRescan(std::chrono::steady_clock::now()),
+      rescans(0), rescanning(false) {}
+
+IIOContext::~IIOContext(void)
+{
+    if (this->rescanThread.joinable()) this->rescanThread.join();
+}
+
+std::shared_ptr<IIOBackend> IIOContext::backend(void)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->ctx;
+}
+
+bool IIOContext::rescan(const std::chrono::milliseconds &minInterval)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        const auto now = std::chrono::steady_clock::now();
+        if (now - this->lastRescan < minInterval) return false;
+        this->lastRescan = now;
+    }
+
+    //create the new context without holding the lock,
+    //since a remote context may take a while to connect
+    auto ctx = IIOBackend::make(this->uri);
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->ctx = ctx;
+    this->rescans++;
+    return true;
+}
+
+bool IIOContext::rescanAsync(const std::chrono::milliseconds &minInterval)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    const auto now = std::chrono::steady_clock::now();
+    if (this->rescanning || now - this->lastRescan < minInterval) return false;
+    this->lastRescan = now;
+    this->rescanning = true;
+
+    //the previous thread has finished, since it cleared rescanning
+    if (this->rescanThread.joinable()) this->rescanThread.join();
+    this->rescanThread = std::thread([this](void)
+    {
+        std::shared_ptr<IIOBackend> ctx;
+        try
+        {
+            ctx = IIOBackend::make(this->uri);
+        }
+        catch (const Pothos::Exception &)
+        {
+            //keep the current context, the next rescan retries
+        }
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (ctx)
+        {
+            this->ctx = ctx;
+            this->rescans++;
+        }
+        this->rescanning = false;
+    });
+    return true;
+}
+
+unsigned long long IIOContext::generation(void)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->rescans;
+}
 
 IIOContext& IIOContext::get()
 {
@@ -35,7 +217,7 @@ std::string IIOContext::version(void)
     unsigned int major, minor;
     char git_tag[8];
 
-    ret = iio_context_get_version(this->ctx->raw_ptr, &major, &minor, git_tag);
+    ret = this->backend()->version(&major, &minor, git_tag);
     if (ret)
     {
         throw Pothos::SystemException("IIOContext::getVersion()", "iio_context_get_version: " + Poco::Error::getMessage(-ret));
@@ -45,22 +227,23 @@ std::string IIOContext::version(void)
 
 std::string IIOContext::name(void)
 {
-    return std::string(iio_context_get_name(this->ctx->raw_ptr));
+    return std::string(this->backend()->name());
 }
 
 std::string IIOContext::description(void)
 {
-    return std::string(iio_context_get_description(this->ctx->raw_ptr));
+    return std::string(this->backend()->description());
 }
 
 std::vector<IIODevice> IIOContext::devices(void)
 {
-    auto device_count = iio_context_get_devices_count(this->ctx->raw_ptr);
+    auto ctx = this->backend();
+    auto device_count = ctx->devicesCount();
     std::vector<IIODevice> d;
     for (unsigned int i = 0; i < device_count; ++i) {
-        struct iio_device *device = iio_context_get_device(this->ctx->raw_ptr, i);
+        auto device = ctx->device(i);
         assert(device);
-        d.push_back(IIODevice(this->ctx, device));
+        d.push_back(IIODevice(ctx, device));
     }
     return d;
 }
@@ -165,37 +348,37 @@ template class IIOAttr<IIODevice>;
 template class IIOAttrs<IIOChannel>;
 template class IIOAttrs<IIODevice>;
 
-IIODevice::IIODevice(std::shared_ptr<IIOContextRaw> ctx, const struct iio_device *device)
+IIODevice::IIODevice(std::shared_ptr<IIOBackend> ctx, IIOBackend::Device device)
     : ctx(ctx), device(device) {}
 
 const char * IIODevice::iio_get_attr(unsigned int idx) const
 {
-    return iio_device_get_attr(this->device, idx);
+    return this->ctx->deviceAttr(this->device, idx);
 }
 
 unsigned int IIODevice::iio_get_attrs_count() const
 {
-    return iio_device_get_attrs_count(this->device);
+    return this->ctx->deviceAttrsCount(this->device);
 }
 
 ssize_t IIODevice::iio_attr_read(const char *attr, char *dst, size_t len) const
 {
-    return iio_device_attr_read(this->device, attr, dst, len);
+    return this->ctx->deviceAttrRead(this->device, attr, dst, len);
 }
 
 ssize_t IIODevice::iio_attr_write(const char *attr, const char *src) const
 {
-    return iio_device_attr_write(this->device, attr, src);
+    return this->ctx->deviceAttrWrite(this->device, attr, src);
 }
 
 std::string IIODevice::id(void)
 {
-    return std::string(iio_device_get_id(this->device));
+    return std::string(this->ctx->deviceId(this->device));
 }
 
 std::string IIODevice::name(void)
 {
-    const char *name = iio_device_get_name(this->device);
+    const char *name = this->ctx->deviceName(this->device);
     if (!name) {
         name = "<unnamed>";
     }
@@ -209,10 +392,10 @@ IIOAttrs<IIODevice> IIODevice::attributes(void)
 
 std::vector<IIOChannel> IIODevice::channels(void)
 {
-    auto channel_count = iio_device_get_channels_count(this->device);
+    auto channel_count = this->ctx->channelsCount(this->device);
     std::vector<IIOChannel> c;
     for (unsigned int i = 0; i < channel_count; ++i) {
-        struct iio_channel *channel = iio_device_get_channel(this->device, i);
+        auto channel = this->ctx->channel(this->device, i);
         assert(channel);
         c.push_back(IIOChannel(this->ctx, channel));
     }
@@ -221,8 +404,8 @@ std::vector<IIOChannel> IIODevice::channels(void)
 
 IIODevice IIODevice::trigger(void)
 {
-    const struct iio_device *trigger;
-    int ret = iio_device_get_trigger(this->device, &trigger);
+    IIOBackend::Device trigger;
+    int ret = this->ctx->deviceTrigger(this->device, &trigger);
     if (ret)
     {
         throw Pothos::SystemException("IIODevice::trigger()", "iio_device_get_trigger: " + Poco::Error::getMessage(-ret));
@@ -237,7 +420,7 @@ IIODevice IIODevice::trigger(void)
 
 void IIODevice::setTrigger(IIODevice *trigger)
 {
-    int ret = iio_device_set_trigger(this->device, trigger->device);
+    int ret = this->ctx->setDeviceTrigger(this->device, trigger ? trigger->device : nullptr);
     if (ret)
     {
         throw Pothos::SystemException("IIODevice::setTrigger()", "iio_device_set_trigger: " + Poco::Error::getMessage(-ret));
@@ -246,58 +429,92 @@ void IIODevice::setTrigger(IIODevice *trigger)
 
 bool IIODevice::isTrigger(void)
 {
-    return iio_device_is_trigger(this->device);
+    return this->ctx->deviceIsTrigger(this->device);
+}
+
+bool IIODevice::isPresent(void)
+{
+    #ifdef __linux__
+    if (std::string(this->ctx->name()) != "local") return true;
+    struct stat st;
+    return stat(("/sys/bus/iio/devices/" + this->id()).c_str(), &st) == 0;
+    #else
+    return true;
+    #endif
 }
 
 void IIODevice::setKernelBuffersCount(unsigned int nb_buffers)
 {
-    int ret = iio_device_set_kernel_buffers_count(this->device, nb_buffers);
+    int ret = this->ctx->setKernelBuffersCount(this->device, nb_buffers);
     if (ret)
     {
         throw Pothos::SystemException("IIODevice::setKernelBuffersCount()", "iio_device_set_kernel_buffers_count: " + Poco::Error::getMessage(-ret));
     }
 }
 
+size_t IIODevice::scanSize(bool enabledOnly)
+{
+    //same layout rule as the kernel: each sample is aligned to its own size
+    //and the scan is padded to a multiple of the largest sample
+    std::vector<IIOChannel> scanElements;
+    for (auto c : this->channels())
+    {
+        if (c.isScanElement() && (!enabledOnly || c.isEnabled())) scanElements.push_back(c);
+    }
+    std::stable_sort(scanElements.begin(), scanElements.end(),
+        [](IIOChannel a, IIOChannel b){ return a.index() < b.index(); });
+
+    size_t size = 0, maxAlign = 1;
+    for (auto c : scanElements)
+    {
+        const auto &fmt = c.format();
+        const size_t align = std::max<size_t>(fmt.length/8, 1);
+        size = (size + align - 1)/align*align + iioFormatBytes(fmt);
+        maxAlign = std::max(maxAlign, align);
+    }
+    return (size + maxAlign - 1)/maxAlign*maxAlign;
+}
+
 IIOBuffer IIODevice::createBuffer(size_t samples_count, bool cyclic)
 {
     return IIOBuffer(this->ctx, this, samples_count, cyclic);
 }
 
-IIOChannel::IIOChannel(std::shared_ptr<IIOContextRaw> ctx, struct iio_channel *channel) : ctx(ctx), channel(channel) {}
+IIOChannel::IIOChannel(std::shared_ptr<IIOBackend> ctx, IIOBackend::Channel channel) : ctx(ctx), channel(channel) {}
 
 const char * IIOChannel::iio_get_attr(unsigned int idx) const
 {
-    return iio_channel_get_attr(this->channel, idx);
+    return this->ctx->channelAttr(this->channel, idx);
 }
 
 unsigned int IIOChannel::iio_get_attrs_count() const
 {
-    return iio_channel_get_attrs_count(this->channel);
+    return this->ctx->channelAttrsCount(this->channel);
 }
 
 ssize_t IIOChannel::iio_attr_read(const char *attr, char *dst, size_t len) const
 {
-    return iio_channel_attr_read(this->channel, attr, dst, len);
+    return this->ctx->channelAttrRead(this->channel, attr, dst, len);
 }
 
 ssize_t IIOChannel::iio_attr_write(const char *attr, const char *src) const
 {
-    return iio_channel_attr_write(this->channel, attr, src);
+    return this->ctx->channelAttrWrite(this->channel, attr, src);
 }
 
 IIODevice IIOChannel::device(void)
 {
-    return IIODevice(this->ctx, iio_channel_get_device(this->channel));
+    return IIODevice(this->ctx, this->ctx->channelDevice(this->channel));
 }
 
 std::string IIOChannel::id(void)
 {
-    return std::string(iio_channel_get_id(this->channel));
+    return std::string(this->ctx->channelId(this->channel));
 }
 
 std::string IIOChannel::name(void)
 {
-    const char *name = iio_channel_get_name(this->channel);
+    const char *name = this->ctx->channelName(this->channel);
     if (!name) {
         name = "<unnamed>";
     }
@@ -311,81 +528,170 @@ IIOAttrs<IIOChannel> IIOChannel::attributes(void)
 
 void IIOChannel::enable(void)
 {
-    iio_channel_enable(this->channel);
+    this->ctx->channelEnable(this->channel);
 }
 
 void IIOChannel::disable(void)
 {
-    iio_channel_disable(this->channel);
+    this->ctx->channelDisable(this->channel);
 }
 
 bool IIOChannel::isEnabled(void)
 {
-    return iio_channel_is_enabled(this->channel);
+    return this->ctx->channelIsEnabled(this->channel);
 }
 
 bool IIOChannel::isOutput(void)
 {
-    return iio_channel_is_output(this->channel);
+    return this->ctx->channelIsOutput(this->channel);
 }
 
 bool IIOChannel::isScanElement(void)
 {
-    return iio_channel_is_scan_element(this->channel);
+    return this->ctx->channelIsScanElement(this->channel);
 }
 
 size_t IIOChannel::read(IIOBuffer &buffer, void *dst, size_t sample_count)
 {
-    const struct iio_data_format *format = iio_channel_get_data_format(this->channel);
-    size_t len = sample_count * format->length;
-    return iio_channel_read(this->channel, buffer.buffer, dst, len);
+    size_t len = sample_count * iioFormatBytes(this->format());
+    return this->ctx->channelRead(this->channel, buffer.buffer, dst, len);
 }
 
 size_t IIOChannel::write(IIOBuffer &buffer, void *dst, size_t sample_count)
 {
-    const struct iio_data_format *format = iio_channel_get_data_format(this->channel);
-    size_t len = sample_count * (format->length / 8);
-    return iio_channel_write(this->channel, buffer.buffer, dst, len);
+    size_t len = sample_count * iioFormatBytes(this->format());
+    return this->ctx->channelWrite(this->channel, buffer.buffer, dst, len);
+}
+
+long IIOChannel::index(void)
+{
+    return this->ctx->channelIndex(this->channel);
+}
+
+const struct iio_data_format &IIOChannel::format(void)
+{
+    return *this->ctx->channelFormat(this->channel);
 }
 
 Pothos::DType IIOChannel::dtype(void)
 {
-    const struct iio_data_format *format = iio_channel_get_data_format(this->channel);
+    return iioFormatDType(*this->ctx->channelFormat(this->channel));
+}
 
-    switch(format->length) {
+Pothos::DType iioFormatDType(const struct iio_data_format &format)
+{
+    switch(format.length) {
         case 8:
-            if (format->is_signed) {
+            if (format.is_signed) {
                 return Pothos::DType(typeid(int8_t));
             } else {
                 return Pothos::DType(typeid(uint8_t));
             }
         case 16:
-            if (format->is_signed) {
+            if (format.is_signed) {
                 return Pothos::DType(typeid(int16_t));
             } else {
                 return Pothos::DType(typeid(uint16_t));
             }
         case 32:
-            if (format->is_signed) {
+            if (format.is_signed) {
                 return Pothos::DType(typeid(int32_t));
             } else {
                 return Pothos::DType(typeid(uint32_t));
             }
         case 64:
-            if (format->is_signed) {
+            if (format.is_signed) {
                 return Pothos::DType(typeid(int64_t));
             } else {
                 return Pothos::DType(typeid(uint64_t));
             }
         default:
-            return Pothos::DType(typeid(char), format->length / 8);
+            return Pothos::DType(typeid(char), format.length / 8);
+    }
+}
+
+std::vector<size_t> iioFindIQPairs(std::vector<IIOChannel> &channels, const std::vector<std::string> &channelIds)
+{
+    std::vector<size_t> pairs(channels.size(), channels.size());
+    for (size_t i = 0; i < channels.size(); i++)
+    {
+        const auto id = channels[i].id();
+        if (id.size() < 3 || id.compare(id.size() - 2, 2, "_i") != 0) continue;
+        if (std::find(channelIds.begin(), channelIds.end(), iioIQPairName(id)) == channelIds.end()) continue;
+        for (size_t q = 0; q < channels.size(); q++)
+        {
+            if (channels[q].id() != iioIQPairName(id) + "_q") continue;
+            auto &ci = channels[i];
+            auto &cq = channels[q];
+            if (!ci.isScanElement() || !cq.isScanElement() || ci.isOutput() != cq.isOutput()) continue;
+
+            //equal formats, so that the Q sample is aligned right after the I sample
+            const auto &fi = ci.format();
+            const auto &fq = cq.format();
+            if (cq.index() != ci.index() + 1 || fi.repeat > 1 || fq.repeat > 1) continue;
+            if (fi.length != fq.length || fi.bits != fq.bits || fi.shift != fq.shift ||
+                fi.is_signed != fq.is_signed || fi.is_be != fq.is_be) continue;
+            if (fi.length != 8 && fi.length != 16 && fi.length != 32 && fi.length != 64) continue;
+            pairs[i] = q;
+            pairs[q] = i;
+        }
+    }
+    return pairs;
+}
+
+bool iioChannelSelected(const std::string &id, const std::vector<std::string> &channelIds)
+{
+    if (channelIds.empty()) return true;
+    if (std::find(channelIds.begin(), channelIds.end(), id) != channelIds.end()) return true;
+    const bool iq = id.size() >= 3 && (id.compare(id.size() - 2, 2, "_i") == 0 || id.compare(id.size() - 2, 2, "_q") == 0);
+    return iq && std::find(channelIds.begin(), channelIds.end(), iioIQPairName(id)) != channelIds.end();
+}
+
+std::string iioIQPairName(const std::string &id)
+{
+    return id.substr(0, id.size() - 2);
+}
+
+struct iio_data_format iioIQPairFormat(const struct iio_data_format &format)
+{
+    auto pairFormat = format;
+    pairFormat.repeat = 2;
+    return pairFormat;
+}
+
+Pothos::DType iioIQPairDType(const struct iio_data_format &format)
+{
+    return Pothos::DType("complex_" + iioFormatDType(format).name());
+}
+
+IIOCorrection iioCorrectionFromKwargs(const Pothos::ObjectKwargs &params, const bool iq)
+{
+    double offsetI = 0.0, offsetQ = 0.0, gain = 1.0, amplitude = 1.0, phase = 0.0;
+    for (const auto &entry : params)
+    {
+        const auto value = entry.second.convert<double>();
+        if (entry.first == "offset") offsetI = value;
+        else if (entry.first == "gain") gain = value;
+        else if (iq && entry.first == "offsetQ") offsetQ = value;
+        else if (iq && entry.first == "amplitude") amplitude = value;
+        else if (iq && entry.first == "phase") phase = value;
+        else throw Pothos::InvalidArgumentException("iioCorrectionFromKwargs()", "unknown correction: " + entry.first);
+    }
+    if (!std::isfinite(offsetI) || !std::isfinite(offsetQ) || !std::isfinite(gain))
+    {
+        throw Pothos::InvalidArgumentException("iioCorrectionFromKwargs()", "offset and gain must be finite");
     }
+    if (!(amplitude > 0.0) || !std::isfinite(amplitude) || !(std::abs(phase) < 90.0))
+    {
+        throw Pothos::InvalidArgumentException("iioCorrectionFromKwargs()", "amplitude must be positive and phase within +/-90 degrees");
+    }
+    return iioCorrection(gain, offsetI, offsetQ, iq, amplitude, phase);
 }
 
-IIOBuffer::IIOBuffer(std::shared_ptr<IIOContextRaw> ctx, IIODevice *device, size_t samples_count, bool cyclic)
+IIOBuffer::IIOBuffer(std::shared_ptr<IIOBackend> ctx, IIODevice *device, size_t samples_count, bool cyclic)
     : ctx(ctx)
 {
-    this->buffer = iio_device_create_buffer(device->device, samples_count, cyclic);
+    this->buffer = this->ctx->createBuffer(device->device, samples_count, cyclic);
     if (!this->buffer)
     {
         throw Pothos::SystemException("IIOBuffer::IIOBuffer()", "iio_device_create_buffer: " + Poco::Error::getMessage(Poco::Error::last()));
@@ -402,18 +708,18 @@ IIOBuffer::IIOBuffer(IIOBuffer&& other)
 IIOBuffer::~IIOBuffer(void)
 {
     if (this->buffer) {
-        iio_buffer_destroy(this->buffer);
+        this->ctx->bufferDestroy(this->buffer);
     }
 }
 
 IIODevice IIOBuffer::device(void)
 {
-    return IIODevice(this->ctx, iio_buffer_get_device(this->buffer));
+    return IIODevice(this->ctx, this->ctx->bufferDevice(this->buffer));
 }
 
 void IIOBuffer::setBlockingMode(bool blocking)
 {
-    int ret = iio_buffer_set_blocking_mode(this->buffer, blocking);
+    int ret = this->ctx->bufferSetBlockingMode(this->buffer, blocking);
     if (ret)
     {
         throw Pothos::SystemException("IIOBuffer::setBlockingMode()", "iio_buffer_set_blocking_mode: " + Poco::Error::getMessage(-ret));
@@ -422,7 +728,7 @@ void IIOBuffer::setBlockingMode(bool blocking)
 
 int IIOBuffer::fd(void)
 {
-    int ret = iio_buffer_get_poll_fd(this->buffer);
+    int ret = this->ctx->bufferPollFd(this->buffer);
     if (ret < 0)
     {
         throw Pothos::SystemException("IIOBuffer::fd()", "iio_buffer_get_poll_fd: " + Poco::Error::getMessage(-ret));
@@ -432,35 +738,86 @@ int IIOBuffer::fd(void)
 
 size_t IIOBuffer::refill(void)
 {
-    ssize_t ret = iio_buffer_refill(this->buffer);
+    ssize_t ret = this->ctx->bufferRefill(this->buffer);
     if (ret < 0)
     {
-        throw Pothos::SystemException("IIOBuffer::refill()", "iio_buffer_refill: " + Poco::Error::getMessage(-ret));
+        throw Pothos::SystemException("IIOBuffer::refill()", "iio_buffer_refill: " + Poco::Error::getMessage(-ret), int(-ret));
     }
     return (size_t)ret;
 }
 
 size_t IIOBuffer::push(size_t samples_count)
 {
-    ssize_t ret = iio_buffer_push_partial(this->buffer, samples_count);
+    ssize_t ret = this->ctx->bufferPush(this->buffer, samples_count);
     if (ret < 0)
     {
-        throw Pothos::SystemException("IIOBuffer::push()", "iio_buffer_push_partial: " + Poco::Error::getMessage(-ret));
+        throw Pothos::SystemException("IIOBuffer::push()", "iio_buffer_push_partial: " + Poco::Error::getMessage(-ret), int(-ret));
     }
     return (size_t)ret;
 }
 
 void * IIOBuffer::start(void)
 {
-    return iio_buffer_start(this->buffer);
+    return this->ctx->bufferStart(this->buffer);
 }
 
 void * IIOBuffer::end(void)
 {
-    return iio_buffer_end(this->buffer);
+    return this->ctx->bufferEnd(this->buffer);
 }
 
 ptrdiff_t IIOBuffer::step(void)
 {
-    return iio_buffer_step(this->buffer);
+    return this->ctx->bufferStep(this->buffer);
+}
+
+void * IIOBuffer::first(IIOChannel &channel)
+{
+    return this->ctx->bufferFirst(this->buffer, channel.channel);
+}
+
+bool iioIsDeviceGone(int error)
+{
+    switch (error)
+    {
+    //the device was unregistered, or its descriptor closed under us
+    case ENODEV:
+    case ENXIO:
+    case EBADF:
+    //the connection to a remote context was lost
+    case EPIPE:
+    case ECONNRESET:
+    case ENOTCONN:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int iioOpenEventFd(const std::string &deviceId)
+{
+    #ifdef __linux__
+    const std::string path = "/dev/" + deviceId;
+    int devFd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (devFd < 0 && errno == EBUSY) return -1;
+    if (devFd < 0)
+    {
+        throw Pothos::SystemException("iioOpenEventFd()", "open " + path + ": " + Poco::Error::getMessage(errno));
+    }
+
+    //the event descriptor outlives the character device descriptor
+    int eventFd = -1;
+    int ret = ioctl(devFd, IIO_GET_EVENT_FD_IOCTL, &eventFd);
+    const int err = errno;
+    close(devFd);
+    if (ret < 0 && err == EBUSY) return -1;
+    if (ret < 0 || eventFd < 0)
+    {
+        throw Pothos::SystemException("iioOpenEventFd()", deviceId + " has no event interface: " + Poco::Error::getMessage(err));
+    }
+    fcntl(eventFd, F_SETFL, fcntl(eventFd, F_GETFL) | O_NONBLOCK);
+    return eventFd;
+    #else
+    throw Pothos::NotImplementedException("iioOpenEventFd()", "IIO events require Linux");
+    #endif
 }
@@ -1,9 +1,13 @@
 // Copyright (c) 2016 Fiach Antaw
 // SPDX-License-Identifier: BSL-1.0
 
+#pragma once
 #include <Pothos/Framework.hpp>
 #include <iio.h>
+#include <chrono>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <Poco/SingletonHolder.h>
 #include <string>
 #include <vector>
@@ -16,35 +20,181 @@ class IIOChannel;
 class IIODevice;
 
 /*!
- * IIOContextRaw contains a raw iio_context pointer, which it destroys
- * automatically when it's destructor is called.
+ * IIOBackend is the interface between the IIO wrapper classes and the
+ * implementation providing devices, channels and buffers.
+ *
+ * The methods mirror the libiio C API: objects are referred to by opaque
+ * handles, failures are reported as negative errno values (or a null handle
+ * with errno set), and the wrapper classes turn them into exceptions.
  */
-class IIOContextRaw
+class IIOBackend
+{
+public:
+    typedef const void *Device;
+    typedef const void *Channel;
+    typedef void *Buffer;
+
+    /*!
+     * Create a backend for a URI. An empty URI selects the local libiio
+     * context, "loopback:file" selects an IIOLoopback described by the given
+     * JSON or XML file, and any other URI is passed to libiio.
+     */
+    static std::shared_ptr<IIOBackend> make(const std::string &uri);
+
+    virtual ~IIOBackend(void);
+
+    //context
+    virtual int version(unsigned int *major, unsigned int *minor, char git_tag[8]) = 0;
+    virtual const char *name(void) = 0;
+    virtual const char *description(void) = 0;
+    virtual unsigned int devicesCount(void) = 0;
+    virtual Device device(unsigned int idx) = 0;
+
+    //devices
+    virtual const char *deviceId(Device dev) = 0;
+    virtual const char *deviceName(Device dev) = 0;
+    virtual unsigned int deviceAttrsCount(Device dev) = 0;
+    virtual const char *deviceAttr(Device dev, unsigned int idx) = 0;
+    virtual ssize_t deviceAttrRead(Device dev, const char *attr, char *dst, size_t len) = 0;
+    virtual ssize_t deviceAttrWrite(Device dev, const char *attr, const char *src) = 0;
+    virtual unsigned int channelsCount(Device dev) = 0;
+    virtual Channel channel(Device dev, unsigned int idx) = 0;
+    virtual int deviceTrigger(Device dev, Device *trigger) = 0;
+    virtual int setDeviceTrigger(Device dev, Device trigger) = 0;
+    virtual bool deviceIsTrigger(Device dev) = 0;
+    virtual int setKernelBuffersCount(Device dev, unsigned int nb_buffers) = 0;
+    virtual Buffer createBuffer(Device dev, size_t samples_count, bool cyclic) = 0;
+
+    //channels
+    virtual Device channelDevice(Channel chn) = 0;
+    virtual const char *channelId(Channel chn) = 0;
+    virtual const char *channelName(Channel chn) = 0;
+    virtual unsigned int channelAttrsCount(Channel chn) = 0;
+    virtual const char *channelAttr(Channel chn, unsigned int idx) = 0;
+    virtual ssize_t channelAttrRead(Channel chn, const char *attr, char *dst, size_t len) = 0;
+    virtual ssize_t channelAttrWrite(Channel chn, const char *attr, const char *src) = 0;
+    virtual void channelEnable(Channel chn) = 0;
+    virtual void channelDisable(Channel chn) = 0;
+    virtual bool channelIsEnabled(Channel chn) = 0;
+    virtual bool channelIsOutput(Channel chn) = 0;
+    virtual bool channelIsScanElement(Channel chn) = 0;
+    virtual long channelIndex(Channel chn) = 0;
+    virtual const struct iio_data_format *channelFormat(Channel chn) = 0;
+    virtual ssize_t channelRead(Channel chn, Buffer buf, void *dst, size_t len) = 0;
+    virtual ssize_t channelWrite(Channel chn, Buffer buf, const void *src, size_t len) = 0;
+
+    //buffers
+    virtual void bufferDestroy(Buffer buf) = 0;
+    virtual Device bufferDevice(Buffer buf) = 0;
+    virtual int bufferSetBlockingMode(Buffer buf, bool blocking) = 0;
+    virtual int bufferPollFd(Buffer buf) = 0;
+    virtual ssize_t bufferRefill(Buffer buf) = 0;
+    virtual ssize_t bufferPush(Buffer buf, size_t samples_count) = 0;
+    virtual void *bufferStart(Buffer buf) = 0;
+    virtual void *bufferEnd(Buffer buf) = 0;
+    virtual ptrdiff_t bufferStep(Buffer buf) = 0;
+    virtual void *bufferFirst(Buffer buf, Channel chn) = 0;
+};
+
+/*!
+ * IIOContextRaw is the libiio implementation of IIOBackend. It contains a
+ * raw iio_context pointer, which it destroys automatically when it's
+ * destructor is called.
+ */
+class IIOContextRaw : public IIOBackend
 {
-    friend class IIOContext;
 private:
     struct iio_context *raw_ptr;
 
-    IIOContextRaw(void);
-
 public:
+    IIOContextRaw(void);
+    IIOContextRaw(const std::string &uri);
     ~IIOContextRaw(void);
+
+    int version(unsigned int *major, unsigned int *minor, char git_tag[8]);
+    const char *name(void);
+    const char *description(void);
+    unsigned int devicesCount(void);
+    Device device(unsigned int idx);
+
+    const char *deviceId(Device dev);
+    const char *deviceName(Device dev);
+    unsigned int deviceAttrsCount(Device dev);
+    const char *deviceAttr(Device dev, unsigned int idx);
+    ssize_t deviceAttrRead(Device dev, const char *attr, char *dst, size_t len);
+    ssize_t deviceAttrWrite(Device dev, const char *attr, const char *src);
+    unsigned int channelsCount(Device dev);
+    Channel channel(Device dev, unsigned int idx);
+    int deviceTrigger(Device dev, Device *trigger);
+    int setDeviceTrigger(Device dev, Device trigger);
+    bool deviceIsTrigger(Device dev);
+    int setKernelBuffersCount(Device dev, unsigned int nb_buffers);
+    Buffer createBuffer(Device dev, size_t samples_count, bool cyclic);
+
+    Device channelDevice(Channel chn);
+    const char *channelId(Channel chn);
+    const char *channelName(Channel chn);
+    unsigned int channelAttrsCount(Channel chn);
+    const char *channelAttr(Channel chn, unsigned int idx);
+    ssize_t channelAttrRead(Channel chn, const char *attr, char *dst, size_t len);
+    ssize_t channelAttrWrite(Channel chn, const char *attr, const char *src);
+    void channelEnable(Channel chn);
+    void channelDisable(Channel chn);
+    bool channelIsEnabled(Channel chn);
+    bool channelIsOutput(Channel chn);
+    bool channelIsScanElement(Channel chn);
+    long channelIndex(Channel chn);
+    const struct iio_data_format *channelFormat(Channel chn);
+    ssize_t channelRead(Channel chn, Buffer buf, void *dst, size_t len);
+    ssize_t channelWrite(Channel chn, Buffer buf, const void *src, size_t len);
+
+    void bufferDestroy(Buffer buf);
+    Device bufferDevice(Buffer buf);
+    int bufferSetBlockingMode(Buffer buf, bool blocking);
+    int bufferPollFd(Buffer buf);
+    ssize_t bufferRefill(Buffer buf);
+    ssize_t bufferPush(Buffer buf, size_t samples_count);
+    void *bufferStart(Buffer buf);
+    void *bufferEnd(Buffer buf);
+    ptrdiff_t bufferStep(Buffer buf);
+    void *bufferFirst(Buffer buf, Channel chn);
 };
 
 /*!
- * IIOContext represents a libiio context object.
+ * IIOContext represents a libiio context object, or a context provided by
+ * another IIOBackend.
  */
 class IIOContext
 {
     friend class Poco::SingletonHolder<IIOContext>;
 private:
-    std::shared_ptr<IIOContextRaw> ctx;
+    std::string uri;
+    std::shared_ptr<IIOBackend> ctx;
+    std::mutex mutex;
+    std::chrono::steady_clock::time_point lastRescan;
+    unsigned long long rescans;
+    bool rescanning;
+    std::thread rescanThread;
 
     IIOContext(void);
 
+    std::shared_ptr<IIOBackend> backend(void);
+
 public:
+    /*!
+     * Create a context for a URI such as "local:", "ip:hostname",
+     * "xml:file.xml" or "loopback:file.json", independent of the global
+     * instance. See IIOBackend::make().
+     */
+    explicit IIOContext(const std::string &uri);
+
+    ~IIOContext(void);
+
     /*!
      * Get the global instance of the IIOContext object.
+     *
+     * The global instance uses the local libiio context, unless the
+     * POTHOS_IIO_URI environment variable names another context URI.
      */
     static IIOContext& get();
 
@@ -68,6 +218,30 @@ public:
      * devices available through this libiio context.
      */
     std::vector<IIODevice> devices(void);
+
+    /*!
+     * Re-create the underlying context so that devices which have been
+     * removed or added since it was created are reflected by devices().
+     * Existing IIODevice objects keep referring to the previous context.
+     * Returns false without rescanning if the context was already rescanned
+     * within minInterval, so that several blocks recovering from the same
+     * event share one rescan. Throws if the context cannot be re-created.
+     */
+    bool rescan(const std::chrono::milliseconds &minInterval = std::chrono::milliseconds(100));
+
+    /*!
+     * Like rescan(), but re-create the context on a background thread and
+     * return at once, so that a block's work() is not held up while a remote
+     * context connects. devices() reflects the rescan once generation() has
+     * advanced. Failures leave the current context in place. Returns false
+     * if a rescan is already running or one started within minInterval.
+     */
+    bool rescanAsync(const std::chrono::milliseconds &minInterval = std::chrono::milliseconds(100));
+
+    /*!
+     * Get the number of times the context has been re-created.
+     */
+    unsigned long long generation(void);
 };
 
 /*!
@@ -161,10 +335,10 @@ class IIODevice
     friend class IIOChannel;
     friend class IIOContext;
 private:
-    std::shared_ptr<IIOContextRaw> ctx;
-    const struct iio_device *device;
+    std::shared_ptr<IIOBackend> ctx;
+    IIOBackend::Device device;
 
-    IIODevice(std::shared_ptr<IIOContextRaw> ctx, const struct iio_device *device);
+    IIODevice(std::shared_ptr<IIOBackend> ctx, IIOBackend::Device device);
 
     const char * iio_get_attr(unsigned int idx) const;
     unsigned int iio_get_attrs_count() const;
@@ -224,11 +398,26 @@ public:
      */
     bool isTrigger(void);
 
+    /*!
+     * Check if this device still exists. A device of the local context that
+     * has been unregistered reports no poll events, so this looks for it in
+     * sysfs; devices of other contexts are assumed present, since losing
+     * them fails the next transfer instead.
+     */
+    bool isPresent(void);
+
     /*!
      * Set the number of kernel buffers to allocate to this device.
      */
     void setKernelBuffersCount(unsigned int nb_buffers);
 
+    /*!
+     * Get the size in bytes of one scan (one sample of every channel) in a
+     * buffer of this device. If enabledOnly is false, the size is computed as
+     * if every scan element were enabled.
+     */
+    size_t scanSize(bool enabledOnly = true);
+
     /*!
      * Create an IIO buffer associated with this device.
      */
@@ -243,10 +432,10 @@ class IIOBuffer {
     friend class IIODevice;
     friend class IIOChannel;
 private:
-    std::shared_ptr<IIOContextRaw> ctx;
-    struct iio_buffer *buffer;
+    std::shared_ptr<IIOBackend> ctx;
+    IIOBackend::Buffer buffer;
 
-    IIOBuffer(std::shared_ptr<IIOContextRaw> ctx, IIODevice *device, size_t samples_count, bool cyclic);
+    IIOBuffer(std::shared_ptr<IIOBackend> ctx, IIODevice *device, size_t samples_count, bool cyclic);
 
 public:
     IIOBuffer(IIOBuffer&&);
@@ -271,7 +460,7 @@ public:
      * Fill the buffer with fresh samples from the owning device.
      *
      * Note that this function is only valid for buffers containing input
-     * channels.
+     * channels. On failure, the exception's code() is the errno value.
      */
     size_t refill(void);
 
@@ -279,7 +468,7 @@ public:
      * Push the buffer to the owning device.
      *
      * Note that this function is only valid for buffers containing output
-     * channels.
+     * channels. On failure, the exception's code() is the errno value.
      */
     size_t push(size_t samples_count);
 
@@ -297,6 +486,11 @@ public:
      * Get the step size between two samples of one channel.
      */
     ptrdiff_t step(void);
+
+    /*!
+     * Get the address of the first sample of the given channel in the buffer.
+     */
+    void* first(IIOChannel &channel);
 };
 
 /*!
@@ -305,12 +499,13 @@ public:
 class IIOChannel {
     friend class IIOAttr<IIOChannel>;
     friend class IIOAttrs<IIOChannel>;
+    friend class IIOBuffer;
     friend class IIODevice;
 private:
-    std::shared_ptr<IIOContextRaw> ctx;
-    struct iio_channel *channel;
+    std::shared_ptr<IIOBackend> ctx;
+    IIOBackend::Channel channel;
 
-    IIOChannel(std::shared_ptr<IIOContextRaw> ctx, struct iio_channel *channel);
+    IIOChannel(std::shared_ptr<IIOBackend> ctx, IIOBackend::Channel channel);
 
     const char * iio_get_attr(unsigned int idx) const;
     unsigned int iio_get_attrs_count() const;
@@ -391,9 +586,87 @@ public:
      */
     size_t write(IIOBuffer &buffer, void *dst, size_t sample_count);
 
+    /*!
+     * Get the scan index of this channel, which orders the channels within a
+     * scan, or a negative number if the channel is not a scan element.
+     */
+    long index(void);
+
+    /*!
+     * Get the format in which this channel's samples are stored in a buffer.
+     */
+    const struct iio_data_format &format(void);
+
     /*!
      * Get the DType of this channel.
      */
     Pothos::DType dtype(void);
 };
 
+/*!
+ * Get the DType that samples of the given format are converted to.
+ */
+Pothos::DType iioFormatDType(const struct iio_data_format &format);
+
+/*!
+ * Find the I/Q pairs among the given channels. A channel "name_i" pairs
+ * with a channel "name_q" (the IDs libiio gives to channels with the I and
+ * Q modifiers) of the same direction and sample format, if the Q sample
+ * directly follows the I sample in a scan, and the pair's name is one of
+ * channelIds. Such a pair reads and writes like a single channel of
+ * complex samples.
+ *
+ * Returns, indexed like channels, the index of the other channel of each
+ * pair, or channels.size() for channels that are not paired.
+ */
+std::vector<size_t> iioFindIQPairs(std::vector<IIOChannel> &channels, const std::vector<std::string> &channelIds);
+
+/*!
+ * Check if a block's list of channel IDs selects a channel: an empty list
+ * selects every channel, and the name of an I/Q pair selects both of its
+ * channels.
+ */
+bool iioChannelSelected(const std::string &id, const std::vector<std::string> &channelIds);
+
+/*!
+ * Get the name of an I/Q pair ("name"), given the ID of its I channel.
+ */
+std::string iioIQPairName(const std::string &id);
+
+/*!
+ * Get the complex sample format of an I/Q pair, given the format of its I
+ * channel: the I and Q samples as one sample repeated twice.
+ */
+struct iio_data_format iioIQPairFormat(const struct iio_data_format &format);
+
+/*!
+ * Get the complex DType that samples of an I/Q pair are converted to.
+ */
+Pothos::DType iioIQPairDType(const struct iio_data_format &format);
+
+struct IIOCorrection;
+
+/*!
+ * Get the correction of one port from a dictionary with the optional keys
+ * "offset", "gain" and, for I/Q pairs, "offsetQ", "amplitude" (of the Q
+ * path relative to the I path) and "phase" (the Q path's error from
+ * quadrature, in degrees). Throws if a key is unknown or a value invalid.
+ */
+IIOCorrection iioCorrectionFromKwargs(const Pothos::ObjectKwargs &params, const bool iq);
+
+
+/*!
+ * Check if the error code of a failed buffer operation means that the device,
+ * or the connection to it, is gone, rather than that the transfer failed.
+ */
+bool iioIsDeviceGone(int error);
+
+/*!
+ * Get a non-blocking event descriptor for a device of the local context.
+ *
+ * The kernel only hands out an event descriptor while the device's character
+ * device is not open elsewhere, so this must be called before a buffer is
+ * created. Returns -1 if the device is busy, and throws if it has no event
+ * interface or the platform does not support IIO events.
+ */
+int iioOpenEventFd(const std::string &deviceId);
@@ -0,0 +1,263 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include "IIOConvert.hpp"
+#include <Pothos/Testing.hpp>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+static struct iio_data_format testFormat(const std::string &type)
+{
+    struct iio_data_format fmt;
+    POTHOS_TEST_TRUE(iioFormatFromString(type, fmt));
+    return fmt;
+}
+
+/***********************************************************************
+ * An identity correction converts like the plain conversion, in both
+ * directions.
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/iio/tests", test_correction_identity)
+{
+    const IIOCorrection c = iioCorrection(1.0, 0.0, 0.0, false, 1.0, 0.0);
+    POTHOS_TEST_TRUE(iioCorrectionIsIdentity(c));
+
+    const auto fmt = testFormat("be:s12/16>>4");
+    const std::vector<int16_t> samples = {0, 1, -1, 2047, -2048, 1000, -1000};
+    std::vector<int16_t> scan(samples.size()), plainScan(samples.size());
+    iioInterleaveCorrect(fmt, samples.data(), c, scan.data(), sizeof(int16_t), samples.size());
+    iioInterleave(fmt, samples.data(), plainScan.data(), sizeof(int16_t), samples.size());
+    POTHOS_TEST_TRUE(scan == plainScan);
+
+    std::vector<int16_t> out(samples.size());
+    iioDeinterleaveCorrect(fmt, scan.data(), sizeof(int16_t), c, out.data(), out.size());
+    POTHOS_TEST_TRUE(out == samples);
+}
+
+/***********************************************************************
+ * Corrected samples saturate at the format's bits rather than at the
+ * width of the sample type, so they never wrap into the other sign.
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/iio/tests", test_correction_saturation)
+{
+    const IIOCorrection c = iioCorrection(4.0, 0.0, 0.0, false, 1.0, 0.0);
+
+    //signed 12 bits: read back through the correcting and plain paths
+    const auto s12 = testFormat("le:s12/16>>0");
+    const std::vector<int16_t> in = {1000, -1000, 100, -100};
+    std::vector<int16_t> scan(in.size()), out(in.size());
+    iioInterleaveCorrect(s12, in.data(), c, scan.data(), sizeof(int16_t), in.size());
+    iioDeinterleave(s12, scan.data(), sizeof(int16_t), out.data(), out.size());
+    POTHOS_TEST_EQUAL(out[0], 2047);
+    POTHOS_TEST_EQUAL(out[1], -2048);
+    POTHOS_TEST_EQUAL(out[2], 400);
+    POTHOS_TEST_EQUAL(out[3], -400);
+    iioInterleave(s12, in.data(), scan.data(), sizeof(int16_t), in.size());
+    iioDeinterleaveCorrect(s12, scan.data(), sizeof(int16_t), c, out.data(), out.size());
+    POTHOS_TEST_EQUAL(out[0], 2047);
+    POTHOS_TEST_EQUAL(out[1], -2048);
+    POTHOS_TEST_EQUAL(out[2], 400);
+    POTHOS_TEST_EQUAL(out[3], -400);
+
+    //unsigned 12 bits with a shift: the offset pulls samples below zero
+    const auto u12 = testFormat("le:u12/16>>4");
+    const IIOCorrection u = iioCorrection(4.0, 100.0, 0.0, false, 1.0, 0.0);
+    const std::vector<uint16_t> uin = {2000, 50, 200};
+    std::vector<uint16_t> uscan(uin.size()), uout(uin.size());
+    iioInterleaveCorrect(u12, uin.data(), u, uscan.data(), sizeof(uint16_t), uin.size());
+    POTHOS_TEST_EQUAL(uscan[0], uint16_t(4095 << 4));
+    POTHOS_TEST_EQUAL(uscan[1], 0);
+    POTHOS_TEST_EQUAL(uscan[2], uint16_t(400 << 4));
+    iioDeinterleaveCorrect(u12, uscan.data(), sizeof(uint16_t), u, uout.data(), uout.size());
+    POTHOS_TEST_EQUAL(uout[0], 4095);
+    POTHOS_TEST_EQUAL(uout[1], 0);
+    POTHOS_TEST_EQUAL(uout[2], 1200);
+}
+
+/***********************************************************************
+ * A device with DC offsets and an I/Q amplitude and phase imbalance
+ * reads and writes E*x + offset in place of x. The correction made for
+ * that device undoes it on reads and pre-distorts against it on writes.
+ **********************************************************************/
+static void iqDevice(const double *x, double *y, const double offsetI, const double offsetQ,
+    const double amplitude, const double phase)
+{
+    const double p = phase*std::atan(1.0)/45.0;
+    y[0] = x[0] + offsetI;
+    y[1] = amplitude*(std::cos(p)*x[1] + std::sin(p)*x[0]) + offsetQ;
+}
+
+POTHOS_TEST_BLOCK("/iio/tests", test_correction_iq_round_trip)
+{
+    const double offsetI = 37.0, offsetQ = -21.0, amplitude = 1.1, phase = 5.0;
+    const IIOCorrection c = iioCorrection(1.0, offsetI, offsetQ, true, amplitude, phase);
+    const auto fmt = testFormat("le:s16/16X2>>0");
+
+    //a tone of complex samples as interleaved I and Q
+    const size_t count = 256;
+    std::vector<int16_t> tone(2*count);
+    for (size_t n = 0; n < count; n++)
+    {
+        const double t = 8.0*std::atan(1.0)*n/64.0;
+        tone[2*n+0] = int16_t(std::lround(10000.0*std::cos(t)));
+        tone[2*n+1] = int16_t(std::lround(10000.0*std::sin(t)));
+    }
+
+    //reading: the device distorts the tone and the correction undoes it
+    std::vector<int16_t> scan(2*count), out(2*count);
+    for (size_t n = 0; n < count; n++)
+    {
+        const double x[2] = {double(tone[2*n+0]), double(tone[2*n+1])};
+        double y[2];
+        iqDevice(x, y, offsetI, offsetQ, amplitude, phase);
+        scan[2*n+0] = int16_t(std::lround(y[0]));
+        scan[2*n+1] = int16_t(std::lround(y[1]));
+    }
+    POTHOS_TEST_EQUAL(iioDeinterleaveCorrect(fmt, scan.data(), 2*sizeof(int16_t), c, out.data(), count), 4*count);
+    for (size_t i = 0; i < 2*count; i++) POTHOS_TEST_CLOSE(out[i], tone[i], 2);
+
+    //writing: the correction pre-distorts the tone and the device undoes it
+    POTHOS_TEST_EQUAL(iioInterleaveCorrect(fmt, tone.data(), c, scan.data(), 2*sizeof(int16_t), count), 4*count);
+    for (size_t n = 0; n < count; n++)
+    {
+        const double x[2] = {double(scan[2*n+0]), double(scan[2*n+1])};
+        double y[2];
+        iqDevice(x, y, offsetI, offsetQ, amplitude, phase);
+        POTHOS_TEST_CLOSE(y[0], tone[2*n+0], 2);
+        POTHOS_TEST_CLOSE(y[1], tone[2*n+1], 2);
+    }
+}
+
+/***********************************************************************
+ * The decimating conversion matches a direct computation of its CIC
+ * filter: the input convolved with order boxcars of factor samples,
+ * taken at the last sample of each block and divided by the gain.
+ **********************************************************************/
+static std::vector<int64_t> cicReference(const std::vector<int64_t> &x, const size_t factor, const size_t order)
+{
+    std::vector<int64_t> h(1, 1);
+    int64_t gain = 1;
+    for (size_t o = 0; o < order; o++)
+    {
+        std::vector<int64_t> next(h.size() + factor - 1, 0);
+        for (size_t i = 0; i < h.size(); i++)
+        {
+            for (size_t j = 0; j < factor; j++) next[i+j] += h[i];
+        }
+        h.swap(next);
+        gain *= int64_t(factor);
+    }
+
+    std::vector<int64_t> y;
+    for (size_t last = factor-1; last < x.size(); last += factor)
+    {
+        int64_t acc = 0;
+        for (size_t k = 0; k < h.size() && k <= last; k++) acc += h[k]*x[last-k];
+        y.push_back(acc/gain);
+    }
+    return y;
+}
+
+static std::vector<int16_t> testSamples(const size_t count, const int range)
+{
+    std::vector<int16_t> x(count);
+    uint32_t state = 1;
+    for (auto &v : x)
+    {
+        state = state*1664525u + 1013904223u;
+        v = int16_t(int(state >> 16) % range - range/2);
+    }
+    return x;
+}
+
+POTHOS_TEST_BLOCK("/iio/tests", test_decimator_reference)
+{
+    for (const size_t order : {1, 3})
+    {
+        //signed samples stored big endian and shifted in the scan
+        const auto fmt = testFormat("be:s12/16>>4");
+        const size_t factor = 5, count = 200;
+        const auto x = testSamples(count, 4096);
+        std::vector<int16_t> scan(count);
+        iioInterleave(fmt, x.data(), scan.data(), sizeof(int16_t), count);
+
+        IIODecimator d(factor, order);
+        std::vector<int16_t> out(count/factor);
+        POTHOS_TEST_EQUAL(iioDeinterleaveDecimate(fmt, scan.data(), sizeof(int16_t), d, out.data(), count), count/factor);
+        const auto ref = cicReference(std::vector<int64_t>(x.begin(), x.end()), factor, order);
+        POTHOS_TEST_EQUAL(ref.size(), out.size());
+        for (size_t i = 0; i < out.size(); i++) POTHOS_TEST_EQUAL(out[i], ref[i]);
+
+        //unsigned samples of the full width
+        const auto ufmt = testFormat("le:u16/16>>0");
+        std::vector<uint16_t> ux(count);
+        for (size_t i = 0; i < count; i++) ux[i] = uint16_t(x[i] + 32768);
+        IIODecimator ud(factor, order);
+        std::vector<uint16_t> uout(count/factor);
+        POTHOS_TEST_EQUAL(iioDeinterleaveDecimate(ufmt, ux.data(), sizeof(uint16_t), ud, uout.data(), count), count/factor);
+        const auto uref = cicReference(std::vector<int64_t>(ux.begin(), ux.end()), factor, order);
+        for (size_t i = 0; i < uout.size(); i++) POTHOS_TEST_EQUAL(uout[i], uref[i]);
+    }
+}
+
+/***********************************************************************
+ * A decimation block that spans two calls, on an I/Q pair, gives the
+ * same outputs as one call over all of the samples.
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/iio/tests", test_decimator_split_calls)
+{
+    const auto fmt = testFormat("le:s16/16X2>>0");
+    const size_t factor = 8, order = 3, count = 100, split = 37;
+    const auto x = testSamples(2*count, 65536);
+    const ptrdiff_t step = 2*sizeof(int16_t);
+
+    IIODecimator whole(factor, order, 2);
+    std::vector<int16_t> expected(2*(count/factor));
+    POTHOS_TEST_EQUAL(iioDeinterleaveDecimate(fmt, x.data(), step, whole, expected.data(), count), count/factor);
+
+    IIODecimator d(factor, order, 2);
+    std::vector<int16_t> out(2*(count/factor));
+    const size_t first = iioDeinterleaveDecimate(fmt, x.data(), step, d, out.data(), split);
+    POTHOS_TEST_EQUAL(first, split/factor);
+    POTHOS_TEST_EQUAL(d.phase, split%factor);
+    const size_t second = iioDeinterleaveDecimate(fmt, x.data() + 2*split, step, d, out.data() + 2*first, count - split);
+    POTHOS_TEST_EQUAL(first + second, count/factor);
+    POTHOS_TEST_TRUE(out == expected);
+
+    //each channel of the pair matches its own reference
+    for (size_t r = 0; r < 2; r++)
+    {
+        std::vector<int64_t> channel;
+        for (size_t i = 0; i < count; i++) channel.push_back(x[2*i+r]);
+        const auto ref = cicReference(channel, factor, order);
+        for (size_t i = 0; i < ref.size(); i++) POTHOS_TEST_EQUAL(out[2*i+r], ref[i]);
+    }
+}
+
+/***********************************************************************
+ * iioDecimatorFits() allows the bit growth of factor^order up to 63 bits,
+ * and a decimator at that bound still reproduces full scale inputs.
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/iio/tests", test_decimator_fits)
+{
+    const auto s16 = testFormat("le:s16/16>>0");
+    POTHOS_TEST_TRUE(iioDecimatorFits(s16, 1, 3));
+    POTHOS_TEST_TRUE(iioDecimatorFits(s16, 1 << 15, 3));
+    POTHOS_TEST_TRUE(!iioDecimatorFits(s16, (1 << 15) + 1, 3));
+    POTHOS_TEST_TRUE(!iioDecimatorFits(s16, 1 << 16, 3));
+    POTHOS_TEST_TRUE(iioDecimatorFits(s16, 3, 23));
+    POTHOS_TEST_TRUE(!iioDecimatorFits(s16, 3, 24));
+    POTHOS_TEST_TRUE(!iioDecimatorFits(testFormat("le:s64/64>>0"), 2, 1));
+
+    //the settled output of constant full scale inputs at the bound
+    const size_t factor = 1 << 15, order = 3, count = 4*factor;
+    for (const int16_t level : {int16_t(32767), int16_t(-32768)})
+    {
+        const std::vector<int16_t> x(count, level);
+        IIODecimator d(factor, order);
+        std::vector<int16_t> out(count/factor);
+        POTHOS_TEST_EQUAL(iioDeinterleaveDecimate(s16, x.data(), sizeof(int16_t), d, out.data(), count), count/factor);
+        POTHOS_TEST_EQUAL(out.back(), level);
+    }
+}
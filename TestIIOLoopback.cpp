@@ -0,0 +1,75 @@
+// Copyright (c) 2026 Pothos IIO contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include "IIOSupport.hpp"
+#include <Pothos/Testing.hpp>
+#include <Poco/TemporaryFile.h>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/***********************************************************************
+ * Round trip through the loopback backend: the input device generates
+ * the documented ramp and the output device accounts for the pushed
+ * bytes in its loopback_samples and loopback_checksum attributes.
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/iio/tests", test_loopback_round_trip)
+{
+    Poco::TemporaryFile contextFile;
+    std::ofstream(contextFile.path()) << R"({"devices": [
+        {"id": "iio:device0", "name": "adc",
+         "channels": [{"id": "voltage0", "format": "le:s16/16>>0"}, {"id": "voltage1", "format": "le:s16/16>>0"}]},
+        {"id": "iio:device1", "name": "dac",
+         "channels": [{"id": "voltage0", "output": true, "format": "le:s16/16>>0"}]}
+    ]})";
+    IIOContext ctx("loopback:" + contextFile.path());
+    auto devices = ctx.devices();
+    POTHOS_TEST_EQUAL(devices.size(), 2);
+
+    //sample n of the k-th enabled channel is n + 4096*k, across refills
+    const size_t numSamples = 64;
+    auto adcChannels = devices[0].channels();
+    for (auto &chn : adcChannels) chn.enable();
+    {
+        IIOBuffer buffer = devices[0].createBuffer(numSamples, false);
+        for (size_t refill = 0; refill < 2; refill++)
+        {
+            buffer.refill();
+            for (size_t k = 0; k < adcChannels.size(); k++)
+            {
+                std::vector<int16_t> samples(numSamples);
+                POTHOS_TEST_EQUAL(adcChannels[k].read(buffer, samples.data(), numSamples), numSamples*sizeof(int16_t));
+                for (size_t n = 0; n < numSamples; n++)
+                {
+                    POTHOS_TEST_EQUAL(samples[n], int16_t(refill*numSamples + n + 4096*k));
+                }
+            }
+        }
+    }
+
+    //the checksum is FNV-1a (64-bit) over the pushed scan bytes
+    auto dacChannel = devices[1].channels().at(0);
+    dacChannel.enable();
+    unsigned long long hash = 14695981039346656037ull;
+    {
+        IIOBuffer buffer = devices[1].createBuffer(numSamples, false);
+        std::vector<int16_t> samples(numSamples);
+        for (size_t n = 0; n < numSamples; n++)
+        {
+            samples[n] = int16_t(1000 - 37*n);
+            const uint16_t bits = uint16_t(samples[n]);
+            for (const uint8_t byte : {uint8_t(bits & 0xff), uint8_t(bits >> 8)})
+            {
+                hash ^= byte;
+                hash *= 1099511628211ull;
+            }
+        }
+        dacChannel.write(buffer, samples.data(), numSamples);
+        POTHOS_TEST_EQUAL(buffer.push(numSamples), numSamples*sizeof(int16_t));
+    }
+
+    auto attrs = devices[1].attributes();
+    POTHOS_TEST_EQUAL(attrs.at("loopback_samples").value(), std::to_string(numSamples));
+    POTHOS_TEST_EQUAL(std::stoull(attrs.at("loopback_checksum").value(), nullptr, 16), hash);
+}